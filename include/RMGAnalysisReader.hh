@@ -16,17 +16,27 @@
 #ifndef _RMG_ANALYSIS_READER_HH_
 #define _RMG_ANALYSIS_READER_HH_
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
 #include <map>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "G4AutoLock.hh"
 #include "G4VAnalysisReader.hh"
 
 #include "RMGConfig.hh"
 
+class RMGLH5Reader;
+
 /**
  * @brief wrapper around @ref G4VAnalysisReader instances with special handling for LH5 files.
  *
+ * @details LH5 tables are read directly from the input file with @ref RMGLH5Reader, all other
+ * formats with the respective @ref G4VAnalysisReader.
+ *
  * @details notes for threadsafe use:
  * - opening/closing can only be performed on the master thread.
  * - in a multithreaded application, all function calls are guarded by a mutex. Worker
@@ -61,57 +71,55 @@ class RMGAnalysisReader final {
          * @brief unlock this access handle before it exits the scope. */
         void unlock() {
           fReader = nullptr;
+          fLH5Reader = nullptr;
           fNtupleId = -1;
           fUnits = nullptr;
           if (fLock) { fLock.unlock(); }
         }
 
         /**
-         * @brief read and discard a number of rows at the current position. */
-        void Seek(size_t offset) {
-          AssertSetup(false);
-          for (size_t i = 0; i < offset; i++) fReader->GetNtupleRow(fNtupleId);
-        }
+         * @brief skip a number of rows at the current position.
+         *
+         * @details this only needs to read the skipped rows for formats without random access,
+         * i.e. not for LH5 files. */
+        void Seek(size_t offset);
+
+        /**
+         * @brief seek to the first row of an event, for tables where events span multiple rows.
+         *
+         * @details the first row of each event has a positive value in the @p count_column, all
+         * other rows have a value of 0. Only available for LH5 files, where the event boundaries
+         * are indexed once from this column. The event is found independently of the rows read
+         * before.
+         *
+         * @return false if not supported by the file format, or if the file has not enough
+         * events. */
+        bool SeekToEvent(size_t event, const std::string& count_column);
 
         /**
          * @brief wraps @c GetNtupleRow() of @ref G4VAnalysisReader. */
-        [[nodiscard]] auto GetNtupleRow() {
-          AssertSetup(false);
-          return fReader->GetNtupleRow(fNtupleId);
-        }
+        [[nodiscard]] G4bool GetNtupleRow();
         /**
          * @brief wraps @c SetNtupleDColumn() of @ref G4VAnalysisReader. */
-        auto SetNtupleDColumn(
+        G4bool SetNtupleDColumn(
             const std::string& name,
             G4double& value,
             const std::vector<std::string>& allowed_units = {}
-        ) {
-          AssertSetup(true);
-          AssertUnit(name, allowed_units);
-          return fReader->SetNtupleDColumn(fNtupleId, name, value);
-        }
+        );
         /**
          * @brief wraps @c SetNtupleFColumn() of @ref G4VAnalysisReader. */
-        auto SetNtupleFColumn(
+        G4bool SetNtupleFColumn(
             const std::string& name,
             G4float& value,
             const std::vector<std::string>& allowed_units = {}
-        ) {
-          AssertSetup(true);
-          AssertUnit(name, allowed_units);
-          return fReader->SetNtupleFColumn(fNtupleId, name, value);
-        }
+        );
         /**
          * @brief wraps @c SetNtupleIColumn() of @ref G4VAnalysisReader. */
-        auto SetNtupleIColumn(
+        G4bool SetNtupleIColumn(
             const std::string& name,
             G4int& value,
             const std::vector<std::string>& allowed_units = {}
-        ) {
-          AssertSetup(true);
-          AssertUnit(name, allowed_units);
-          return fReader->SetNtupleIColumn(fNtupleId, name, value);
-        }
+        );
 
         /**
          * @brief get unit information for the column. an empty string means either no unit
@@ -120,7 +128,9 @@ class RMGAnalysisReader final {
 
         /**
          * @brief check whether this access handle is still valid. */
-        operator bool() const { return fReader != nullptr && fNtupleId >= 0 && fLock; }
+        operator bool() const {
+          return (fReader != nullptr || fLH5Reader != nullptr) && fNtupleId >= 0 && fLock;
+        }
 
       private:
 
@@ -130,21 +140,101 @@ class RMGAnalysisReader final {
             G4VAnalysisReader* reader,
             int nt,
             const std::map<std::string, std::string>* u,
-            bool setup
+            bool setup,
+            RMGLH5Reader* lh5_reader = nullptr
         )
-            : fReader(reader), fNtupleId(nt), fUnits(u), fLock(std::move(lock)), fCanSetup(setup) {};
+            : fReader(reader), fLH5Reader(lh5_reader), fNtupleId(nt), fUnits(u),
+              fLock(std::move(lock)), fCanSetup(setup) {};
         Access(Access&&) = default;
 
         void AssertUnit(const std::string& name, const std::vector<std::string>& allowed_units) const;
         void AssertSetup(bool setup) const;
 
         G4VAnalysisReader* fReader = nullptr;
+        RMGLH5Reader* fLH5Reader = nullptr;
         int fNtupleId = -1;
         const std::map<std::string, std::string>* fUnits;
         G4AutoLock fLock;
         bool fCanSetup = false;
     };
 
+    /**
+     * @brief prefetch layer to read blocks of rows (or events) from a reader, that can then be
+     * consumed by many threads without locking.
+     *
+     * @details a block of items is read by a user-supplied function, with the global reader lock
+     * held only once for the whole block. All threads share the same current block, and claim
+     * items from it by incrementing an atomic cursor. Only when the current block has been claimed
+     * completely, the next block is read. This way, rows are never stranded in the buffer of a
+     * thread that does not process any more events.
+     *
+     * Each thread has to keep its own @ref Handle to the current block, for example as member of a
+     * thread-local object. */
+    template<typename T> class Prefetcher final {
+
+      public:
+
+        struct Block {
+            std::vector<T> items;
+            std::atomic<size_t> next = 0;
+        };
+        using Handle = std::shared_ptr<Block>;
+
+        /**
+         * @brief function to read up to @c n items into the vector, with the reader locked. Reading
+         * no items signals the end of the input. */
+        using FillFunction = std::function<void(Access&, std::vector<T>&, size_t n)>;
+
+        Prefetcher(RMGAnalysisReader* reader, FillFunction fill, size_t block_size = 1000)
+            : fReader(reader), fFill(std::move(fill)), fBlockSize(block_size) {};
+
+        /**
+         * @brief get the next item, or @c nullptr if the input is exhausted.
+         *
+         * @details the returned pointer stays valid until the next call with the same handle. */
+        [[nodiscard]] const T* Next(Handle& local) {
+          while (true) {
+            if (local) {
+              const auto i = local->next.fetch_add(1, std::memory_order_relaxed);
+              if (i < local->items.size()) return &local->items[i];
+            }
+
+            auto reader = fReader->GetLockedReader();
+            if (fCurrent == local) {
+              // the shared block has been claimed completely, read the next one.
+              if (!reader) return nullptr;
+              auto block = std::make_shared<Block>();
+              block->items.reserve(fBlockSize);
+              fFill(reader, block->items, fBlockSize);
+              if (block->items.empty()) return nullptr;
+              fCurrent = std::move(block);
+            }
+            local = fCurrent;
+          }
+        }
+
+        /**
+         * @brief discard all items that have not been claimed yet, e.g. when re-opening a file.
+         * Stale handles of other threads will also not return any more items.
+         *
+         * @details This function can only be used on the master thread, and not while an access
+         * handle is held. */
+        void Reset() {
+          auto lock = fReader->GetLock();
+          if (fCurrent) fCurrent->next = fCurrent->items.size();
+          fCurrent = nullptr;
+        }
+
+        void SetBlockSize(size_t block_size) { fBlockSize = std::max<size_t>(block_size, 1); }
+
+      private:
+
+        RMGAnalysisReader* fReader;
+        FillFunction fFill;
+        size_t fBlockSize;
+        Handle fCurrent;
+    };
+
     RMGAnalysisReader() = default;
     ~RMGAnalysisReader() = default;
 
@@ -186,7 +276,7 @@ class RMGAnalysisReader final {
     );
 
     /**
-     * @brief if any file is open for reading, close the reader. Also clean-up temporary files.
+     * @brief if any file is open for reading, close the reader.
      *
      * @details This function can only be used on the master thread. This operation acquires a global
      * across all readers. This function will not actually free resources allocated for the reader by Geant4. */
@@ -207,18 +297,26 @@ class RMGAnalysisReader final {
      * @brief get the file name of the current open file, or an empty string. */
     [[nodiscard]] auto& GetFileName() const { return fFileName; }
 
+    /**
+     * @brief whether any file has been opened with a @ref G4VAnalysisReader, i.e. any format other
+     * than LH5.
+     *
+     * @details the files of these readers are never closed, so this stays true afterwards. */
+    [[nodiscard]] static bool HasOpenedG4ReaderFile() { return fOpenedG4ReaderFile; }
+
   private:
 
     static G4Mutex fMutex;
+    inline static std::atomic<bool> fOpenedG4ReaderFile = false;
 
     G4VAnalysisReader* fReader = nullptr;
+    std::shared_ptr<RMGLH5Reader> fLH5Reader;
     int fNtupleId = -1;
 
     std::map<std::string, std::string> fUnits;
     bool fHasUnits = false;
 
     std::string fFileName;
-    bool fFileIsTemp = false;
 };
 
 #endif
@@ -53,6 +53,7 @@ class RMGConvertLH5 {
      * @param dry_run If true, the conversion is performed in-memory without writing to disk.
      * @param part_of_batch Indicates if this conversion is part of a batch operation.
      * @param n_ev number of events to write as an additional attribute into the file.
+     * @param event_index If true, write an event index table for each detector table.
      *
      * @return True if the conversion is successful, false otherwise.
      */
@@ -63,7 +64,8 @@ class RMGConvertLH5 {
         const std::map<int, std::pair<int, std::string>>&,
         bool,
         bool part_of_batch = false,
-        int n_ev = -1
+        int n_ev = -1,
+        bool event_index = false
     );
     /**
      * @brief Convert an LH5 input file to HDF5 format.
@@ -89,6 +91,18 @@ class RMGConvertLH5 {
 
     inline static bool fIsStandalone = false;
 
+    /** @brief Name of the group (inside the ntuple group) holding soft links keyed by detector
+     * uid. */
+    inline static const std::string fLinksGroupName = "__by_uid__";
+    /** @brief Name of the scalar dataset holding the number of simulated events. */
+    inline static const std::string fEventNumberName = "number_of_simulated_events";
+    /** @brief Name of the group (inside the ntuple group) holding the event index tables.
+     *
+     * @details For each detector table, the index table of the same name has one row per
+     * event with the columns @c evtid, @c first_row and @c n_rows, pointing to the contiguous
+     * rows of this event in the detector table. */
+    inline static const std::string fIndexGroupName = "__index__";
+
   private:
 
     RMGConvertLH5(
@@ -98,11 +112,12 @@ class RMGConvertLH5 {
         const std::map<int, std::pair<int, std::string>>& ntuple_meta,
         bool dry_run,
         bool part_of_batch,
-        int n_ev
+        int n_ev,
+        bool event_index
     )
         : fHdf5FileName(filename), fNtupleGroupName(ntuple_group), fAuxNtuples(aux_ntuples),
           fNtupleMeta(ntuple_meta), fDryRun(dry_run), fIsPartOfBatch(part_of_batch),
-          fEventCount(n_ev) {};
+          fEventCount(n_ev), fWriteEventIndex(event_index) {};
 
     ////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -133,6 +148,9 @@ class RMGConvertLH5 {
     std::unique_ptr<H5::DataType> FormToHDFDataType(std::string);
     std::string DataTypeToLGDO(H5::DataType);
     bool ConvertNTupleToTable(H5::Group&);
+    bool ReshapeTableToHits(H5::Group&, const std::string&);
+    bool WriteEventIndex(H5::Group&, H5::Group&, const std::string&);
+    template<typename T> void CreateArrayDataset(H5::Group&, std::string, const std::vector<T>&);
 
     bool CheckGeantHeader(H5::Group&);
 
@@ -170,6 +188,7 @@ class RMGConvertLH5 {
     bool fDryRun;
     bool fIsPartOfBatch;
     int fEventCount = -1;
+    bool fWriteEventIndex = false;
 };
 
 #endif
@@ -75,11 +75,16 @@ class RMGDefaultCli {
     bool version_rich = false;
     bool no_banner = false;
     int nthreads = 1;
+    int events_per_task = 0;
+    int ntasks = 0;
+    bool pin_threads = false;
     int rand_seed = -1;
     bool interactive = false;
     bool overwrite_output = false;
     int pipe_fd_out = -1, pipe_fd_in = -1;
     int proc_num_offset = -1;
+    bool dynamic_events = false;
+    std::vector<int> fork_pipe_fds_in;
     std::vector<std::string> gdmls;
     std::vector<std::string> macros;
     std::vector<std::string> macro_substitutions;
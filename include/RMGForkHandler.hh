@@ -0,0 +1,93 @@
+// Copyright (C) 2026
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef _RMG_FORK_HANDLER_HH_
+#define _RMG_FORK_HANDLER_HH_
+
+#include <atomic>
+#include <csignal>
+#include <vector>
+
+#include <sys/types.h>
+
+#include "G4VStateDependent.hh"
+
+/**
+ * @brief forks the process-parallelized instances of remage after initialization.
+ *
+ * @details instead of starting all processes independently, the python wrapper starts only the
+ * first process. Right before its first run starts (i.e. after the geometry has been constructed
+ * and closed, and after the physics tables have been built), this process forks the other
+ * processes. All processes share the memory pages of the initialized application copy-on-write.
+ *
+ * Each forked process gets its own process number, IPC input pipe and random seed. The seeds are
+ * drawn from the random engine of the first process, so they are reproducible if a seed has been
+ * set. The first process waits for all forked processes at the end, and propagates their exit
+ * codes.
+ *
+ * Forking fails if an input file of another format than LH5 has been opened, as the forked
+ * processes would share its file offset.
+ */
+class RMGForkHandler : public G4VStateDependent {
+
+  public:
+
+    /**
+     * @param pipe_fds_in the IPC input pipes of the processes to fork, one per process. The number
+     * of processes is one more than the number of pipes.
+     */
+    RMGForkHandler(std::vector<int> pipe_fds_in) : fPipeFdsIn(std::move(pipe_fds_in)) {}
+    ~RMGForkHandler() override = default;
+
+    RMGForkHandler(RMGForkHandler const&) = delete;
+    RMGForkHandler& operator=(RMGForkHandler const&) = delete;
+    RMGForkHandler(RMGForkHandler&&) = delete;
+    RMGForkHandler& operator=(RMGForkHandler&&) = delete;
+
+    /** @brief Fork the other processes when the first run starts. */
+    G4bool Notify(G4ApplicationState requested_state) override;
+
+    /**
+     * @brief Wait for all forked processes to exit.
+     *
+     * @param exit_code the exit code of this process.
+     * @return the combined exit code of all processes: 1 if any process exited with 1, the
+     * largest exit code otherwise. Processes killed by a signal count as 128 + signal number.
+     */
+    int WaitForForkedProcesses(int exit_code);
+
+  private:
+
+    void Fork();
+    void InstallSignalHandlers();
+
+    static void ForwardSignal(int sig);
+    static void OnChildExit(int sig);
+
+    std::vector<int> fPipeFdsIn;
+    bool fForked = false;
+
+    // the pids are only modified before the signal handlers are installed, the exit codes are
+    // also set from the SIGCHLD handler.
+    inline static std::vector<pid_t> fChildPids;
+    inline static std::vector<std::atomic<int>> fChildExitCodes;
+    inline static struct sigaction fPreviousActions[NSIG];
+
+    static constexpr int kRunning = -1;
+};
+
+#endif
+
+// vim: tabstop=2 shiftwidth=2 expandtab
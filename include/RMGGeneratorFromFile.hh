@@ -17,6 +17,7 @@
 #define _RMG_GENERATOR_FROM_FILE_HH_
 
 #include <memory>
+#include <vector>
 
 #include "CLHEP/Units/SystemOfUnits.h"
 #include "G4GenericMessenger.hh"
@@ -35,7 +36,8 @@ class G4Event;
  * specifies a Geant4 PDG id, kinetic energy, momentum direction and global time. The vertex
  * position is supplied externally by the configured vertex generator via
  * @ref SetParticlePosition. The @c fNpart column allows several consecutive rows to be
- * combined into a single multi-particle primary vertex.
+ * combined into a single multi-particle primary vertex. Complete events are read in blocks that
+ * are shared between all threads (see @ref RMGAnalysisReader::Prefetcher).
  */
 class RMGGeneratorFromFile : public RMGVGenerator {
 
@@ -58,6 +60,8 @@ class RMGGeneratorFromFile : public RMGVGenerator {
     void BeginOfRunAction(const G4Run*) override;
     /** @brief Close the input file. */
     void EndOfRunAction(const G4Run*) override;
+    /** @brief Read the events of a batch of events claimed by this process. */
+    void BeginOfEventBatch(size_t first_event, size_t n_events) override;
 
     /** @brief Set the path of the input ntuple file. */
     void OpenFile(std::string& name);
@@ -87,9 +91,33 @@ class RMGGeneratorFromFile : public RMGVGenerator {
         }
     };
 
+    /** @brief The particles of one event, as read from the file. */
+    struct EventData {
+        std::vector<RowData> particles;
+        bool is_valid = true;          ///< all columns of all rows exist.
+        bool is_valid_particle = true; ///< the particle counts of all rows are consistent.
+        bool is_complete = true;       ///< the file did not end before the last particle.
+    };
+    static void ReadEvents(RMGAnalysisReader::Access&, std::vector<EventData>&, size_t);
+    /** @brief skip a number of events, by reading all of their rows. */
+    static void SkipEvents(RMGAnalysisReader::Access&, size_t);
+
     static RMGAnalysisReader* fReader;
+    static RMGAnalysisReader::Prefetcher<EventData> fPrefetcher;
+    RMGAnalysisReader::Prefetcher<EventData>::Handle fPrefetched;
     inline static RowData fRowData{};
 
+    // the events of the current batch, with dynamic event distribution.
+    inline static size_t fEventsRead = 0;
+    std::vector<EventData> fEventBatch;
+    size_t fEventBatchIndex = 0;
+
+    // the units and columns are only resolved once when opening the file.
+    inline static double fEkinUnit = u::MeV;
+    inline static double fTimeUnit = u::ns;
+    inline static double fPosUnit = u::m;
+    inline static bool fReadPosition = false;
+
     bool fIncludePosition = false;
 
     std::unique_ptr<G4GenericMessenger> fMessenger = nullptr;
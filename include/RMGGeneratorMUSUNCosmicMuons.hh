@@ -17,13 +17,15 @@
 #ifndef _RMG_GENERATOR_MUSUN_COSMIC_MUONS_HH_
 #define _RMG_GENERATOR_MUSUN_COSMIC_MUONS_HH_
 
-#include <filesystem>
+#include <atomic>
+#include <memory>
 
 #include "CLHEP/Units/SystemOfUnits.h"
 #include "G4GenericMessenger.hh"
+#include "G4ParticleDefinition.hh"
 #include "G4ParticleGun.hh"
 
-#include "RMGAnalysisReader.hh"
+#include "RMGMUSUNReader.hh"
 #include "RMGVGenerator.hh"
 #include "RMGVVertexGenerator.hh"
 
@@ -54,9 +56,10 @@ class G4Event;
 /**
  * @brief Primary generator reading pre-sampled cosmic-muon kinematics from a MUSUN file.
  *
- * The input file (an ASCII MUSUN dump) is converted to a temporary Geant4 CSV ntuple at the
- * beginning of the run and read row-by-row by @ref RMGAnalysisReader. Vertex sampling is
- * controlled by the input file, so @ref SetParticlePosition is a no-op.
+ * The input file (an ASCII MUSUN dump) is memory-mapped and indexed at the beginning of the first
+ * run by @ref RMGMUSUNReader. The threads claim rows with an atomic counter and parse them without
+ * locking. Vertex sampling is controlled by the input file, so @ref SetParticlePosition is a
+ * no-op.
  */
 class RMGGeneratorMUSUNCosmicMuons : public RMGVGenerator {
 
@@ -70,37 +73,33 @@ class RMGGeneratorMUSUNCosmicMuons : public RMGVGenerator {
     RMGGeneratorMUSUNCosmicMuons(RMGGeneratorMUSUNCosmicMuons&&) = delete;
     RMGGeneratorMUSUNCosmicMuons& operator=(RMGGeneratorMUSUNCosmicMuons&&) = delete;
 
-    /** @brief Read the next muon entry from the temporary file and shoot it. */
+    /** @brief Read the next muon entry from the input file and shoot it. */
     void GeneratePrimaries(G4Event*) override;
     /** @brief No-op: vertex sampling is fixed by the input MUSUN file. */
     void SetParticlePosition(G4ThreeVector) override{};
 
-    /** @brief Convert the MUSUN ASCII input to Geant4 CSV and open it for reading. */
+    /** @brief Open and index the MUSUN input file, if not already open. */
     void BeginOfRunAction(const G4Run*) override;
-    /** @brief Close the input file and clean up the temporary directory. */
-    void EndOfRunAction(const G4Run*) override;
+    /** @brief Use the rows of a batch of events claimed by this process. */
+    void BeginOfEventBatch(size_t first_event, size_t n_events) override;
 
   private:
 
     void DefineCommands();
     void SetMUSUNFile(G4String pathToFile);
 
-    /**
-     * @return True if the file contains cartesian momentum (fPx, fPy, fPz), or false for spherical
-     * momentum (fPhi, fTheta).
-     */
-    bool PrepareCopy(std::string pathToFile);
-
     std::unique_ptr<G4ParticleGun> fGun = nullptr;
     std::unique_ptr<G4GenericMessenger> fMessenger = nullptr;
     G4String fPathToFile = "";
-    std::filesystem::path fPathToTmpFolder;
-    std::filesystem::path fPathToTmpFile;
 
-    static RMGAnalysisReader* fAnalysisReader;
-    static bool fHasCartesianMomentum;
+    inline static std::unique_ptr<RMGMUSUNReader> fReader = nullptr;
+    inline static std::atomic<size_t> fNextRow = 0;
+    // the rows of the current batch, with dynamic event distribution.
+    size_t fEventBatchNext = 0;
+    size_t fEventBatchEnd = 0;
 
-    static RMGGeneratorMUSUNCosmicMuons_Data* fInputData;
+    inline static G4ParticleDefinition* fMuMinus = nullptr;
+    inline static G4ParticleDefinition* fMuPlus = nullptr;
 };
 
 #endif
@@ -106,7 +106,7 @@ class RMGGermaniumOutputScheme : public RMGVOutputScheme {
       fPreClusterPars.track_energy_threshold = threshold;
     }
 
-    void EndOfRunAction(const G4Run*) override;
+    void EndOfOutputFile() override;
 
   protected:
 
@@ -18,13 +18,14 @@
 #define _RMG_GRABMAYR_GC_READER_HH_
 
 #include <cmath>
-#include <fstream>
-#include <iostream>
+#include <cstdint>
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "G4GenericMessenger.hh"
+#include "G4Threading.hh"
 #include "globals.hh"
 
 // Modified from WLGDPetersGammaCascadeReader originally contributed by Moritz Neuberger
@@ -48,8 +49,10 @@ struct GammaCascadeLine {
  * @brief Thread-local reader of pre-computed (n,gamma) cascade tables.
  *
  * Loads per-isotope cascade files registered through messenger commands and serves them
- * to @ref RMGNeutronCaptureProcess one cascade at a time. The reader is a thread-local
- * singleton: every worker keeps its own file handles and its own read position.
+ * to @ref RMGNeutronCaptureProcess one cascade at a time. Each file is parsed only once per
+ * process into a compact table, that is shared read-only between all threads. Optionally, the
+ * table is cached in a binary file next to the cascade file. The reader is a thread-local
+ * singleton: every worker keeps its own read position in each table.
  */
 class RMGGrabmayrGCReader {
   public:
@@ -61,28 +64,63 @@ class RMGGrabmayrGCReader {
 
     /** @brief Whether a cascade file has been registered for the @c (Z, A) isotope. */
     G4bool IsApplicable(G4int z, G4int a);
-    /** @brief Close all open cascade files held by this thread. */
+    /** @brief Release all cascade tables held by this thread. */
     void CloseFiles();
 
     /**
-     * @brief Read and return the next cascade entry for the @c (Z, A) isotope.
-     * @details The reader cycles back to the beginning when the file is exhausted.
+     * @brief Return the next cascade entry for the @c (Z, A) isotope.
+     * @details The reader cycles back to the beginning when the table is exhausted.
      */
     GammaCascadeLine GetNextEntry(G4int z, G4int a);
 
   private:
 
+    /**
+     * @brief All cascades of one file. The photon energies of cascade @c i are stored in
+     * @c eg[offsets[i]] to @c eg[offsets[i+1]-1].
+     */
+    struct CascadeTable {
+        std::vector<G4int> en;
+        std::vector<G4int> ex;
+        std::vector<G4int> em;
+        std::vector<std::uint32_t> offsets;
+        std::vector<G4int> eg;
+
+        [[nodiscard]] size_t size() const { return en.size(); }
+    };
+
+    struct CascadeFile {
+        std::shared_ptr<const CascadeTable> table;
+        size_t next = 0;
+    };
+
     static G4ThreadLocal RMGGrabmayrGCReader* instance;
     RMGGrabmayrGCReader();
-    // std::vector<std::unique_ptr<std::ifstream>> files;
-    //  map holding the corresponding file for each isotope
-    std::map<std::pair<G4int, G4int>, std::unique_ptr<std::ifstream>> fCascadeFiles;
+    //  map holding the corresponding table and read position for each isotope
+    std::map<std::pair<G4int, G4int>, CascadeFile> fCascadeFiles;
     std::unique_ptr<G4GenericMessenger> fGenericMessenger;
     G4int fGammaCascadeRandomStartLocation = 0;
+    bool fUseBinaryCache = false;
+
+    // the tables of all threads, by file name.
+    static std::map<std::string, std::shared_ptr<const CascadeTable>> fTables;
+    static G4Mutex fTablesMutex;
+
+    static std::shared_ptr<const CascadeTable> LoadTable(const std::string& file_name, bool cache);
+    static std::shared_ptr<CascadeTable> ParseTable(const std::string& file_name);
+    static std::shared_ptr<CascadeTable> ReadBinaryCache(
+        const std::string& cache_name,
+        const std::string& file_name
+    );
+    static void WriteBinaryCache(
+        const CascadeTable& table,
+        const std::string& cache_name,
+        const std::string& file_name
+    );
 
     void SetGammaCascadeFile(G4int z, G4int a, G4String file_name);
     void SetGammaCascadeRandomStartLocation(int answer);
-    void SetStartLocation(std::ifstream& file) const;
+    void SetStartLocation(CascadeFile& file) const;
 
     void RandomizeFiles();
     void DefineCommands();
@@ -24,6 +24,7 @@
 #include <vector>
 
 #include "G4GenericMessenger.hh"
+#include "G4PhysicsFreeVector.hh"
 #include "G4Region.hh"
 #include "G4VUserDetectorConstruction.hh"
 
@@ -171,6 +172,28 @@ class RMGHardware : public G4VUserDetectorConstruction {
      */
     void SetEminLimitForParticle(double ekin_min, std::string name, std::string particle_name);
 
+    /** @brief Set a wavelength-dependent detection efficiency for optical detectors.
+     *
+     * @details The table is read from a text file with two columns, the photon wavelength in nm
+     * and the detection efficiency (between 0 and 1). It takes precedence over a
+     * @c RMG_DETECTIONEFFICIENCY property of the skin surface or the material of the detector
+     * volume.
+     *
+     * @param file_name Path to the efficiency table.
+     * @param name Physical volume name or regex.
+     */
+    void SetOpticalDetectorEfficiency(std::string file_name, std::string name);
+
+    /** @brief Get the detection efficiency of an optical detector as a function of the photon
+     * energy, or @c nullptr if no efficiency should be applied.
+     *
+     * @param uid The unique identifier of the optical detector.
+     */
+    [[nodiscard]] const G4PhysicsVector* GetOpticalDetectorEfficiency(int uid) const {
+      const auto it = fOpticalDetectorEfficiencies.find(uid);
+      return it != fOpticalDetectorEfficiencies.end() ? it->second : nullptr;
+    }
+
     /** @brief Check if selective EkinMin should be applied for the current track context. */
     static bool IsEminLimitParticleSelected(
         const G4LogicalVolume* logical,
@@ -191,6 +214,9 @@ class RMGHardware : public G4VUserDetectorConstruction {
     std::vector<std::string> fGDMLFiles;
     bool fGDMLDisableOverlapCheck = false;
     int fGDMLOverlapCheckNumPoints = 3000;
+    int fGDMLOverlapCheckThreads = 0;
+    std::string fGDMLCheckCacheDir;
+    void CheckGDMLOverlaps();
     bool fGDMLDisableXmlCheck = false;
     /// Mapping between physical volume names and maximum (user) step size to apply
     std::map<std::string, double> fPhysVolStepLimits;
@@ -202,6 +228,15 @@ class RMGHardware : public G4VUserDetectorConstruction {
     std::map<std::string, RMGSelectiveEminLimit> fPhysVolEminLimits;
     static std::unordered_map<const G4LogicalVolume*, std::set<std::string>> fLogicalVolEminParticles;
 
+    /// Mapping between physical volume names and optical detection efficiency table files
+    std::map<std::string, std::string> fPhysVolOpticalEfficiencyFiles;
+    /// Detection efficiency tables read from files, owned by this class
+    std::vector<std::unique_ptr<G4PhysicsFreeVector>> fOpticalEfficiencyTables;
+    /// Mapping between optical detector uids and their detection efficiency
+    std::unordered_map<int, const G4PhysicsVector*> fOpticalDetectorEfficiencies;
+    void SetupOpticalDetectorEfficiencies();
+    static std::unique_ptr<G4PhysicsFreeVector> ReadOpticalEfficiencyFile(const std::string&);
+
     // one element for each sensitive detector physical volume
     std::map<std::pair<std::string, int>, RMGDetectorMetadata> fDetectorMetadata;
 
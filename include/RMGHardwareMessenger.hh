@@ -48,16 +48,21 @@ class RMGHardwareMessenger : public G4UImessenger {
     /** @brief Define the commands to set particle-selective minimum kinetic energy limits. */
     void DefineSelectiveEminLimits();
 
+    /** @brief Define the commands to set the detection efficiency of optical detectors. */
+    void DefineOpticalDetectorEfficiency();
+
   private:
 
     RMGHardware* fHardware;
     G4UIcommand* fRegisterCmd = nullptr;
     G4UIcmdWithADoubleAndUnit* fStepLimitsCmd = nullptr;
     G4UIcommand* fSelectiveEminLimitCmd = nullptr;
+    G4UIcommand* fOpticalEfficiencyCmd = nullptr;
 
     void RegisterDetectorCmd(const std::string& parameters);
     void StepLimitsCmd(const std::string& parameters);
     void SelectiveEminLimitCmd(const std::string& parameters);
+    void OpticalDetectorEfficiencyCmd(const std::string& parameters);
 };
 
 #endif
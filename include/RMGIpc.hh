@@ -16,7 +16,11 @@
 #ifndef _RMG_IPC_HH_
 #define _RMG_IPC_HH_
 
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
 #include <string>
+#include <string_view>
 
 /** @brief IPC message sender implementation.
  *  @details \verbatim embed:rst:leading-asterisk
@@ -45,20 +49,51 @@ class RMGIpc final {
 
     /** @brief Send a non-blocking IPC message.
      *  @details The message is a UTF-8 encoded buffer that already contains the message
-     *  structure, such as @ref CreateMessage.
+     *  structure, such as @ref CreateMessage. It is only appended to the send buffer of this
+     *  process, which is written to the pipe with the next blocking message (i.e. also at the
+     *  boundaries of event batches), when it is full, or with @ref Flush.
      */
-    static bool SendIpcNonBlocking(std::string msg);
+    static bool SendIpcNonBlocking(const std::string& msg);
     /** @brief Send a blocking IPC message.
      *  @details The message is a UTF-8 encoded buffer that already contains the message
      *  structure, such as @ref CreateMessage.
+     *  @param response if not @c nullptr, receives the response data sent before the ACK.
+     */
+    static bool SendIpcBlocking(const std::string& msg, std::string* response = nullptr);
+
+    /** @brief Write all buffered non-blocking messages to the pipe.
+     *  @details This is done automatically at the end of each run, at exit and before aborting.
+     */
+    static bool Flush();
+
+    /** @brief Switch to the IPC input pipe and process number of a forked process.
+     *  @details The output pipe is shared by all processes. No version check is performed.
      */
-    static bool SendIpcBlocking(std::string msg);
+    static void SetupForkedProcess(int ipc_pipe_fd_in, int proc_num);
+
+    /** @brief Whether the IPC pipes are set up, i.e. remage runs under the python wrapper. */
+    static bool IsEnabled() { return fIpcFdOut >= 0; }
 
   private:
 
+    static void AppendFrames(std::string_view msg, uint8_t flags);
+    static bool FlushLocked();
+    static bool Write(const char* data, size_t size);
+
     inline static int fIpcFdOut = -1;
     inline static int fIpcFdIn = -1;
     inline static int fProcNum = -1;
+
+    // the framed messages that still have to be written, shared by all threads of this process.
+    inline static std::string fSendBuffer;
+    inline static std::mutex fSendMutex;
+
+    // frame header: payload size (uint32), process number (uint16), flags (uint8), padding.
+    static constexpr size_t kFrameHeaderSize = 8;
+    static constexpr uint8_t kFlagBlocking = 0x1;
+    static constexpr uint8_t kFlagContinued = 0x2;
+    // the buffer is written to the pipe automatically above this size.
+    static constexpr size_t kSendBufferSize = 64 * 1024;
 };
 
 #endif
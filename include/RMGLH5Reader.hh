@@ -0,0 +1,128 @@
+// Copyright (C) 2026
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef _RMG_LH5_READER_HH_
+#define _RMG_LH5_READER_HH_
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "H5Cpp.h"
+
+/**
+ * @brief row-wise reader for flat LH5 tables, reading directly from the original file.
+ *
+ * @details columns of the table (1D datasets of any numeric type) are bound to variables, like
+ * with @ref G4VAnalysisReader. Blocks of rows are read with hyperslab selections into internal
+ * buffers, and converted to the type of the bound variable by HDF5. Columns that do not exist in
+ * the table are silently not bound.
+ *
+ * This class is not thread-safe, it is only used through the access handles of
+ * @ref RMGAnalysisReader.
+ */
+class RMGLH5Reader final {
+
+  public:
+
+    /**
+     * @brief open the table @c ntuple_dir_name/ntuple_name in an LH5 file.
+     *
+     * @param units output parameter: the @c units attribute of each column, or an empty string.
+     * @return the reader, or @c nullptr if the file or table could not be opened.
+     */
+    static std::unique_ptr<RMGLH5Reader> Open(
+        const std::string& file_name,
+        const std::string& ntuple_dir_name,
+        const std::string& ntuple_name,
+        std::map<std::string, std::string>& units
+    );
+
+    RMGLH5Reader(RMGLH5Reader const&) = delete;
+    RMGLH5Reader& operator=(RMGLH5Reader const&) = delete;
+    RMGLH5Reader(RMGLH5Reader&&) = delete;
+    RMGLH5Reader& operator=(RMGLH5Reader&&) = delete;
+
+    /** @brief bind a column to a variable. Returns false if the column does not exist. */
+    bool SetColumn(const std::string& name, double& value);
+    /** @overload */
+    bool SetColumn(const std::string& name, float& value);
+    /** @overload */
+    bool SetColumn(const std::string& name, int& value);
+
+    /** @brief read the next row into the bound variables. Returns false at the end of the table. */
+    bool GetNextRow();
+    /** @brief skip a number of rows, without reading them. */
+    void Skip(size_t n) { fRow += n; }
+    /** @brief continue reading at the given row, without reading the rows before. */
+    void Seek(size_t row) { fRow = row; }
+
+    /**
+     * @brief find the first row of an event, for tables where events span multiple rows.
+     *
+     * @details the first row of each event has a positive value in the @p count_column, all
+     * other rows have a value of 0. On the first call for a column, it is scanned once in blocks
+     * and the first row of each event is cached, later calls only look up the row.
+     *
+     * @param count_column the name of the column holding the number of rows of each event.
+     * @param event the index of the event.
+     * @return the row index, the number of rows if the table holds exactly @p event events, or
+     * @c std::nullopt if the table is shorter or the column cannot be read.
+     */
+    [[nodiscard]] std::optional<size_t> FindEventStart(
+        const std::string& count_column,
+        size_t event
+    );
+
+    [[nodiscard]] size_t GetNumberOfRows() const { return fNRows; }
+
+  private:
+
+    RMGLH5Reader() = default;
+
+    bool BindColumn(const std::string& name, void* target, const H5::PredType& mem_type);
+    bool ReadBuffer(size_t start);
+    bool BuildEventIndex(const std::string& count_column);
+
+    struct Column {
+        H5::DataSet dset;
+        const H5::PredType* mem_type;
+        void* target;
+        size_t size;
+        std::vector<char> buffer;
+    };
+
+    H5::H5File fFile;
+    H5::Group fTable;
+    std::string fTableName;
+    std::vector<Column> fColumns;
+
+    size_t fNRows = 0;
+    size_t fRow = 0;
+    size_t fBufferStart = 0;
+    size_t fBufferRows = 0;
+
+    // the first row of each event, for each count column.
+    std::map<std::string, std::vector<size_t>> fEventStarts;
+
+    static constexpr size_t kBufferCapacity = 16384;
+};
+
+#endif
+
+// vim: tabstop=2 shiftwidth=2 expandtab
@@ -172,10 +172,18 @@ class RMGLog {
     template<typename T>
     static void Print(RMGLog::LogLevel loglevel, const T& msg, bool prefixed = true, bool do_flush = true);
 
+    /**
+     * Formats a message and pushes it to the running @ref RMGLogSink */
+    template<typename... Args> static void Buffer(RMGLog::LogLevel loglevel, const Args&... args);
+
     /**
      * Converts a log level to a string */
     static std::string GetPrefix(RMGLog::LogLevel, std::ostream& os);
 
+    /**
+     * Writes all buffered log and IPC messages, and aborts the application */
+    [[noreturn]] static void Abort();
+
     /**
      * BAT version number */
     static std::string fVersion;
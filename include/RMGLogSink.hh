@@ -0,0 +1,117 @@
+// Copyright (C) 2026
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef _RMG_LOG_SINK_HH_
+#define _RMG_LOG_SINK_HH_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief background sink for the log messages of all threads.
+ *
+ * @details while the sink is running, @ref RMGLog does not write to @c G4cout / @c G4cerr.
+ * Instead, each message is formatted with all its prefixes and pushed to a ring buffer of the
+ * calling thread, which does not need any locking. A background thread periodically drains the
+ * buffers of all threads in the order the messages were logged, and writes them to the console or
+ * to a log file. A thread whose buffer is full drains all buffers itself.
+ *
+ * The sink is flushed before aborting on fatal errors, and at exit. A message pushed while the
+ * sink is being stopped is written by its own thread. The sink is stopped before @c fork() and
+ * restarted afterwards in both processes, as the background thread does not survive in the child.
+ */
+class RMGLogSink final {
+
+  public:
+
+    RMGLogSink() = delete;
+
+    /**
+     * @brief Start the background thread.
+     * @param file_name if not empty, append the messages to this file instead of the console.
+     * @return false if the log file could not be opened.
+     */
+    static bool Start(const std::string& file_name = "");
+    /** @brief Write all buffered messages, and stop the background thread. */
+    static void Stop();
+    /** @brief Write all buffered messages of all threads. */
+    static void Flush();
+
+    [[nodiscard]] static bool IsRunning() { return fRunning.load(std::memory_order_acquire); }
+
+    /** @brief Push a formatted message of the calling thread, including the trailing newline. */
+    static void Push(std::string message, bool to_cerr);
+
+    /** @brief The stream the messages will be written to, e.g. to decide about colors. */
+    static std::ostream& GetStream(bool to_cerr);
+    /** @brief The prefix that Geant4 adds to the output of worker threads. */
+    static std::string GetThreadPrefix();
+
+  private:
+
+    static constexpr size_t kRingSize = 1024;
+    static constexpr auto kDrainInterval = std::chrono::milliseconds(50);
+
+    struct Message {
+        uint64_t sequence = 0;
+        bool to_cerr = false;
+        std::string text;
+    };
+
+    // only the owning thread pushes messages, and only the thread holding fDrainMutex pops them.
+    struct Ring {
+        std::array<Message, kRingSize> messages;
+        std::atomic<size_t> head = 0;
+        std::atomic<size_t> tail = 0;
+    };
+
+    static Ring& GetThreadRing();
+    static void StartThread();
+    static void StopThread();
+    static void Run();
+
+    static void PrepareFork();
+    static void AfterFork();
+
+    inline static std::atomic<bool> fRunning = false;
+    inline static std::atomic<uint64_t> fSequence = 0;
+
+    inline static std::vector<std::unique_ptr<Ring>> fRings;
+    inline static std::mutex fRingsMutex;
+    inline static std::mutex fDrainMutex;
+
+    inline static std::thread fThread;
+    inline static std::mutex fWakeupMutex;
+    inline static std::condition_variable fWakeup;
+    inline static bool fStopRequested = false;
+    inline static bool fRestartAfterFork = false;
+
+    inline static std::ofstream fFile;
+};
+
+#endif
+
+// vim: tabstop=2 shiftwidth=2 expandtab
@@ -0,0 +1,86 @@
+// Copyright (C) 2026
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef _RMG_MUSUN_READER_HH_
+#define _RMG_MUSUN_READER_HH_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct RMGGeneratorMUSUNCosmicMuons_Data;
+
+/**
+ * @brief reader for the plain-text output files of MUSUN.
+ *
+ * @details the file is memory-mapped, and the offsets of all non-empty lines are indexed once
+ * when opening the file (in parallel for large files). Rows are parsed only on request. After
+ * opening, all functions are @c const and can be used from multiple threads without locking.
+ *
+ * Each line holds the columns @c ID, @c type, @c Ekin, @c x, @c y, @c z, followed by either the
+ * spherical direction @c theta, @c phi or the cartesian momentum @c px, @c py, @c pz. The format
+ * is determined from the number of columns of the first line.
+ */
+class RMGMUSUNReader final {
+
+  public:
+
+    /**
+     * @brief map and index a MUSUN file.
+     * @return the reader, or @c nullptr if the file could not be opened or has an unknown format.
+     */
+    static std::unique_ptr<RMGMUSUNReader> Open(const std::string& file_name);
+
+    ~RMGMUSUNReader();
+
+    RMGMUSUNReader(RMGMUSUNReader const&) = delete;
+    RMGMUSUNReader& operator=(RMGMUSUNReader const&) = delete;
+    RMGMUSUNReader(RMGMUSUNReader&&) = delete;
+    RMGMUSUNReader& operator=(RMGMUSUNReader&&) = delete;
+
+    /**
+     * @brief parse a row of the file. Units are not converted.
+     * @return false if the row does not exist or could not be parsed.
+     */
+    bool ReadRow(size_t row, RMGGeneratorMUSUNCosmicMuons_Data& data) const;
+
+    [[nodiscard]] size_t GetNumberOfRows() const { return fLineOffsets.size(); }
+    /** @brief true for cartesian momentum (px, py, pz), false for spherical (theta, phi). */
+    [[nodiscard]] bool HasCartesianMomentum() const { return fNColumns == 9; }
+    [[nodiscard]] const std::string& GetFileName() const { return fFileName; }
+
+  private:
+
+    RMGMUSUNReader() = default;
+
+    void IndexLines();
+    size_t ParseLine(size_t row, double* fields, size_t max_fields) const;
+
+    std::string fFileName;
+    const char* fData = nullptr;
+    size_t fSize = 0;
+    std::vector<size_t> fLineOffsets;
+    size_t fNColumns = 0;
+
+    // files below this size are indexed by a single thread.
+    static constexpr size_t kParallelIndexChunk = 32 * 1024 * 1024;
+    // longer lines are not valid MUSUN output.
+    static constexpr size_t kMaxLineLength = 512;
+};
+
+#endif
+
+// vim: tabstop=2 shiftwidth=2 expandtab
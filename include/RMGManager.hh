@@ -16,6 +16,7 @@
 #ifndef _RMG_MANAGER_HH_
 #define _RMG_MANAGER_HH_
 
+#include <algorithm>
 #include <atomic>
 #include <memory>
 #include <set>
@@ -28,6 +29,7 @@
 #include "globals.hh"
 
 #include "RMGExceptionHandler.hh"
+#include "RMGForkHandler.hh"
 #include "RMGLog.hh"
 #include "RMGOutputManager.hh"
 #include "RMGUserInit.hh"
@@ -171,11 +173,42 @@ class RMGManager {
      * @param nthreads Number of threads.
      */
     void SetNumberOfThreads(int nthreads) { fNThreads = nthreads; }
+    /**
+     * @brief Sets the number of events processed per task by the task-based run manager.
+     * @param n Number of events per task, 0 for the Geant4 default.
+     */
+    void SetEventsPerTask(int n) { fEventsPerTask = std::max(n, 0); }
+    /**
+     * @brief Sets the number of tasks the events of a run are split into by the task-based run
+     * manager.
+     * @param n Number of tasks, 0 for the Geant4 default (one per thread).
+     */
+    void SetNumberOfTasks(int n) { fNumberOfTasks = std::max(n, 0); }
+    /**
+     * @brief Pins each worker thread to one CPU core.
+     * @param flag True to enable pinning.
+     */
+    void SetPinWorkerThreads(bool flag = true) { fPinWorkerThreads = flag; }
+    /**
+     * @brief Applies the task settings to the task-based run manager for the next run.
+     *
+     * @details has to be called on the master thread, before the events of the run are split into
+     * tasks (i.e. in the run action at the start of a run).
+     * @param n_events Number of events of the run.
+     */
+    void ConfigureTasking(int n_events);
+    /** @brief Pins the calling worker thread to a CPU core, if requested. */
+    void PinWorkerThread() const;
     /**
      * @brief Sets the print modulo value.
      * @param n_ev Number of events for modulo printing.
      */
     void SetPrintModulo(int n_ev) { fPrintModulo = n_ev > 0 ? n_ev : -1; }
+    /**
+     * @brief Sets the minimum time between two telemetry messages of each thread.
+     * @param interval Time interval (in Geant4 units), 0 to disable telemetry.
+     */
+    void SetTelemetryInterval(double interval);
 
     /**
      * @brief Includes a macro or single macro command file for execution.
@@ -245,6 +278,16 @@ class RMGManager {
      * @param level Logging level as a string.
      */
     void SetLogLevel(std::string level);
+    /**
+     * @brief Enables or disables writing the log messages through the buffered log sink.
+     * @param flag True to enable the buffered log output.
+     */
+    void SetBufferedLogOutput(bool flag = true);
+    /**
+     * @brief Writes the log messages to a file, through the buffered log sink.
+     * @param filename The name of the log file, messages are appended to it.
+     */
+    void SetLogFile(std::string filename);
 
     /**
      * @brief Sets the process number for offset calculations in process-parallelized mode.
@@ -255,6 +298,37 @@ class RMGManager {
       fMultiProcessing = true;
     }
 
+    /**
+     * @brief In process-parallelized mode, request the events in batches from the python wrapper.
+     * @details The number of events of each run is then the total number of events of all
+     * processes. Events are claimed in batches from this global budget, until it is used up.
+     */
+    void EnableDynamicEventDistribution() { fDynamicEventDistribution = true; }
+    /**
+     * @brief Checks if events are claimed dynamically from a budget shared by all processes.
+     * @details In this mode, the event ID offset and the offsets in input files are determined
+     * for each batch of events, and not from @ref GetProcessNumberOffset.
+     */
+    [[nodiscard]] bool IsDynamicEventDistribution() const {
+      return fMultiProcessing && fDynamicEventDistribution;
+    }
+
+    /**
+     * @brief In process-parallelized mode, fork the other processes from this process right
+     * before the first run starts, so that they share the initialized geometry and physics.
+     * @param pipe_fds_in the IPC input pipes of the processes to fork, one per process.
+     */
+    void EnableForkAfterInitialization(std::vector<int> pipe_fds_in) {
+      fForkHandler = std::make_unique<RMGForkHandler>(std::move(pipe_fds_in));
+    }
+    /**
+     * @brief Wait for all forked processes, if any, and combine their exit codes.
+     * @param exit_code the exit code of this process.
+     */
+    int WaitForForkedProcesses(int exit_code) {
+      return fForkHandler ? fForkHandler->WaitForForkedProcesses(exit_code) : exit_code;
+    }
+
     /**
      * @brief Checks if any warnings have been recorded.
      * @return True if warnings occurred.
@@ -309,10 +383,15 @@ class RMGManager {
     std::map<std::string, std::string> fG4Aliases;
     std::vector<std::string> fMacroFilesOrContents;
     bool fInteractive = false;
+    std::string fLogFile;
     int fPrintModulo = -1;
     int fNThreads = 1;
+    int fEventsPerTask = 0;
+    int fNumberOfTasks = 0;
+    bool fPinWorkerThreads = false;
     int fProcessNumber = 0;
     bool fMultiProcessing = false;
+    bool fDynamicEventDistribution = false;
 
     bool fIsRandControlled = false;
     bool fIsRandControlledAtEngineChange = false;
@@ -325,6 +404,7 @@ class RMGManager {
     std::unique_ptr<G4VisManager> fG4VisManager = nullptr;
 
     RMGExceptionHandler* fExceptionHandler = nullptr;
+    std::unique_ptr<RMGForkHandler> fForkHandler = nullptr;
     G4VUserPhysicsList* fPhysicsList = nullptr;
     RMGHardware* fDetectorConstruction = nullptr;
 
@@ -336,6 +416,7 @@ class RMGManager {
     std::unique_ptr<G4GenericMessenger> fMessenger;
     std::unique_ptr<G4GenericMessenger> fLogMessenger;
     std::unique_ptr<G4GenericMessenger> fRandMessenger;
+    std::unique_ptr<G4GenericMessenger> fTaskMessenger;
     void DefineCommands();
 };
 
@@ -85,6 +85,13 @@ class RMGMasterGenerator : public G4VUserPrimaryGeneratorAction {
      * @return Pointer to the configured @ref RMGVVertexGenerator instance.
      */
     RMGVVertexGenerator* GetVertexGenerator() { return fVertexGeneratorObj.get(); }
+    /**
+     * @brief Get the offset between the global event ID and the local event ID of the current
+     * event.
+     *
+     * @details only used with @ref RMGManager::IsDynamicEventDistribution.
+     */
+    [[nodiscard]] int GetEventBatchOffset() const { return fEventBatchOffset; }
     /**
      * @brief Retrieve the current vertex confinement strategy.
      *
@@ -141,6 +148,18 @@ class RMGMasterGenerator : public G4VUserPrimaryGeneratorAction {
 
   private:
 
+    /**
+     * @brief Make sure that the event is part of a claimed batch of events, or claim a new batch.
+     * @return false if the global event budget is used up. The event is then aborted.
+     */
+    bool ClaimEventFromBatch(G4Event* event);
+
+    // the global event IDs of the current batch.
+    int fEventBatchRunID = -1;
+    long fEventBatchNext = 0;
+    long fEventBatchEnd = 0;
+    int fEventBatchOffset = 0;
+
     Confinement fConfinement{Confinement::kUnConfined};
     std::unique_ptr<RMGVVertexGenerator> fVertexGeneratorObj;
 
@@ -0,0 +1,160 @@
+// Copyright (C) 2026
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef _RMG_MERGE_LH5_HH
+#define _RMG_MERGE_LH5_HH
+
+#include <cstdint>
+#include <optional>
+#include <regex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "RMGLog.hh"
+
+#include "H5Cpp.h"
+
+/**
+ * @brief Appends remage LH5 output files to a single LH5 file.
+ *
+ * @details The source file has to be an already converted remage LH5 output file (see
+ * @ref RMGConvertLH5). All tables are appended column-by-column to the destination file using
+ * hyperslab selections of a fixed number of rows, so that the rows of one source file stay
+ * contiguous in the destination. Vector-of-vectors columns (i.e. of reshaped hit tables) are
+ * appended with their cumulative lengths shifted accordingly, as are the row numbers in event
+ * index tables (see @ref RMGConvertLH5::fIndexGroupName). Struct groups are merged
+ * recursively, soft links (i.e. the @c __by_uid__ group) are re-created if missing, and the
+ * number of simulated events is summed up. Tables that are marked for deduplication only receive
+ * rows with a previously unseen value in their @c name column.
+ */
+class RMGMergeLH5 {
+
+  public:
+
+    /**
+     * @brief Append the content of an LH5 file to another LH5 file.
+     *
+     * @param src_file_name The LH5 file to read from.
+     * @param dst_file_name The LH5 file to append to. It is created if it does not exist.
+     * @param dedup_tables Names of (auxiliary) tables that should be deduplicated on their
+     * @c name column.
+     * @param buffer_rows Maximum number of rows held in memory per column while copying.
+     * @param part_of_batch Indicates if this operation is part of a batch operation.
+     *
+     * @return True if appending was successful, false otherwise.
+     */
+    static bool AppendToLH5(
+        std::string src_file_name,
+        std::string dst_file_name,
+        const std::set<std::string>& dedup_tables,
+        size_t buffer_rows = fDefaultBufferRows,
+        bool part_of_batch = false
+    );
+
+    /**
+     * @brief Merge multiple LH5 files into a single new LH5 file.
+     *
+     * @details The input files are appended in the given order using @ref AppendToLH5. While
+     * one file is processed, the operating system is advised (with @c posix_fadvise) to read
+     * ahead the next @c prefetch_files input files into the page cache. This is only a hint,
+     * all files are read and written from a single thread.
+     *
+     * @param src_file_names The LH5 files to merge.
+     * @param dst_file_name The LH5 output file. It must not exist.
+     * @param dedup_tables Names of (auxiliary) tables that should be deduplicated on their
+     * @c name column.
+     * @param buffer_rows Maximum number of rows held in memory per column while copying.
+     * @param prefetch_files Number of input files the operating system is advised to read ahead.
+     *
+     * @return True if merging was successful, false otherwise.
+     */
+    static bool MergeLH5(
+        const std::vector<std::string>& src_file_names,
+        std::string dst_file_name,
+        const std::set<std::string>& dedup_tables,
+        size_t buffer_rows = fDefaultBufferRows,
+        int prefetch_files = 1
+    );
+
+    /** @brief Default number of rows copied in one hyperslab operation. */
+    inline static const size_t fDefaultBufferRows = 1 << 16;
+
+    inline static bool fIsStandalone = false;
+
+  private:
+
+    RMGMergeLH5(
+        std::string src_file_name,
+        std::string dst_file_name,
+        const std::set<std::string>& dedup_tables,
+        size_t buffer_rows,
+        bool part_of_batch
+    )
+        : fSrcFileName(src_file_name), fDstFileName(dst_file_name), fDedupTables(dedup_tables),
+          fBufferRows(buffer_rows > 0 ? buffer_rows : fDefaultBufferRows),
+          fIsPartOfBatch(part_of_batch) {};
+
+    ////////////////////////////////////////////////////////////////////////////////////////////
+
+    static int iter_children(hid_t, const char*, const H5L_info_t*, void*);
+    static std::vector<std::string> GetChildren(H5::Group&);
+
+    bool ExistsByType(H5::H5Location&, std::string, H5O_type_t);
+
+    std::optional<std::string> GetStringAttribute(H5::H5Object&, std::string);
+    void SetStringAttribute(H5::H5Object&, std::string, std::string);
+    void CopyAttributes(H5::H5Object&, H5::H5Object&);
+    void MergeDatatypeAttribute(H5::H5Object&, H5::H5Object&);
+
+    std::vector<std::string> ReadStringColumn(H5::DataSet&);
+
+    static void PrefetchFile(const std::string&);
+
+    ////////////////////////////////////////////////////////////////////////////////////////////
+
+    bool AppendToLH5Internal();
+
+    bool AppendGroup(H5::Group&, H5::Group&, const std::string&);
+    bool AppendTable(H5::Group&, H5::Group&, const std::string&);
+    bool AppendDataset(
+        H5::DataSet&,
+        H5::Group&,
+        const std::string&,
+        const std::vector<bool>*,
+        int64_t value_offset = 0
+    );
+    bool AppendVectorOfVectors(H5::Group&, H5::Group&, const std::string&, const std::string&);
+    bool AddScalar(H5::DataSet&, H5::DataSet&);
+
+    static inline const std::regex lgdo_fields_re = std::regex("^(struct|table)\\{(.*)\\}$");
+
+    ////////////////////////////////////////////////////////////////////////////////////////////
+
+    template<typename... Args> void LH5Log(RMGLog::LogLevel loglevel, const Args&... args) {
+      std::string fn_prefix = fIsPartOfBatch ? " (" + fSrcFileName + ")" : "";
+      RMGLog::Out(loglevel, "", fIsStandalone ? "" : "MergeLH5", fn_prefix, ": ", args...);
+    }
+
+    std::string fSrcFileName;
+    std::string fDstFileName;
+    std::set<std::string> fDedupTables;
+    size_t fBufferRows;
+    bool fIsPartOfBatch;
+};
+
+#endif
+
+// vim: tabstop=2 shiftwidth=2 expandtab
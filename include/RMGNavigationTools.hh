@@ -95,6 +95,28 @@ namespace RMGNavigationTools {
    */
   void PrintListOfPhysicalVolumes();
 
+  /**
+   * @brief Checks all placements in the volume tree for overlaps, in parallel.
+   *
+   * Each physical volume placed in the tree below @p world is checked once with
+   * @c G4VPhysicalVolume::CheckOverlaps (against its mother and its sisters), like
+   * @c G4GeomTestVolume::TestOverlapInTree does. The volumes are distributed over @p n_threads
+   * threads. Each thread samples points with its own random engine, so the random state of the
+   * calling thread is not modified. Boolean and multi-union solids are not safe to use
+   * concurrently, so all checks with such a solid as the volume, its mother or one of its sisters
+   * are done one at a time.
+   *
+   * @param world The top volume of the tree to check.
+   * @param n_points The number of points sampled on the surface of each volume.
+   * @param n_threads The number of threads to use, the check runs on the calling thread for 1.
+   * @return The physical volumes that overlap, in the order of the tree traversal.
+   */
+  std::vector<const G4VPhysicalVolume*> CheckOverlapsInTree(
+      const G4VPhysicalVolume* world,
+      int n_points,
+      size_t n_threads
+  );
+
   struct VolumeTreeEntry {
       VolumeTreeEntry() = delete;
       VolumeTreeEntry(const VolumeTreeEntry&) = default;
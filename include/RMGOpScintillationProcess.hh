@@ -0,0 +1,100 @@
+// Copyright (C) 2026
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef _RMG_OP_SCINTILLATION_PROCESS_
+#define _RMG_OP_SCINTILLATION_PROCESS_
+
+/**
+ * @brief A wrapper for the Geant4 scintillation process that thins the emitted photons.
+ *
+ * This class extends @c G4WrapperProcess to emit only a fraction 1/k of the scintillation
+ * photons of the standard @c G4Scintillation process, each carrying a statistical weight of k.
+ * Mean detected yields obtained from the photon weights stay unbiased, while the cost of optical
+ * tracking is reduced by roughly a factor k.
+ */
+
+#include <string>
+#include <vector>
+
+#include "G4ParticleDefinition.hh"
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4VParticleChange.hh"
+#include "G4WrapperProcess.hh"
+#include "globals.hh"
+
+class RMGOpScintillationProcess : public G4WrapperProcess {
+
+  public:
+
+    /**
+     * @brief Constructs a new RMG scintillation process.
+     *
+     * @param thinning_factor Only one out of @c thinning_factor photons is emitted on average.
+     * @param aNamePrefix Prefix for naming the process (default "RMG").
+     * @param aType Process type (default @c fElectromagnetic, as for @c G4Scintillation).
+     */
+    explicit RMGOpScintillationProcess(
+        double thinning_factor,
+        const G4String& aNamePrefix = "RMG",
+        G4ProcessType aType = fElectromagnetic
+    );
+
+    /**
+     * @brief Virtual destructor.
+     */
+    virtual ~RMGOpScintillationProcess() = default;
+
+    /**
+     * @brief Register the wrapped process, and also take over its process sub-type.
+     *
+     * @details This keeps the creator process of the photons identifiable as scintillation.
+     */
+    void RegisterProcess(G4VProcess* process) override;
+
+    /** @brief Call the wrapped process and apply the photon weights to its secondaries. */
+    G4VParticleChange* PostStepDoIt(const G4Track& aTrack, const G4Step& aStep) override;
+    /** @brief Call the wrapped process and apply the photon weights to its secondaries. */
+    G4VParticleChange* AtRestDoIt(const G4Track& aTrack, const G4Step& aStep) override;
+
+    /**
+     * @brief Builds the physics table for the scintillation process.
+     *
+     * This method overrides @c BuildPhysicsTable() to scale the scintillation yields of all
+     * materials by 1/k before the registered process's @c BuildPhysicsTable() is invoked. This
+     * applies to @c SCINTILLATIONYIELD and to the per-particle yields used with
+     * @c G4OpticalParameters::SetScintByParticleType. The applied factor is recorded in the
+     * material property @c RMG_SCINTILLATIONTHINNING, so that the yields are only scaled once.
+     *
+     * @param aParticleType The particle definition for which the physics table is built.
+     */
+    void BuildPhysicsTable(const G4ParticleDefinition& aParticleType) override;
+
+  private:
+
+    G4VParticleChange* ApplyWeights(G4VParticleChange* change) const;
+
+    double fThinningFactor;
+
+    static inline const std::vector<std::string> kYieldVectorProperties = {
+        "PROTONSCINTILLATIONYIELD",
+        "DEUTERONSCINTILLATIONYIELD",
+        "TRITONSCINTILLATIONYIELD",
+        "ALPHASCINTILLATIONYIELD",
+        "IONSCINTILLATIONYIELD",
+        "ELECTRONSCINTILLATIONYIELD",
+    };
+};
+#endif
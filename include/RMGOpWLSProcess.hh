@@ -23,7 +23,8 @@
  * This class extends @c G4WrapperProcess to customize the behavior of the standard
  * @c G4OpWLS process. It uses a material property @c RMG_WLSMEANNUMBERPHOTONS to control
  * the mean number of emitted photons and prevents the default Poissonian sampling by
- * replacing the original @c WLSMEANNUMBERPHOTONS property.
+ * replacing the original @c WLSMEANNUMBERPHOTONS property. Optionally, the shifted photons can
+ * be thinned by a factor k, i.e. only 1/k of them are emitted with a statistical weight of k.
  */
 
 #include "G4ParticleDefinition.hh"
@@ -79,5 +80,15 @@ class RMGOpWLSProcess : public G4WrapperProcess {
      * @param aParticleType The particle definition for which the physics table is built.
      */
     void BuildPhysicsTable(const G4ParticleDefinition& aParticleType) override;
+
+    /**
+     * @brief Only emit one out of @p k shifted photons on average, each with a k times higher
+     * weight.
+     */
+    void SetThinningFactor(double k) { fThinningFactor = k; }
+
+  private:
+
+    double fThinningFactor = 1;
 };
 #endif
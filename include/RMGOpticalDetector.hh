@@ -55,6 +55,7 @@ class RMGOpticalDetectorHit : public G4VHit {
     int detector_uid = -1;                ///< Remage unique identifier of the absorbing detector.
     double photon_wavelength = 0.;        ///< Absorbed-photon wavelength (Geant4 length units).
     double global_time = -1;              ///< Global time at absorption (Geant4 time units).
+    double weight = 1;                    ///< Statistical weight of the photon (with thinning).
 };
 
 using RMGOpticalDetectorHitsCollection = G4THitsCollection<RMGOpticalDetectorHit>;
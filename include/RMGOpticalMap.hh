@@ -0,0 +1,112 @@
+// Copyright (C) 2026
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef _RMG_OPTICAL_MAP_HH_
+#define _RMG_OPTICAL_MAP_HH_
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "G4ThreeVector.hh"
+
+/**
+ * @brief Voxelized photon detection probability map for a set of optical detectors.
+ *
+ * @details The map covers a box with a regular grid of cubic voxels. For each voxel, it holds
+ * the number of optical photons generated in it and the number of these photons detected by
+ * each optical detector (identified by its uid), summed over the photon weights. The detection
+ * probabilities are derived from these counts.
+ *
+ * The map is stored in an HDF5 file (with LH5 attributes) in the group @c optmap, containing
+ * the voxel edges (@c xedges, @c yedges, @c zedges, in mm), the detector uids (@c det_uid), the
+ * counts (@c n_generated and @c n_detected) and the probabilities (@c prob). The arrays with a
+ * detector axis have the shape @c (n_det, n_x, n_y, n_z).
+ */
+class RMGOpticalMap {
+
+  public:
+
+    /**
+     * @brief Create an empty map for accumulating photon counts.
+     *
+     * @param lower Lower corner of the mapped box.
+     * @param upper Upper corner of the mapped box.
+     * @param bin_width Edge length of a voxel. The box is extended to hold an integer number of
+     * voxels.
+     * @param det_uids Uids of the optical detectors in the map.
+     */
+    RMGOpticalMap(
+        const G4ThreeVector& lower,
+        const G4ThreeVector& upper,
+        double bin_width,
+        std::vector<int> det_uids
+    );
+
+    /** @brief Read a map from an HDF5 file. */
+    static std::unique_ptr<RMGOpticalMap> ReadFromFile(const std::string& file_name);
+    /** @brief Write the map to a (new) HDF5 file. */
+    void WriteToFile(const std::string& file_name) const;
+
+    /** @brief Get the index of the voxel containing a point, or -1 if it is outside the map. */
+    [[nodiscard]] int64_t GetVoxelIndex(const G4ThreeVector& pos) const;
+
+    /**
+     * @brief Sample the detector that detects a photon emitted in a voxel.
+     *
+     * @param voxel The voxel index, as returned by @ref GetVoxelIndex.
+     * @param rnd A uniform random number in [0, 1).
+     *
+     * @return The uid of the detecting detector, or -1 if the photon is not detected.
+     */
+    [[nodiscard]] int SampleDetector(int64_t voxel, double rnd) const;
+
+    /** @brief Count photons generated in a voxel. */
+    void AddGenerated(int64_t voxel, int64_t n = 1) { fNGenerated[voxel] += n; }
+    /** @brief Count (weighted) photons from a voxel detected by the detector with the given uid. */
+    void AddDetected(int64_t voxel, int det_uid, double n = 1);
+    /** @brief Add the counts of another map with the same binning and detectors. */
+    void Merge(const RMGOpticalMap& other);
+
+    [[nodiscard]] const std::vector<int>& GetDetectorUids() const { return fDetUids; }
+    [[nodiscard]] int64_t GetNumberOfVoxels() const { return fNVoxels; }
+
+  private:
+
+    RMGOpticalMap() = default;
+
+    void Allocate();
+    void UpdateCumulativeProbabilities();
+
+    G4ThreeVector fLower;
+    double fBinWidth = 0;
+    std::array<int64_t, 3> fNBins = {0, 0, 0};
+    int64_t fNVoxels = 0;
+
+    std::vector<int> fDetUids;
+    std::unordered_map<int, size_t> fDetIndex;
+
+    // voxel-major layout, i.e. index [voxel * n_det + det].
+    std::vector<int64_t> fNGenerated;
+    std::vector<double> fNDetected;
+    std::vector<double> fCumulativeProb;
+};
+
+#endif
+
+// vim: tabstop=2 shiftwidth=2 expandtab
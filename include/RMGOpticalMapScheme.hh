@@ -0,0 +1,99 @@
+// Copyright (C) 2026
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef _RMG_OPTICAL_MAP_SCHEME_HH_
+#define _RMG_OPTICAL_MAP_SCHEME_HH_
+
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "G4AutoLock.hh"
+#include "G4GenericMessenger.hh"
+#include "G4ThreeVector.hh"
+
+#include "RMGOpticalDetector.hh"
+#include "RMGOpticalMap.hh"
+#include "RMGVOutputScheme.hh"
+
+class G4Event;
+
+/**
+ * @brief Optical map based fast simulation of scintillation light, and creation of such maps.
+ *
+ * @details With a loaded map (see @ref RMGOpticalMap), scintillation photons are not tracked.
+ * Instead, when a new scintillation photon is stacked, the detecting optical detector (if any)
+ * is sampled from the detection probabilities of the voxel it was emitted in, a hit is added to
+ * the hit collection of the optical detectors and the photon is killed. The hit keeps the
+ * wavelength and emission time of the photon.
+ *
+ * To create a map, optical photons have to be generated as primaries (with one primary vertex
+ * per event) and tracked with full optical physics. The scheme counts generated photons per
+ * voxel of their vertex, and detected photons per detector from the optical detector hits. The
+ * counts of all threads are merged and written to the map file at the end of the run.
+ */
+class RMGOpticalMapScheme : public RMGVOutputScheme {
+
+  public:
+
+    RMGOpticalMapScheme();
+
+    /** @brief Replace scintillation photons by hits sampled from the loaded map. */
+    std::optional<G4ClassificationOfNewTrack> StackingActionClassify(const G4Track*, int) override;
+
+    /** @brief Count generated and detected photons when creating a map. */
+    void StoreEvent(const G4Event*) override;
+    /** @brief The map has to be filled regardless of event filtering. */
+    [[nodiscard]] bool StoreAlways() const override { return true; }
+
+    /** @brief Merge the counts of this thread and write the map file from the master thread. */
+    void EndOfRunAction(const G4Run*) override;
+
+    /** @brief Load a map file and enable the fast simulation. */
+    void LoadMap(std::string file_name);
+
+  protected:
+
+    [[nodiscard]] std::string GetNtupleName(RMGDetectorMetadata) const override {
+      throw std::logic_error("optical map scheme has no detectors");
+    }
+
+  private:
+
+    RMGOpticalDetectorHitsCollection* GetHitsCollection();
+    int fHitsCollectionID = -1;
+
+    std::shared_ptr<const RMGOpticalMap> fMap;
+
+    std::string fCreateMapFileName;
+    G4ThreeVector fCreateMapLower;
+    G4ThreeVector fCreateMapUpper;
+    double fCreateMapBinWidth = 0;
+    std::unique_ptr<RMGOpticalMap> fCreatedMap;
+    bool fWarnedNumberOfVertices = false;
+
+    // maps are shared between threads, and created maps are merged from all threads.
+    static inline std::map<std::string, std::weak_ptr<const RMGOpticalMap>> fLoadedMaps;
+    static inline std::unique_ptr<RMGOpticalMap> fMergedMap;
+    static inline G4Mutex fMutex = G4MUTEX_INITIALIZER;
+
+    std::unique_ptr<G4GenericMessenger> fMessenger;
+    void DefineCommands();
+};
+
+#endif
+
+// vim: tabstop=2 shiftwidth=2 expandtab
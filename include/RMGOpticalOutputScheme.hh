@@ -24,8 +24,16 @@
 #include "RMGVOutputScheme.hh"
 
 class G4Event;
+class RMGOpticalDetectorHit;
 /**
  * @brief Output scheme writing optical photon detector hits.
+ *
+ * @details By default, one row is written per detected photon. In photon-counting mode, only the
+ * number of detected photons per event and detector is written, optionally split into fixed-width
+ * bins of the arrival time (one row per non-empty bin).
+ *
+ * With thinning of optical photons (see @ref RMGPhysics), each photon carries a statistical
+ * weight, which is stored in an additional @c weight column or added up in photon-counting mode.
  */
 class RMGOpticalOutputScheme : public RMGVOutputScheme {
 
@@ -48,6 +56,19 @@ class RMGOpticalOutputScheme : public RMGVOutputScheme {
     void DefineCommands();
 
     bool fStoreSinglePrecisionEnergy = true;
+    bool fStoreWeights = false;
+
+    bool fPhotonCounting = false;
+    double fPhotonCountingTimeBinWidth = 0;
+    int fPhotonCountingTimeBins = 100;
+
+    /** @brief The aggregated photons of one detector (and time bin) in one event. */
+    struct RMGPhotonCount {
+        int detector_uid;
+        double global_time;
+        double n_photons; // the sum of the photon weights.
+    };
+    void StorePhotonCounts(const G4Event*, const std::vector<RMGOpticalDetectorHit*>&);
 };
 
 #endif
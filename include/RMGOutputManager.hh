@@ -21,7 +21,9 @@
 #include <set>
 #include <vector>
 
+#include "CLHEP/Units/SystemOfUnits.h"
 #include "G4AnalysisManager.hh"
+#include "G4AutoLock.hh"
 #include "G4GenericMessenger.hh"
 #include "G4Threading.hh"
 #include "globals.hh"
@@ -100,6 +102,43 @@ class RMGOutputManager {
      * @return true if volume names are used.
      */
     [[nodiscard]] bool GetOutputNtupleUseVolumeName() const { return fOutputNtupleUseVolumeName; }
+    /**
+     * @brief Checks if the worker threads append to a single output file.
+     * @return true if the per-thread output files are merged in-process.
+     */
+    [[nodiscard]] bool GetOutputMergeThreadFiles() const { return fOutputMergeThreadFiles; }
+    /**
+     * @brief Checks if detector steps are reshaped into hits while writing the output.
+     * @return true if steps are grouped into time-windowed hits in-process.
+     */
+    [[nodiscard]] bool GetOutputReshapeHits() const { return fOutputReshapeHits; }
+    /**
+     * @brief Gets the time window used to group steps into hits.
+     * @return The time window (in Geant4 units).
+     */
+    [[nodiscard]] double GetOutputReshapeTimeWindow() const { return fOutputReshapeTimeWindow; }
+    /**
+     * @brief Checks if an event index is written for each detector table.
+     * @return true if event index tables are written.
+     */
+    [[nodiscard]] bool GetOutputEventIndex() const { return fOutputEventIndex; }
+    /**
+     * @brief Gets the maximum number of events written to one output file.
+     * @return The maximum number of events per file, or 0 if unlimited.
+     */
+    [[nodiscard]] int GetOutputMaxEventsPerFile() const { return fOutputMaxEventsPerFile; }
+    /**
+     * @brief Gets the (approximate) maximum size of one output file.
+     * @return The maximum size in bytes, or 0 if unlimited.
+     */
+    [[nodiscard]] double GetOutputMaxBytesPerFile() const { return fOutputMaxBytesPerFile; }
+    /**
+     * @brief Checks if the output file is rotated after a maximum number of events or bytes.
+     * @return true if any output file limit is set.
+     */
+    [[nodiscard]] bool HasOutputFileLimits() const {
+      return fOutputMaxEventsPerFile > 0 || fOutputMaxBytesPerFile > 0;
+    }
 
     /**
      * @brief Retrieves the set of registered ntuple detector identifiers.
@@ -115,6 +154,14 @@ class RMGOutputManager {
       for (auto const& [k, v] : fNtupleAuxIDs) nt_names.insert(k);
       return nt_names;
     }
+    /**
+     * @brief Retrieves the set of auxiliary ntuples that have to be deduplicated when merging.
+     * @return Set of auxiliary ntuple names.
+     */
+    std::set<std::string> GetDeduplicatedNtupleNames() {
+      G4AutoLock l(&fNtupleDeduplicateMutex);
+      return fNtupleDeduplicate;
+    }
 
     // setters
     /**
@@ -139,6 +186,41 @@ class RMGOutputManager {
      * @param dir The directory name for ntuple output.
      */
     void SetOutputNtupleDirectory(std::string dir) { fOutputNtupleDirectory = dir; }
+    /**
+     * @brief Configures whether worker threads append to a single output file.
+     * @details only supported for LH5 output files.
+     * @param merge True to merge the per-thread output files in-process.
+     */
+    void SetOutputMergeThreadFiles(bool merge) { fOutputMergeThreadFiles = merge; }
+    /**
+     * @brief Configures whether detector steps are reshaped into hits while writing the output.
+     * @details only supported for LH5 output files.
+     * @param reshape True to group steps into time-windowed hits in-process.
+     */
+    void SetOutputReshapeHits(bool reshape) { fOutputReshapeHits = reshape; }
+    /**
+     * @brief Sets the time window used to group steps into hits.
+     * @param time_window The time window (in Geant4 units).
+     */
+    void SetOutputReshapeTimeWindow(double time_window) { fOutputReshapeTimeWindow = time_window; }
+    /**
+     * @brief Configures whether an event index is written for each detector table.
+     * @details only supported for LH5 output files.
+     * @param index True to write event index tables.
+     */
+    void SetOutputEventIndex(bool index) { fOutputEventIndex = index; }
+    /**
+     * @brief Sets the maximum number of events written to one output file.
+     * @details only supported for LH5 output files.
+     * @param max_events The maximum number of events per file, 0 for no limit.
+     */
+    void SetOutputMaxEventsPerFile(int max_events) { fOutputMaxEventsPerFile = max_events; }
+    /**
+     * @brief Sets the (approximate) maximum size of one output file.
+     * @details only supported for LH5 output files.
+     * @param max_bytes The maximum size in bytes, 0 for no limit.
+     */
+    void SetOutputMaxBytesPerFile(double max_bytes) { fOutputMaxBytesPerFile = max_bytes; }
 
     /**
      * @brief Registers an alreaday created ntuple for a given detector.
@@ -198,6 +280,17 @@ class RMGOutputManager {
      */
     int GetAuxNtupleID(std::string det_uid) { return fNtupleAuxIDs[det_uid]; }
 
+    /**
+     * @brief Marks an auxiliary ntuple to be deduplicated when merging output files.
+     *
+     * @details rows are deduplicated by the value of their @c name column. An IPC
+     * message keyed as "output_ntuple_deduplicate" is automatically sent to communicate
+     * the table name.
+     *
+     * @param table_name Name of the auxiliary output table.
+     */
+    void RegisterNtupleDeduplication(std::string table_name);
+
     /**
      * @brief Activates an optional output scheme.
      * @param name Name of the output scheme to activate.
@@ -214,6 +307,15 @@ class RMGOutputManager {
     bool fOutputNtuplePerDetector = true;
     bool fOutputNtupleUseVolumeName = false;
     std::string fOutputNtupleDirectory = "stp";
+    bool fOutputMergeThreadFiles = false;
+    bool fOutputReshapeHits = false;
+    double fOutputReshapeTimeWindow = 10 * CLHEP::us;
+    bool fOutputEventIndex = false;
+    int fOutputMaxEventsPerFile = 0;
+    double fOutputMaxBytesPerFile = 0;
+
+    std::set<std::string> fNtupleDeduplicate;
+    static inline G4Mutex fNtupleDeduplicateMutex = G4MUTEX_INITIALIZER;
 
     /** @brief Mapping of detector UIDs assigned by remage to the Geant4 ntuple
      * IDs and the ntuple names (written to disk).
@@ -18,6 +18,7 @@
 
 #include <map>
 #include <memory>
+#include <string>
 
 #include "G4GenericMessenger.hh"
 #include "G4VModularPhysicsList.hh"
@@ -131,18 +132,40 @@ class RMGPhysics : public G4VModularPhysicsList {
 
     void DumpProcessesForParticles(std::string file_name);
 
+    /** @brief Set the base directory of the on-disk physics table cache. */
+    void SetPhysicsTableCache(std::string dir) { fPhysicsTableCacheDir = std::move(dir); }
+
+    /** @brief Store the built physics tables in the cache, if they were not retrieved from it.
+     *
+     * @details has to be called on the master thread, after the physics tables have been built
+     * (i.e. at the start of the first run). Tables are written to a temporary directory first, and
+     * moved into the cache when complete, so that concurrent jobs never read partial tables.
+     */
+    void StorePhysicsTableCache();
+
+    /** @brief Whether optical photons can carry a statistical weight different from 1. */
+    [[nodiscard]] bool HasOpticalThinning() const {
+      const bool wls_thinning = fUseOpticalCustomWLS && fOpticalWLSThinning > 1;
+      return fConstructOptical && (fOpticalScintillationThinning > 1 || wls_thinning);
+    }
+
   protected:
 
     void ConstructParticle() override;
     void ConstructProcess() override;
     virtual void ConstructOptical();
 
+    /** @brief Describe everything that the physics tables depend on, to be used as cache key. */
+    [[nodiscard]] virtual std::string GetPhysicsTableCacheKey() const;
+
   private:
 
     ProdCutStore fProdCuts = {};
     ProdCutStore fProdCutsSensitive = {};
     bool fConstructOptical = false;
     bool fUseOpticalCustomWLS = true;
+    double fOpticalScintillationThinning = 1;
+    double fOpticalWLSThinning = 1;
     bool fUseNeutronThermalScattering = false;
     bool fUseGrabmayrGammaCascades = false;
     bool fUseInnerBremsstrahlung = false;
@@ -150,6 +173,10 @@ class RMGPhysics : public G4VModularPhysicsList {
     HadronicPhysicsListOption fHadronicPhysicsListOption = HadronicPhysicsListOption::kNone;
     G4double fLowEnergyRange = 250 * CLHEP::eV;
     G4double fHighEnergyRange = 100. * CLHEP::GeV;
+    std::string fPhysicsTableCacheDir;
+    std::string fPhysicsTableCachePath;
+    bool fStorePhysicsTableCache = false;
+    void ConfigurePhysicsTableCache();
     std::unique_ptr<G4GenericMessenger> fMessenger;
     void DefineCommands();
 };
@@ -18,13 +18,14 @@
 
 #include <chrono>
 
+#include "G4Event.hh"
 #include "G4Run.hh"
 
 /**
  * @brief Per-run object extending @c G4Run with bookkeeping needed by remage.
  *
  * Currently stores the wall-clock start time of the run, used by @ref RMGRunAction to
- * report run duration.
+ * report run duration, and does not count events that have not been simulated.
  */
 class RMGRun : public G4Run {
 
@@ -37,9 +38,22 @@ class RMGRun : public G4Run {
     /** @brief Record the wall-clock time at which the run was started. */
     void SetStartTime(TimePoint t) { fStartTime = t; }
 
+    /**
+     * @brief Do not count the event as simulated, i.e. because the event budget has been used up.
+     * @details only used with @ref RMGManager::IsDynamicEventDistribution, where the run is
+     * aborted in the first event that could not claim a batch of events.
+     */
+    void SetEventNotSimulated(int event_id) { fNotSimulatedEventID = event_id; }
+
+    void RecordEvent(const G4Event* event) override {
+      if (event->GetEventID() == fNotSimulatedEventID) return;
+      G4Run::RecordEvent(event);
+    }
+
   private:
 
     TimePoint fStartTime;
+    int fNotSimulatedEventID = -1;
 };
 
 #endif
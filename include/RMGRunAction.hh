@@ -65,11 +65,29 @@ class RMGRunAction : public G4UserRunAction {
     /** @brief Close the output file and move the temporary worker file to its final path. */
     void EndOfRunAction(const G4Run*) override;
 
+    /**
+     * @brief Count a finished event in the current output file, and check the output file limits.
+     * @details if a limit (see @ref RMGOutputManager::HasOutputFileLimits) is reached, the file
+     * is rotated at the start of the next event, see @ref RotateOutputFileIfRequested.
+     */
+    void CheckOutputFileLimits();
+    /**
+     * @brief Close, convert and announce the current output file and open the next one, if
+     * requested by @ref CheckOutputFileLimits.
+     */
+    void RotateOutputFileIfRequested();
+
     /** @brief Print-modulo value chosen for the run currently being processed. */
     [[nodiscard]] int GetCurrentRunPrintModulo() const { return fCurrentPrintModulo; }
 
     /** @brief Output schemes registered on this thread. */
     [[nodiscard]] const auto& GetAllOutputDataFields() { return fOutputDataFields; }
+    /** @brief Invoke @ref RMGVOutputScheme::SetEventIDOffset on every registered scheme. */
+    void SetEventIDOffset(int offset) {
+      for (auto& el : fOutputDataFields) el->SetEventIDOffset(offset);
+    }
+    /** @brief The primary generator of this thread, if any. */
+    [[nodiscard]] RMGMasterGenerator* GetMasterGenerator() const { return fRMGMasterGenerator; }
     /** @brief Invoke @ref RMGVOutputScheme::ClearBeforeEvent on every registered scheme. */
     void ClearOutputDataFields() {
       for (auto& el : fOutputDataFields) el->ClearBeforeEvent();
@@ -84,8 +102,15 @@ class RMGRunAction : public G4UserRunAction {
         fs::path original;
     };
 
-    [[nodiscard]] OutputFilePaths BuildOutputFile() const;
+    [[nodiscard]] OutputFilePaths BuildOutputFile(int file_index = 0) const;
+    void OpenOutputFile();
+    /** @brief Let the output schemes finish the current output file, then write and close it. */
+    void CloseOutputFile();
     [[nodiscard]] fs::path GetWorkerTmpPath(fs::path path, std::string extension) const;
+    /** @brief Whether the worker threads append to a single (LH5) output file. */
+    [[nodiscard]] bool IsMergingThreadFiles() const;
+    /** @brief Whether this thread processes events, i.e. a worker or the sequential master. */
+    [[nodiscard]] bool IsEventProcessingThread() const;
     void PostprocessOutputFile(int number_of_primaries) const;
 
     RMGRun* fRMGRun = nullptr;
@@ -94,6 +119,12 @@ class RMGRunAction : public G4UserRunAction {
     RMGMasterGenerator* fRMGMasterGenerator = nullptr;
     OutputFilePaths fCurrentOutputFile;
 
+    bool fIsRotatingOutputFiles = false;
+    bool fRotateOutputFile = false;
+    int fOutputFileIndex = 0;
+    int fEventsInCurrentFile = 0;
+    int fEventsInClosedFiles = 0;
+
     int fCurrentPrintModulo = -1;
 
     std::vector<std::shared_ptr<RMGVOutputScheme>> fOutputDataFields;
@@ -0,0 +1,82 @@
+// Copyright (C) 2026
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef _RMG_TELEMETRY_HH_
+#define _RMG_TELEMETRY_HH_
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+namespace fs = std::filesystem;
+
+#include "G4Threading.hh"
+
+/**
+ * @brief periodically sends the throughput of each event-processing thread over IPC.
+ *
+ * @details each thread that processes events counts its events and steps. At most once per
+ * interval (checked at the end of each event), and at the end of each run, it sends a
+ * non-blocking @c telemetry IPC message. The python wrapper aggregates these messages over all
+ * threads and processes, see @c remage.ipc.Telemetry.
+ *
+ * The written bytes are the sizes of the output files of the thread in the run, including the
+ * files already closed when rotating the output files.
+ *
+ * All counters are thread-local, so counting does not need any synchronization.
+ */
+class RMGTelemetry final {
+
+  public:
+
+    RMGTelemetry() = delete;
+
+    /** @brief Reset the counters of this thread for a new run. */
+    static void BeginOfRun(int run_id, int n_events);
+    /** @brief Count a processed event, and send a message if the interval has passed. */
+    static void EndOfEvent();
+    /** @brief Send the final message for the run of this thread. */
+    static void EndOfRun();
+    /** @brief Count a step. */
+    static void CountStep() { fSteps++; }
+
+    /** @brief Set the output file this thread writes to. */
+    static void SetOutputFile(const fs::path& file);
+    /** @brief Count the size of the output file of this thread, before it is closed and moved. */
+    static void CloseOutputFile();
+
+    /** @brief Set the minimum time between two messages of a thread, 0 to disable them. */
+    static void SetInterval(double seconds) { fIntervalSeconds = seconds; }
+
+  private:
+
+    static void Send(bool final);
+    static uint64_t OutputFileBytes();
+
+    inline static double fIntervalSeconds = 5;
+
+    inline static G4ThreadLocal bool fActive = false;
+    inline static G4ThreadLocal int fRunID = 0;
+    inline static G4ThreadLocal int fRunEvents = 0;
+    inline static G4ThreadLocal uint64_t fEvents = 0;
+    inline static G4ThreadLocal uint64_t fSteps = 0;
+    inline static G4ThreadLocal uint64_t fClosedOutputBytes = 0;
+    inline static G4ThreadLocal fs::path fOutputFile;
+    inline static G4ThreadLocal std::chrono::steady_clock::time_point fStartTime;
+    inline static G4ThreadLocal std::chrono::steady_clock::time_point fLastSent;
+};
+
+#endif
+
+// vim: tabstop=2 shiftwidth=2 expandtab
@@ -16,7 +16,9 @@
 #ifndef _RMG_TOOLS_HH_
 #define _RMG_TOOLS_HH_
 
+#include <cstdint>
 #include <stdexcept>
+#include <string_view>
 
 #include "globals.hh"
 
@@ -83,6 +85,28 @@ namespace RMGTools {
     auto name = s[0] == 'k' ? s.substr(1, std::string::npos) : s;
     return std::string(name);
   }
+
+  /**
+   * @brief Computes the 64-bit FNV-1a hash of the given data.
+   *
+   * The hash is stable across platforms and program runs, so it can be used as a key for files
+   * cached on disk. It is not suitable for any cryptographic purpose.
+   *
+   * @param data The data to hash.
+   * @param hash The initial value, to continue hashing from a previous result.
+   */
+  inline uint64_t Hash(std::string_view data, uint64_t hash = 0xcbf29ce484222325) {
+    for (const unsigned char c : data) {
+      hash ^= c;
+      hash *= 0x100000001b3;
+    }
+    return hash;
+  }
+
+  /** @brief Returns the hash of the given data, see @ref Hash, as a hexadecimal string. */
+  inline std::string HashString(std::string_view data) {
+    return fmt::format("{:016x}", Hash(data));
+  }
 } // namespace RMGTools
 
 #endif
@@ -18,8 +18,11 @@
 
 #include <map>
 #include <set>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "CLHEP/Units/SystemOfUnits.h"
 #include "G4AnalysisManager.hh"
 #include "G4GenericMessenger.hh"
 
@@ -27,6 +30,8 @@
 
 class G4Event;
 class G4Track;
+class G4VProcess;
+class RMGStackingAction;
 /** @brief Output scheme for track information.
  *
  *  @details This output scheme records the properties of each track generated.
@@ -43,6 +48,10 @@ class G4Track;
  *
  *  The creator process is mapped to a unique integer value and additionally stored in the output.
  *
+ *  With the compact encoding, the track IDs are delta-coded within the event, and positions,
+ *  momenta and energies are stored as integer multiples of a configurable precision. The depth
+ *  of the stored track tree can also be limited.
+ *
  *  It can be specified that the information is always stored, even if the
  *  event would be discarded by other output schemes.
  */
@@ -61,9 +70,12 @@ class RMGTrackOutputScheme : public RMGVOutputScheme {
     void TrackingActionPre(const G4Track*) override;
 
     /** @brief handles the storage of the process map. */
-    void EndOfRunAction(const G4Run*) override;
+    void EndOfOutputFile() override;
 
-    /** @brief Clears the event data and frees memory before the next event is processed. */
+    /** @brief Clears the event data before the next event is processed.
+     *  @details the memory of the track entries is only freed after exceptionally large events,
+     *  otherwise it is reused for the next event.
+     */
     void ClearBeforeEvent() override;
 
     /** @brief Store the information from the event, invoked in @c RMGEventAction::EndOfEventAction
@@ -82,9 +94,14 @@ class RMGTrackOutputScheme : public RMGVOutputScheme {
     }
 
     void AddParticleFilter(const int pdg) { fFilterParticle.insert(pdg); }
-    void AddProcessFilter(const std::string proc) { fFilterProcess.insert(proc); }
+    void AddProcessFilter(const std::string proc) {
+      fFilterProcess.insert(proc);
+      fProcessInfoCache.clear(); // the cached filter decisions are not valid any more.
+    }
     void SetEnergyFilter(double energy) { fFilterEnergy = energy; }
     void SetStoreStageID(bool flag) { fStoreStageID = flag; }
+    void SetPositionPrecision(std::string unit);
+    void SetEnergyPrecision(std::string unit);
 
   private:
 
@@ -97,9 +114,33 @@ class RMGTrackOutputScheme : public RMGVOutputScheme {
     bool fStoreOpticalPhotons = false;
     bool fStoreStageID = false;
 
+    bool fCompactEncoding = false;
+    std::string fPositionPrecisionUnit = "um";
+    double fPositionPrecision = CLHEP::um;
+    std::string fEnergyPrecisionUnit = "keV";
+    double fEnergyPrecision = CLHEP::keV;
+    /** @brief Quantize a value to an integer multiple of the precision (saturating, with a warning
+     *  on the first clamped value). */
+    [[nodiscard]] int Quantize(double value, double precision, const std::string& unit);
+    bool fWarnedQuantizeClamp = false;
+
+    int fMaxTreeDepth = -1;
+    std::vector<int> fTrackDepths; // track ID -> depth in the track tree, -1 if not known.
+
     std::map<std::string, uint32_t> fProcessMap;
     std::set<int> fStoredProcessIDs; // This set keeps track of the process IDs that have not been discarded.
 
+    /** @brief Cached per-process information, to avoid name lookups for each track. */
+    struct RMGProcessInfo {
+        int proc_id;
+        bool pass_filter;
+    };
+    std::unordered_map<const G4VProcess*, RMGProcessInfo> fProcessInfoCache;
+    const RMGProcessInfo& GetProcessInfo(const G4VProcess*);
+
+    const RMGStackingAction* fStackingAction = nullptr;
+    bool fStackingActionResolved = false;
+
     std::set<std::string> fFilterProcess;
     std::set<int> fFilterParticle;
     double fFilterEnergy = -1;
@@ -122,6 +163,8 @@ class RMGTrackOutputScheme : public RMGVOutputScheme {
     };
 
     std::vector<RMGTrackEntry> fTrackEntries;
+    /** @brief Maximum number of track entries whose memory is kept between events. */
+    static constexpr size_t fMaxRetainedTrackEntries = 1 << 16;
 };
 
 #endif
@@ -16,8 +16,10 @@
 #ifndef _RMG_V_OUTPUT_SCHEME_HH_
 #define _RMG_V_OUTPUT_SCHEME_HH_
 
+#include <algorithm>
 #include <optional>
 #include <string>
+#include <vector>
 
 #include "G4AnalysisManager.hh"
 #include "G4Event.hh"
@@ -145,6 +147,22 @@ class RMGVOutputScheme {
      */
     virtual void EndOfRunAction(const G4Run*) {};
 
+    // hooks for each output file, a run can write several files if output file limits are set.
+    /**
+     * @brief Called after an output file has been opened.
+     *
+     * Derived output schemes can use this to reset any state kept per output file.
+     */
+    virtual void BeginOfOutputFile() {}
+    /**
+     * @brief Called before an output file is written and closed.
+     *
+     * Derived output schemes can use this to write tables that have to be present in each output
+     * file. Unlike @ref EndOfRunAction, this is also called when rotating output files during a
+     * run.
+     */
+    virtual void EndOfOutputFile() {}
+
     // only to be called by the manager, before calling @ref AssignOutputNames.
     /**
      * @brief Specify whether to create separate ntuples for each detector.
@@ -163,7 +181,24 @@ class RMGVOutputScheme {
 
     void SetEventIDOffset(int offset) { fEventIDOffset = offset; }
 
+    /**
+     * @brief Specify whether steps should be grouped into time-windowed hits while storing.
+     *
+     * @details If enabled, the steps of each event are stored ordered by hit, with an additional
+     * column marking the first step of each hit. The LH5 conversion uses this column to reshape
+     * the detector tables into hit tables (see @ref RMGConvertLH5).
+     *
+     * @param reshape True to group the steps into hits.
+     * @param time_window Maximum time difference between consecutive steps of one hit.
+     */
+    void SetReshapeHits(bool reshape, double time_window) {
+      fReshapeHits = reshape;
+      fReshapeTimeWindow = time_window;
+    }
+
     static inline std::string fUIDKeyFormatString = "det{:03}";
+    /** @brief Name of the column marking the first step of each hit in reshaped output. */
+    static inline const std::string fHitStartColumnName = "__hit_start";
 
   protected:
 
@@ -195,11 +230,44 @@ class RMGVOutputScheme {
       return fEventIDOffset + evt->GetEventID();
     }
 
+    /** @brief A step to store, with its ntuple and whether it starts a new hit. */
+    template<typename THit> struct OrderedStep {
+        THit* hit;
+        int ntuple_id;
+        bool hit_start;
+    };
+
+    /**
+     * @brief Order the steps of one event into time-windowed hits.
+     *
+     * @details If reshaping is enabled, the steps are sorted by their ntuple and by time. A new
+     * hit starts when the ntuple changes or when the time difference to the previous step is
+     * larger than the reshaping time window. Otherwise, the steps are returned unchanged.
+     */
+    template<typename THit>
+    std::vector<OrderedStep<THit>> OrderStepsIntoHits(std::vector<OrderedStep<THit>> steps) const {
+      if (!fReshapeHits) return steps;
+
+      std::stable_sort(steps.begin(), steps.end(), [](const auto& a, const auto& b) {
+        if (a.ntuple_id != b.ntuple_id) return a.ntuple_id < b.ntuple_id;
+        return a.hit->global_time < b.hit->global_time;
+      });
+      for (size_t i = 0; i < steps.size(); i++) {
+        steps[i].hit_start = i == 0 || steps[i].ntuple_id != steps[i - 1].ntuple_id ||
+                             steps[i].hit->global_time - steps[i - 1].hit->global_time >
+                                 fReshapeTimeWindow;
+      }
+      return steps;
+    }
+
     // global options injected by manager.
     bool fNtuplePerDetector = true;
     bool fNtupleUseVolumeName = false;
 
     int fEventIDOffset = 0;
+
+    bool fReshapeHits = false;
+    double fReshapeTimeWindow = 0;
 };
 
 #endif
@@ -54,6 +54,17 @@ class RMGVVertexGenerator {
     virtual void BeginOfRunAction(const G4Run*) {};
     virtual void EndOfRunAction(const G4Run*) {};
 
+    /**
+     * @brief Called before the first event of each batch of events.
+     *
+     * @details only used with @ref RMGManager::IsDynamicEventDistribution, where each process
+     * simulates batches of events that are distributed dynamically. The arguments are the global
+     * index of the first event of the batch, and the number of events in the batch. The batches
+     * of a process have increasing first events, so generators reading input files can skip
+     * forward to the input of the batch and read it here.
+     */
+    virtual void BeginOfEventBatch(size_t, size_t) {}
+
     /**
      * @brief Generate a primary vertex position.
      *
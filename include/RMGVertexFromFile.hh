@@ -17,9 +17,12 @@
 #ifndef _RMG_VERTEX_FROM_FILE_HH_
 #define _RMG_VERTEX_FROM_FILE_HH_
 
+#include <atomic>
 #include <memory>
 #include <string>
+#include <vector>
 
+#include "CLHEP/Units/SystemOfUnits.h"
 #include "G4GenericMessenger.hh"
 #include "G4ThreeVector.hh"
 
@@ -30,7 +33,9 @@
  * @brief Vertex generator that reads positions sequentially from an ntuple file.
  *
  * Each row of the ntuple supplies one @c (x, y, z) triplet. Used to replay vertices
- * produced by an external sampler (e.g. an MC truth file) into a remage run.
+ * produced by an external sampler (e.g. an MC truth file) into a remage run. The rows are read in
+ * blocks that are shared between all threads (see @ref RMGAnalysisReader::Prefetcher). Optionally,
+ * all vertices needed for the run are loaded into memory at its start.
  */
 class RMGVertexFromFile : public RMGVVertexGenerator {
 
@@ -54,15 +59,33 @@ class RMGVertexFromFile : public RMGVVertexGenerator {
     void BeginOfRunAction(const G4Run*) override;
     /** @brief Close the input file. */
     void EndOfRunAction(const G4Run*) override;
+    /** @brief Read the vertices of a batch of events claimed by this process. */
+    void BeginOfEventBatch(size_t first_event, size_t n_events) override;
 
     /** @brief Set the path of the input ntuple file. */
     void OpenFile(std::string& name);
 
   private:
 
+    static void ReadVertices(RMGAnalysisReader::Access&, std::vector<G4ThreeVector>&, size_t);
+
     static RMGAnalysisReader* fReader;
+    static RMGAnalysisReader::Prefetcher<G4ThreeVector> fPrefetcher;
+    RMGAnalysisReader::Prefetcher<G4ThreeVector>::Handle fPrefetched;
 
     inline static double fXpos = NAN, fYpos = NAN, fZpos = NAN;
+    inline static double fPosUnit = CLHEP::m;
+
+    // the vertices of the whole run, if loaded into memory.
+    bool fLoadIntoMemory = false;
+    inline static bool fUseMemoryPool = false;
+    inline static std::vector<G4ThreeVector> fMemoryPool;
+    inline static std::atomic<size_t> fMemoryPoolIndex = 0;
+
+    // the vertices of the current batch, with dynamic event distribution.
+    inline static size_t fRowsRead = 0;
+    std::vector<G4ThreeVector> fEventBatch;
+    size_t fEventBatchIndex = 0;
 
     std::unique_ptr<G4GenericMessenger> fMessenger = nullptr;
     void DefineCommands();
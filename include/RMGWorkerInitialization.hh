@@ -20,6 +20,7 @@
 
 #include "G4AutoLock.hh"
 #include "G4UserTaskThreadInitialization.hh"
+#include "G4WorkerRunManager.hh"
 #include "Randomize.hh"
 
 #include "RMGManager.hh"
@@ -59,6 +60,14 @@ class RMGWorkerInitialization : public ThreadInitialization {
       if (rmg_man->GetRandEngineSelected()) rmg_man->ApplyRandEngineForCurrentThread();
       else ThreadInitialization::SetupRNGEngine(aRNGEngine);
     }
+
+    /**
+     * @brief Create the run manager of this worker, after pinning the worker thread if requested.
+     */
+    G4WorkerRunManager* CreateWorkerRunManager() const override {
+      RMGManager::Instance()->PinWorkerThread();
+      return ThreadInitialization::CreateWorkerRunManager();
+    }
 };
 
 #endif
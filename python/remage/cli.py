@@ -17,6 +17,7 @@ from __future__ import annotations
 
 import argparse
 import contextlib
+import json
 import logging
 import os
 import random
@@ -36,7 +37,7 @@ from . import logging as rmg_logging
 from . import utils
 from ._version import __version__
 from .find_remage import find_remage_cpp
-from .ipc import IpcResult, ipc_thread_fn
+from .ipc import EventBatches, IpcResult, Telemetry, ipc_thread_fn
 from .post_proc import post_proc
 
 
@@ -44,6 +45,9 @@ def _run_remage_cpp(
     args: Sequence[str] | None = None,
     is_cli: bool = False,
     num_procs: int | None = 0,
+    event_batch_size: int | None = None,
+    fork_after_init: bool = False,
+    telemetry_report: str | None = None,
 ) -> tuple[list[int], list[signal.Signals | None], IpcResult]:
     """run the remage-cpp executable and return the exit code as seen in bash."""
     logger = logging.getLogger("remage")
@@ -77,14 +81,31 @@ def _run_remage_cpp(
     proc = []
     pipes_o = []
     num_procs = num_procs or 1
-    for proc_num in range(num_procs):
+    # with more than one process, hand out the events dynamically in batches.
+    event_batches = (
+        EventBatches(event_batch_size)
+        if event_batch_size is not None and num_procs > 1
+        else None
+    )
+    # the pipes for IPC python -> C++, one per process.
+    pipes_o_r = []
+    for _ in range(num_procs):
         pipe_o_r, pipe_o_w = os.pipe()
         os.set_inheritable(pipe_o_r, True)
         os.set_inheritable(pipe_o_w, False)
+        pipes_o_r.append(pipe_o_r)
+        pipes_o.append(pipe_o_w)
 
-        extra_args = [f"--pipe-o-fd={pipe_i_w}", f"--pipe-i-fd={pipe_o_r}"]
+    # when forking after initialization, only the first process is started here.
+    fork = fork_after_init and num_procs > 1
+    for proc_num in range(1 if fork else num_procs):
+        extra_args = [f"--pipe-o-fd={pipe_i_w}", f"--pipe-i-fd={pipes_o_r[proc_num]}"]
         if num_procs > 1:
             extra_args.append(f"--proc-num-offset={proc_num}")
+        if fork:
+            extra_args.extend(f"--fork-pipe-i-fd={fd}" for fd in pipes_o_r[1:])
+        if event_batches is not None:
+            extra_args.append("--dynamic-events")
         full_args = [str(argv[0]), *extra_args, *argv[1:]]
         msg = "Running command: " + " ".join(full_args)
         logger.debug(msg)
@@ -93,12 +114,12 @@ def _run_remage_cpp(
             subprocess.Popen(
                 full_args,
                 executable=remage_exe,
-                pass_fds=(pipe_i_w, pipe_o_r),
+                pass_fds=(pipe_i_w, *(pipes_o_r if fork else [pipes_o_r[proc_num]])),
             )
         )
-        pipes_o.append(pipe_o_w)
 
-        os.close(pipe_o_r)  # close _our_ reading end of this pipe
+    for pipe_o_r in pipes_o_r:
+        os.close(pipe_o_r)  # close _our_ reading ends of the pipes.
 
     # close _our_ writing end of the pipe.
     os.close(pipe_i_w)
@@ -125,8 +146,21 @@ def _run_remage_cpp(
     # start a thread listening for IPC messages.
     # remage-cpp will only continue to do real work after we handled one sync message.
     unhandled_ipc_messages: list = []
+    # the live progress line is only useful on a terminal.
+    telemetry = Telemetry(
+        dynamic_events=event_batches is not None,
+        stream=sys.stderr if sys.stderr.isatty() else None,
+    )
     ipc_thread = threading.Thread(
-        target=ipc_thread_fn, args=(pipe_i_r, pipes_o, proc, unhandled_ipc_messages)
+        target=ipc_thread_fn,
+        args=(
+            pipe_i_r,
+            pipes_o,
+            proc,
+            unhandled_ipc_messages,
+            event_batches,
+            telemetry,
+        ),
     )
     ipc_thread.start()
 
@@ -150,6 +184,9 @@ def _run_remage_cpp(
     if enable_watchdog_thread:
         watchdog_thread.join()
 
+    telemetry.finish()
+    _report_telemetry(telemetry, num_procs, telemetry_report)
+
     ec = [128 - p.returncode if p.returncode < 0 else p.returncode for p in proc]
     termsig = [
         signal.Signals(-p.returncode) if p.returncode < 0 else None for p in proc
@@ -157,6 +194,31 @@ def _run_remage_cpp(
     return ec, termsig, IpcResult(unhandled_ipc_messages)
 
 
+def _report_telemetry(
+    telemetry: Telemetry, num_procs: int, report_file: str | None
+) -> None:
+    logger = logging.getLogger("remage")
+
+    # the C++ application reports the throughput of each process itself.
+    for run in telemetry.runs():
+        summary = telemetry.summary(run)
+        logger.log(
+            logging.INFO if num_procs > 1 else rmg_logging.DETAIL,
+            "Run %d of all processes: %d events in %.1f s, %.4g events/s (slowest thread "
+            "%.4g events/s), %.4g steps/s",
+            run,
+            summary["events"],
+            summary["seconds"],
+            summary["events_per_second"],
+            summary["min_thread_events_per_second"],
+            summary["steps_per_second"],
+        )
+
+    if report_file is not None:
+        with Path(report_file).open("w") as f:
+            json.dump(telemetry.report(), f, indent=2)
+
+
 def watchdog_thread_fn(proc: list[subprocess.Popen]) -> None:
     """In multiprocess mode, ensures failure from one child process propagates
     to the others.
@@ -194,7 +256,11 @@ def watchdog_thread_fn(proc: list[subprocess.Popen]) -> None:
 def _cleanup_tmp_files(
     ipc_info: IpcResult, extra_tmp_files: Sequence[str | Path]
 ) -> None:
-    """Remove temporary files created by the C++ application, that might not have been cleaned up."""
+    """Remove temporary files that might not have been cleaned up.
+
+    These are the temporary output files reported by the C++ application and the
+    temporary geometry files written for pyg4ometry registries.
+    """
     tmp_files = ipc_info.get("tmpfile")
     for tmp_file in [*tmp_files, *extra_tmp_files]:
         p = Path(tmp_file)
@@ -209,6 +275,9 @@ def remage_run(
     output: str | Path | None = None,
     threads: int = 1,
     procs: int = 1,
+    event_batch_size: int | None = None,
+    fork_after_init: bool = False,
+    telemetry_report: str | Path | None = None,
     overwrite_output: bool = False,
     merge_output_files: bool = False,
     flat_output: bool = False,
@@ -236,6 +305,17 @@ def remage_run(
     procs
         set the number of processes used by remage. This cannot be combined with
         `threads`.
+    event_batch_size
+        with more than one process, distribute the events dynamically in batches of
+        this size. The number of events of ``/run/beamOn`` is then the total number of
+        events of all processes.
+    fork_after_init
+        with more than one process, only start one process, which forks the others
+        after initialization. The processes then share the memory of the geometry and
+        the physics tables.
+    telemetry_report
+        write the aggregated throughput of all threads and processes of each run to
+        this JSON file.
     overwrite_output
         overwrite existing output files.
     merge_output_files
@@ -293,6 +373,12 @@ def remage_run(
         raise ValueError(msg)
     args.append(f"--threads={threads}")
     args.append(f"--procs={procs}")
+    if event_batch_size is not None:
+        args.append(f"--event-batch-size={event_batch_size}")
+    if fork_after_init:
+        args.append("--fork-after-init")
+    if telemetry_report is not None:
+        args.append(f"--telemetry-report={telemetry_report!s}")
 
     if merge_output_files:
         args.append("--merge-output-files")
@@ -381,6 +467,32 @@ def remage_run_from_args(
             "with --threads/-t."
         ),
     )
+    parser.add_argument(
+        "--event-batch-size",
+        type=int,
+        metavar="",
+        help=(
+            "Distribute the events dynamically in batches of this size to the worker "
+            "processes. The number of events of /run/beamOn is then the total number of "
+            "events of all processes. Only used with --procs/-P."
+        ),
+    )
+    parser.add_argument(
+        "--fork-after-init",
+        action="store_true",
+        help=(
+            "Start only one process, that forks the other worker processes after "
+            "initialization. Only used with --procs/-P."
+        ),
+    )
+    parser.add_argument(
+        "--telemetry-report",
+        metavar="",
+        help=(
+            "Write the aggregated throughput of all threads and processes of each run "
+            "to this JSON file."
+        ),
+    )
     parser.add_argument(
         "--ignore-warnings",
         action="store_true",
@@ -389,7 +501,12 @@ def remage_run_from_args(
     py_args, cpp_args = parser.parse_known_args(args)
 
     ec_list, termsig, ipc_info = _run_remage_cpp(
-        cpp_args, is_cli=args is None, num_procs=py_args.procs
+        cpp_args,
+        is_cli=args is None,
+        num_procs=py_args.procs,
+        event_batch_size=py_args.event_batch_size,
+        fork_after_init=py_args.fork_after_init,
+        telemetry_report=py_args.telemetry_report,
     )
     ec: int = 1 if 1 in ec_list else max(ec_list)
 
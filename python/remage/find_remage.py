@@ -65,3 +65,20 @@ def find_remage_cpp() -> Path:
     assert assert_origin == "" or path[1] == assert_origin
 
     return path[0]
+
+
+def find_remage_merge() -> Path | None:
+    """Find the (optional) remage-merge executable.
+
+    It is looked up next to the remage-cpp executable first, and then on the system
+    PATH. Returns ``None`` if remage has been built without HDF5 support.
+    """
+    try:
+        path = find_remage_cpp().parent / "remage-merge"
+        if path.exists():
+            return path
+    except RuntimeError:
+        pass
+
+    which_result = shutil.which("remage-merge")
+    return Path(which_result) if which_result is not None else None
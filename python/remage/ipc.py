@@ -24,22 +24,34 @@ IPC message receiver implementation for ``remage-cpp``.
 Binary message format
 ---------------------
 
-Messages are encoded as UTF-8 strings; transmitting binary (non-string) data with
-this IPC mechanism is not possible.
-
-Message parts are separated using ASCII control characters. Each message ends with
-``GS`` (group separator, 0x1D) which may be optionally preceded by ``ENQ`` (enquiry,
-0x05) to indicate that the C++ process expects an acknowledgement with a POSIX signal
-before continuing.
-
-Records within a message are delimited by ``RS`` (record separator, 0x1E). Each
-message must contain at least three records. The first is the process index, for
-typical (non-multiprocessing) uses, this is always ``0``. The second is treated as
-the message's *key*, whereas the second one is the associated *value*:
-
-+-----------+-------+--------+---------+-----------+--------+
-| *proc_id* | *key* | ``RS`` | *value* | [``ENQ``] | ``GS`` |
-+-----------+-------+--------+---------+-----------+--------+
+Messages are transmitted in length-prefixed frames over a pipe, that is shared by
+all processes. Each frame starts with an 8-byte header (little-endian): the size of
+the payload as ``uint32``, the process index as ``uint16`` (for typical
+(non-multiprocessing) uses, this is always ``0``) and a ``uint8`` with flags,
+followed by a padding byte.
+
++--------------+------------+---------+---------+-----------+
+| payload size | *proc_id*  | flags   | padding | payload   |
++--------------+------------+---------+---------+-----------+
+
+The flag ``0x1`` marks blocking messages, for which the C++ process expects an
+acknowledgement before continuing. Frames, including their header, are never larger
+than ``PIPE_BUF``, so that they are written atomically and do not interleave with
+the frames of other processes. Longer messages are split into several frames, all
+but the last one having the flag ``0x2`` (continued). The frames of a message are
+joined for each process.
+
+Non-blocking messages are buffered in the C++ process, and written to the pipe
+together with the next blocking message, or at the end of a run.
+
+The payload of a message is encoded as a UTF-8 string. Records within a message are
+delimited by ``RS`` (record separator, 0x1E). Each message must contain at least
+two records. The first is treated as the message's *key*, whereas the second one is
+the associated *value*:
+
++-------+--------+---------+
+| *key* | ``RS`` | *value* |
++-------+--------+---------+
 
 More values can follow afterwards, again delimited by ``RS``.
 
@@ -48,9 +60,9 @@ with more then one unit are returned as tuples on the python side.
 
 Example: A message
 
-+-----------+-------+--------+--------+--------+--------+--------+--------+-----------+--------+
-| *proc_id* | *key* | ``RS`` | value0 | ``RS`` | value1 | ``US`` | value2 | [``ENQ``] | ``GS`` |
-+-----------+-------+--------+--------+--------+--------+--------+--------+-----------+--------+
++-------+--------+--------+--------+--------+--------+--------+
+| *key* | ``RS`` | value0 | ``RS`` | value1 | ``US`` | value2 |
++-------+--------+--------+--------+--------+--------+--------+
 
 would be decoded to :code:`["value0", ("value1", "value2")]`.
 
@@ -63,7 +75,31 @@ Blocking messages need to be acknowledged by sending ASCII ACK over the second p
 associated action (example: checking version equality of python and C++ IPC sides,
 pre-processing files).
 
-Transmitting additional response data with the acknowledgement is not possible.
+Response data for the C++ process can be sent directly before the ``ACK``. It is
+encoded like the records of a message, but must not contain ``ACK`` itself.
+
+
+Dynamic event distribution
+--------------------------
+
+With dynamic event distribution, each ``remage-cpp`` process requests batches of
+events with the blocking message ``event_batch``, with the run ID and the total
+number of events of the run as values. The response holds the global index of the
+first event and the number of events of the batch, separated by ``US``. A batch
+with zero events signals that all events of the run have been handed out.
+
+
+Telemetry
+---------
+
+Each thread that processes events periodically sends the non-blocking message
+``telemetry``, and once more at the end of each run. Its value holds, separated by
+``US``: the thread index, the run ID, the number of events to process in this run
+(by the whole process), the number of events and steps processed by this thread,
+the elapsed time in seconds since the start of the run, the bytes written by this
+thread and the resident memory of the process in bytes, and ``1`` for the final
+message of the run (``0`` otherwise). These messages are aggregated by
+:class:`Telemetry`.
 """
 
 from __future__ import annotations
@@ -71,19 +107,220 @@ from __future__ import annotations
 import logging
 import os
 import signal
+import struct
 import subprocess
+import time
 from collections import defaultdict
-from typing import Literal, overload
+from typing import Literal, TextIO, overload
 
 from ._version import __version__
 
 log = logging.getLogger("remage")
 
+# payload size, process index, flags and a padding byte.
+FRAME_HEADER = struct.Struct("<IHBx")
+FLAG_BLOCKING = 0x1
+FLAG_CONTINUED = 0x2
+
+
+class EventBatches:
+    def __init__(self, batch_size: int):
+        """Hand out batches of events of each run to the ``remage-cpp`` processes.
+
+        Parameters
+        ----------
+        batch_size
+            the maximum number of events in each batch.
+        """
+        self.batch_size = max(batch_size, 1)
+        self.next_event: dict[int, int] = {}
+
+    def claim(self, run_id: int, total: int) -> tuple[int, int]:
+        """Claim the next batch of events of a run with ``total`` events.
+
+        Returns
+        -------
+        tuple[int, int]
+            ``(first_event, n_events)``, with ``n_events == 0`` if the run is complete.
+        """
+        first = self.next_event.get(run_id, 0)
+        n_events = max(min(self.batch_size, total - first), 0)
+        self.next_event[run_id] = first + n_events
+        return first, n_events
+
+
+class Telemetry:
+    def __init__(
+        self,
+        dynamic_events: bool = False,
+        stream: TextIO | None = None,
+        interval: float = 1.0,
+    ):
+        """Aggregate the throughput reports of all ``remage-cpp`` threads and processes.
+
+        Parameters
+        ----------
+        dynamic_events
+            whether the events are distributed dynamically to the processes. Then each
+            process reports the total number of events of the run, otherwise its share.
+        stream
+            if not ``None``, a live progress line is written to this stream (which
+            should be a terminal).
+        interval
+            the minimum time between two updates of the progress line, in seconds.
+        """
+        self.dynamic_events = dynamic_events
+        self.stream = stream
+        self.interval = interval
+        # the latest report of each thread, keyed by (run, proc, thread).
+        self.threads: dict[tuple[int, int, int], dict] = {}
+        self._last_print = 0.0
+        self._line_len = 0
+
+    def update(self, proc_num: int, values: tuple[str, ...]) -> None:
+        """Store a ``telemetry`` message of the process ``proc_num``."""
+        thread, run, run_events, events, steps, seconds, nbytes, rss, final = values
+        elapsed = float(seconds)
+        self.threads[(int(run), proc_num, int(thread))] = {
+            "proc": proc_num,
+            "thread": int(thread),
+            "run_events": int(run_events),
+            "events": int(events),
+            "steps": int(steps),
+            "seconds": elapsed,
+            "events_per_second": int(events) / elapsed if elapsed > 0 else 0.0,
+            "steps_per_second": int(steps) / elapsed if elapsed > 0 else 0.0,
+            "output_bytes": int(nbytes),
+            "rss_bytes": int(rss),
+            "final": final == "1",
+        }
+        self.print_progress()
+
+    def runs(self) -> list[int]:
+        """Return the IDs of all runs with reports."""
+        return sorted({run for run, _, _ in self.threads})
+
+    def summary(self, run: int) -> dict:
+        """Aggregate the latest reports of all threads of a run."""
+        threads = [t for (r, _, _), t in sorted(self.threads.items()) if r == run]
+        # the memory and the number of events of a run are reported per process.
+        per_proc: dict[int, dict] = {}
+        for t in threads:
+            p = per_proc.setdefault(t["proc"], {"rss_bytes": 0, "run_events": 0})
+            p["rss_bytes"] = max(p["rss_bytes"], t["rss_bytes"])
+            p["run_events"] = max(p["run_events"], t["run_events"])
+        run_events = [p["run_events"] for p in per_proc.values()]
+        rates = [t["events_per_second"] for t in threads]
+
+        return {
+            "run_id": run,
+            "events": sum(t["events"] for t in threads),
+            "events_total": max(run_events) if self.dynamic_events else sum(run_events),
+            "steps": sum(t["steps"] for t in threads),
+            "seconds": max(t["seconds"] for t in threads),
+            "events_per_second": sum(rates),
+            "min_thread_events_per_second": min(rates),
+            "steps_per_second": sum(t["steps_per_second"] for t in threads),
+            "output_bytes": sum(t["output_bytes"] for t in threads),
+            "rss_bytes": sum(p["rss_bytes"] for p in per_proc.values()),
+            "complete": all(t["final"] for t in threads),
+            "threads": threads,
+        }
+
+    def report(self) -> dict:
+        """Return the aggregated reports of all runs, e.g. to be stored as JSON."""
+        return {"runs": [self.summary(run) for run in self.runs()]}
+
+    def progress_line(self) -> str:
+        """Format the aggregated progress of the latest run as a single line."""
+        s = self.summary(self.runs()[-1])
+        percent = (
+            f" ({100 * s['events'] / s['events_total']:.0f}%)"
+            if s["events_total"] > 0
+            else ""
+        )
+        return (
+            f"run {s['run_id']}: {s['events']}/{s['events_total']} events{percent}, "
+            f"{s['events_per_second']:.4g} events/s, {s['steps_per_second']:.4g} steps/s, "
+            f"{_format_bytes(s['output_bytes'])} written, "
+            f"{_format_bytes(s['rss_bytes'])} RSS, {len(s['threads'])} threads"
+        )
+
+    def print_progress(self, force: bool = False) -> None:
+        """Update the live progress line, at most once per interval."""
+        if self.stream is None or not self.threads:
+            return
+        now = time.monotonic()
+        if not force and now - self._last_print < self.interval:
+            return
+        self._last_print = now
+        line = self.progress_line()
+        self.stream.write("\r" + line.ljust(self._line_len))
+        self.stream.flush()
+        self._line_len = len(line)
+
+    def finish(self) -> None:
+        """End the live progress line, after the final update."""
+        if self._line_len > 0:
+            self.print_progress(force=True)
+            self.stream.write("\n")  # type: ignore[union-attr]
+            self.stream.flush()  # type: ignore[union-attr]
+            self._line_len = 0
+
+
+def _format_bytes(n: float) -> str:
+    for unit in ("B", "kB", "MB", "GB"):
+        if n < 1000:
+            return f"{n:.3g} {unit}"
+        n /= 1000
+    return f"{n:.3g} TB"
+
+
+class FrameReader:
+    def __init__(self):
+        """Split the byte stream read from the IPC pipe into messages."""
+        self.buf = bytearray()
+        # the frames of incomplete messages, for each process.
+        self.partial: dict[int, list[bytes]] = defaultdict(list)
+
+    def feed(self, data: bytes) -> list[tuple[int, bool, str]]:
+        """Add data read from the pipe.
+
+        Returns
+        -------
+        list[tuple[int, bool, str]]
+            all messages completed by this data, as ``(proc_num, is_blocking, msg)``
+            with the UTF-8 decoded payload ``msg``.
+        """
+        self.buf += data
+        msgs = []
+        pos = 0
+        while len(self.buf) - pos >= FRAME_HEADER.size:
+            size, proc_num, flags = FRAME_HEADER.unpack_from(self.buf, pos)
+            end = pos + FRAME_HEADER.size + size
+            if end > len(self.buf):
+                break  # not a full frame yet.
+            self.partial[proc_num].append(
+                bytes(self.buf[pos + FRAME_HEADER.size : end])
+            )
+            pos = end
+            if not flags & FLAG_CONTINUED:
+                payload = b"".join(self.partial.pop(proc_num))
+                msgs.append(
+                    (proc_num, bool(flags & FLAG_BLOCKING), payload.decode("utf-8"))
+                )
+        del self.buf[:pos]
+        return msgs
+
 
 def handle_ipc_message(
     msg: str,
+    proc_num: int,
+    is_blocking: bool,
     proc: list[subprocess.Popen],
-) -> tuple[bool, list | None, bool, int]:
+    event_batches: EventBatches | None = None,
+    telemetry: Telemetry | None = None,
+) -> tuple[list | None, bool, str]:
     """Parse a already UTF-8 decoded IPC message from ``remage-cpp``.
 
     This function should directly handle all known blocking IPC messages, which
@@ -92,22 +329,26 @@ def handle_ipc_message(
     Parameters
     ----------
     msg
-        The raw message bytes decoded to UTF-8, still including the trailing separator(s).
+        The payload of the message, decoded to UTF-8.
+    proc_num
+        The index of the subprocess that sent the message.
+    is_blocking
+        Whether the sender waits for a reply.
+    proc
+        The subprocess(es) running ``remage-cpp``.
+    event_batches
+        The event batches to hand out, only with dynamic event distribution.
+    telemetry
+        The aggregated telemetry to update.
 
     Returns
     -------
-    tuple[bool, list | None, bool, int]
-        ``(is_blocking, parsed_message, is_fatal)`` where ``is_blocking`` is
-        ``True`` when the sender waits for a reply, ``parsed_message`` is the
-        decoded message or ``None`` if it was consumed internally, and
-        ``is_fatal`` signals that the application should terminate.
-        ``proc_num`` is the index of the subprocess.
+    tuple[list | None, bool, str]
+        ``(parsed_message, is_fatal, response)`` where ``parsed_message`` is the
+        decoded message or ``None`` if it was consumed internally, ``is_fatal``
+        signals that the application should terminate, and ``response`` is the data
+        to send back with the acknowledgement of a blocking message.
     """
-    is_blocking = False
-    msg = msg[0:-1]  # strip trailing ASCII GS ("group separator")
-    if msg[-1] == "\x05":  # ASCII ENQ ("enquiry")
-        msg = msg[0:-1]
-        is_blocking = True
     records = msg.split("\x1e")  # ASCII RS ("record separator")
     split_records = [
         record.split("\x1f") for record in records
@@ -116,16 +357,34 @@ def handle_ipc_message(
         tuple(record) if len(record) > 1 else record[0] for record in split_records
     ]
 
-    # first field is process number.
+    # first field is the key.
     assert len(fields) > 1
-    assert isinstance(fields[0], str)  # proc_id is always a single string, not a tuple
-    proc_num = int(fields[0])
-    fields = fields[1:]
+    assert isinstance(fields[0], str)
 
     msg_ret: list | None = fields
     is_fatal = False
-
-    if is_blocking:
+    response = ""
+
+    if not is_blocking and fields[0] == "telemetry":
+        # these are only used for the live progress, and are not stored.
+        if telemetry is not None:
+            assert isinstance(fields[1], tuple)
+            telemetry.update(proc_num, fields[1])
+        msg_ret = None
+    elif is_blocking and fields[0] == "event_batch":
+        # this only touches state of the python side, the other processes can continue.
+        if event_batches is None:
+            log.error(
+                "remage-cpp requested events, but no event batches are configured"
+            )
+            is_fatal = True
+        else:
+            assert isinstance(fields[1], str)
+            assert isinstance(fields[2], str)
+            first, n_events = event_batches.claim(int(fields[1]), int(fields[2]))
+            response = f"{first}\x1f{n_events}"
+        msg_ret = None
+    elif is_blocking:
         if len(proc) > 1:
             # pause all C++ processes in multi-process mode.
             for p in proc:
@@ -158,7 +417,7 @@ def handle_ipc_message(
             # resume all C++ processes in multi-process mode.
             for p in proc:
                 p.send_signal(signal.SIGCONT)
-    return is_blocking, msg_ret, is_fatal, proc_num
+    return msg_ret, is_fatal, response
 
 
 def ipc_thread_fn(
@@ -166,6 +425,8 @@ def ipc_thread_fn(
     pipes_o_w: list[int],
     proc: list[subprocess.Popen],
     unhandled_ipc_messages: list,
+    event_batches: EventBatches | None = None,
+    telemetry: Telemetry | None = None,
 ) -> None:
     """Read and handle IPC messages coming from ``remage-cpp``.
 
@@ -176,10 +437,9 @@ def ipc_thread_fn(
         value, as thread functions cannot directly return.
 
 
-    The function reads from the pipe file descriptor ``pipe_r`` and dispatches
-    each complete IPC message to :func:`handle_ipc_message` for parsing and
-    handling of the associated action. Any message parts will be decoded as
-    UTF-8 before parsing.
+    The function reads from the pipe file descriptor ``pipe_r``, splits the data into
+    messages with :class:`FrameReader` and dispatches each complete IPC message to
+    :func:`handle_ipc_message` for parsing and handling of the associated action.
 
     Blocking messages are acknowledged by sending ASCII ACK over the second pipe
     (per-process file descriptor).
@@ -195,31 +455,22 @@ def ipc_thread_fn(
     unhandled_ipc_messages
         List that will receive messages which were not directly handled (i.e.,
         for further processing)
+    event_batches
+        The event batches to hand out, only with dynamic event distribution.
+    telemetry
+        The aggregated telemetry to update.
     """
     try:
-        msg_buf = b""
+        reader = FrameReader()
         with os.fdopen(pipe_r, "br", 0) as pipe_file:
             while True:
-                line = pipe_file.read(1024)
-                if not line:
+                data = pipe_file.read(65536)
+                if not data:
                     return
 
-                msg_buf += line
-                if b"\x1d" not in msg_buf:
-                    # not a full message yet.
-                    continue
-
-                # handle message buffer.
-                for _ in range(msg_buf.count(b"\x1d")):
-                    msg_end = msg_buf.index(b"\x1d") + 1
-                    # note: switching between binary and strting mode is safe here. ASCII
-                    # bytes are binary equal to their utf-8 encoding, and their bytes will
-                    # not be part of any utf-8 multibyte sequence.
-                    msg = msg_buf[0:msg_end].decode("utf-8")
-                    msg_buf = msg_buf[msg_end:]
-
-                    is_blocking, unhandled_msg, is_fatal, proc_id = handle_ipc_message(
-                        msg, proc
+                for proc_id, is_blocking, msg in reader.feed(data):
+                    unhandled_msg, is_fatal, response = handle_ipc_message(
+                        msg, proc_id, is_blocking, proc, event_batches, telemetry
                     )
                     if unhandled_msg is not None:
                         unhandled_ipc_messages.append(unhandled_msg)
@@ -230,7 +481,9 @@ def ipc_thread_fn(
                             p.send_signal(signal.SIGTERM)
                     elif is_blocking:
                         # send continuation message, only to this process.
-                        os.write(pipes_o_w[proc_id], b"\x06")  # ASCII ACK
+                        os.write(
+                            pipes_o_w[proc_id], response.encode("utf-8") + b"\x06"
+                        )  # ASCII ACK
     except OSError as e:
         if e.errno in (9, 32):  # bad file descriptor or broken pipe.
             return
@@ -16,6 +16,7 @@
 from __future__ import annotations
 
 import logging
+import subprocess
 import time
 from contextlib import contextmanager
 from pathlib import Path
@@ -28,6 +29,7 @@ from lgdo import Array, Scalar, Struct
 from lh5.io.concat import lh5concat
 
 from . import utils
+from .find_remage import find_remage_merge
 from .ipc import IpcResult
 from .reshaping import reshape_output
 
@@ -79,12 +81,27 @@ def post_proc(
     if flat_output and not merge_output_files:
         return
 
+    # the worker threads might have already appended their output to the main output
+    # file (/RMG/Output/MergeThreadFiles), or there was only one thread. Then there is
+    # nothing left to merge.
+    already_merged = set(remage_files) == {main_output_file}
+
+    # remage-cpp might have already grouped the steps into hits (/RMG/Output/ReshapeHits).
+    # in this case, it also informs us about the time window that was used.
+    reshape_time_window: str | None = ipc_info.get_single("output_reshaped")
+    if reshape_time_window is not None:
+        time_window_in_us = float(reshape_time_window)
+    reshape_in_post_proc = not flat_output and reshape_time_window is None
+
     # RMGConvertLH5 informs up about where the soft links to output tables are stored
     # we are going to use them to build the TCM
     lh5_links_group_name: str = (
         det_tables_path + "/" + ipc_info.get("lh5_links_group_name")[0]
     )
     lh5_event_number_name: str = "/" + ipc_info.get("lh5_event_number_name")[0]
+    # RMGConvertLH5 only informs us about the event index group if it has been
+    # requested (/RMG/Output/EventIndex)
+    lh5_index_group_name: str | None = ipc_info.get_single("lh5_index_group_name")
 
     time_start = time.time()
 
@@ -93,7 +110,7 @@ def post_proc(
         remage_files if not merge_output_files else main_output_file
     )
 
-    if not flat_output:
+    if reshape_in_post_proc:
         msg = (
             "Reshaping "
             + ("and merging " if merge_output_files else "")
@@ -137,9 +154,11 @@ def post_proc(
                 reshape_tables=reshape_detectors,
                 forward_tables=extra_tables,
                 flat_hit_tables=flat_hit_detectors,
+                in_field=det_tables_path,
                 out_field=det_tables_path,
                 time_window_in_us=time_window_in_us,
                 overwrite=overwrite_output,
+                index_group=lh5_index_group_name,
             )
 
             # also copy __by_uid__ group to the output files
@@ -150,6 +169,50 @@ def post_proc(
                 original_files, output_files, lh5_event_number_name
             )
 
+        # the reshaped tables have a different number of rows, re-build their index.
+        if lh5_index_group_name is not None:
+            write_event_index(output_files, det_tables_path, lh5_index_group_name)
+
+    if not reshape_in_post_proc and merge_output_files and not already_merged:
+        msg = "Merging output files"
+        log.info(msg)
+
+        merge_exe = find_remage_merge()
+
+        with tmp_renamed_files(remage_files) as original_files:
+            if merge_exe is not None:
+                # the native tool also handles links, event numbers and deduplication.
+                merge_native(
+                    merge_exe,
+                    original_files,
+                    main_output_file,
+                    overwrite_output,
+                    ipc_info.get("output_ntuple_deduplicate"),
+                )
+            else:
+                lh5concat(
+                    lh5_files=original_files,
+                    output=main_output_file,
+                    overwrite=overwrite_output,
+                    exclude_list=[
+                        f"{lh5_links_group_name}/*",
+                        f"{lh5_event_number_name}/*",
+                    ],
+                )
+                # also copy __by_uid__ group to the output files
+                # we do this here and not in reboost, as lh5concat does not copy links correctly.
+                # NOTE: using just the first original file since the links are always the same
+                copy_links(original_files[0], main_output_file, lh5_links_group_name)
+                update_number_of_simulated_events(
+                    original_files, output_files, lh5_event_number_name
+                )
+                # the row numbers in the concatenated index tables are not valid anymore.
+                if lh5_index_group_name is not None:
+                    write_event_index(
+                        main_output_file, det_tables_path, lh5_index_group_name
+                    )
+
+    if not flat_output:
         # add a time-coincidence map to the output file(s)
         msg = "Computing and storing the TCM as /tcm"
         log.info(msg)
@@ -170,32 +233,8 @@ def post_proc(
                     wo_mode="write_safe",
                 )
 
-        # set the output file(s) for downstream consumers.
-        ipc_info.set("output", output_files)
-
-    if flat_output and merge_output_files:
-        msg = "Merging output files"
-        log.info(msg)
-
-        with tmp_renamed_files(remage_files) as original_files:
-            lh5concat(
-                lh5_files=original_files,
-                output=main_output_file,
-                overwrite=overwrite_output,
-                exclude_list=[
-                    f"{lh5_links_group_name}/*",
-                    f"{lh5_event_number_name}/*",
-                ],
-            )
-            # also copy __by_uid__ group to the output files
-            # we do this here and not in reboost, as lh5concat does not copy links correctly.
-            # NOTE: using just the first original file since the links are always the same
-            copy_links(original_files[0], main_output_file, lh5_links_group_name)
-            update_number_of_simulated_events(
-                original_files, output_files, lh5_event_number_name
-            )
-
-        ipc_info.set("output", main_output_file)
+    # set the output file(s) for downstream consumers.
+    ipc_info.set("output", output_files)
 
     # deduplicate entries of the process table.
     ntuples_to_deduplicate = set(ipc_info.get("output_ntuple_deduplicate"))
@@ -207,6 +246,26 @@ def post_proc(
     log.info(msg)
 
 
+def merge_native(
+    merge_exe: Path,
+    original_files: list[str],
+    output_file: str,
+    overwrite: bool,
+    dedup_tables: list[str],
+) -> None:
+    """Merge LH5 files with the native ``remage-merge`` executable."""
+    cmd = [str(merge_exe), "-o", output_file]
+    if overwrite:
+        cmd.append("--overwrite")
+    for table in dict.fromkeys(dedup_tables):
+        cmd += ["--deduplicate", table]
+    cmd += ["--", *original_files]
+
+    msg = f"Running {' '.join(cmd)}"
+    log.debug(msg)
+    subprocess.run(cmd, check=True)
+
+
 def copy_links(
     original_file: str, output_files: str | list[str], lh5_links_group_name: str
 ) -> None:
@@ -235,6 +294,52 @@ def copy_links(
                         del links_group[link_name]
 
 
+def write_event_index(
+    output_files: str | list[str], det_tables_path: str, index_group_name: str
+) -> None:
+    """(Re-)build the event index of all detector tables in the output files.
+
+    For each table with an ``evtid`` column, the index table of the same name
+    has one row per event with the columns ``evtid``, ``first_row`` and
+    ``n_rows``. This is the same layout as written by remage-cpp.
+    """
+    for file in utils._to_list(output_files):
+        with h5py.File(file, "a") as ouf:
+            if det_tables_path not in ouf:
+                continue
+            det_group = ouf[det_tables_path]
+            if index_group_name in det_group:
+                del det_group[index_group_name]
+
+            tables = sorted(
+                name
+                for name, obj in det_group.items()
+                if isinstance(obj, h5py.Group)
+                and isinstance(obj.get("evtid"), h5py.Dataset)
+            )
+            if not tables:
+                continue
+
+            index_group = det_group.create_group(index_group_name)
+            index_group.attrs["datatype"] = "struct{" + ",".join(tables) + "}"
+            for table in tables:
+                evtid = det_group[table]["evtid"][:]
+                first_row = np.flatnonzero(np.diff(evtid, prepend=np.nan)).astype(
+                    np.int64
+                )
+                n_rows = np.diff(np.append(first_row, len(evtid))).astype(np.int64)
+
+                index_table = index_group.create_group(table)
+                index_table.attrs["datatype"] = "table{evtid,first_row,n_rows}"
+                for name, data in (
+                    ("evtid", evtid[first_row]),
+                    ("first_row", first_row),
+                    ("n_rows", n_rows),
+                ):
+                    dset = index_table.create_dataset(name, data=data, maxshape=(None,))
+                    dset.attrs["datatype"] = "array<1>{real}"
+
+
 def update_number_of_simulated_events(
     original_files: list[str], output_files: str | list[str], lh5_event_number_name: str
 ) -> None:
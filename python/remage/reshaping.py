@@ -35,9 +35,11 @@ def reshape_output(
     forward_tables: Sequence[str],
     out_field: str,
     time_window_in_us: float,
+    in_field: str = "stp",
     flat_hit_tables: Sequence[str] = (),
     overwrite: bool = False,
     buffer: int = int(5e6),
+    index_group: str | None = None,
 ) -> None:
     """Post-process remage step files into reshaped hit files.
 
@@ -63,6 +65,8 @@ def reshape_output(
         lh5 group under which reshaped detector tables are written.
     time_window_in_us
         coincidence time window in microseconds for hit grouping.
+    in_field
+        lh5 group holding the detector tables in the step files.
     flat_hit_tables
         detector tables that already contain one hit per detector per event
         (e.g. calorimeter output) and must not be step-grouped. They are written
@@ -72,6 +76,10 @@ def reshape_output(
         whether to overwrite the output files.
     buffer
         buffer size (in rows) for the lh5 iterator.
+    index_group
+        name of the group inside ``in_field`` holding the event index tables written
+        by remage (``/RMG/Output/EventIndex``). If present for a table, the
+        event boundaries are taken from it instead of the full evtid column.
     """
     hit_files_list = (
         [hit_files] * len(stp_files) if isinstance(hit_files, str) else list(hit_files)
@@ -95,13 +103,19 @@ def reshape_output(
         n_det_written = 0
 
         for detector in reshape_tables:
-            table = f"stp/{detector}"
+            table = f"{in_field}/{detector}"
             if lh5.ls(stp_file, table) == []:
                 continue
 
+            index_table = None
+            if index_group is not None:
+                index_table = f"{in_field}/{index_group}/{detector}"
+                if lh5.ls(stp_file, index_table) == []:
+                    index_table = None
+
             wrote_any = False
             for chunk_idx, stps in enumerate(
-                _iter_event_aligned_chunks(stp_file, table, buffer)
+                _iter_event_aligned_chunks(stp_file, table, buffer, index_table)
             ):
                 hit_table = _group_by_time(
                     stps.view_as("ak", with_units=True),
@@ -129,7 +143,7 @@ def reshape_output(
                 n_det_written += 1
 
         for detector in flat_hit_tables:
-            table = f"stp/{detector}"
+            table = f"{in_field}/{detector}"
             if lh5.ls(stp_file, table) == []:
                 continue
 
@@ -227,29 +241,39 @@ def _iter_chunks(stp_file: str, table: str, buffer: int):
         start += n_rows
 
 
-def _iter_event_aligned_chunks(stp_file: str, table: str, buffer: int):
+def _iter_event_aligned_chunks(
+    stp_file: str, table: str, buffer: int, index_table: str | None = None
+):
     """Yield ``buffer``-sized chunks of ``table`` aligned to evtid boundaries.
 
     All steps of a given evtid stay in the same chunk, so each chunk can be
-    grouped into hits independently. The full evtid column is read once up front
-    to compute the split points.
+    grouped into hits independently. The split points are taken from the event
+    index table ``index_table``, if given. Otherwise, the full evtid column is
+    read once up front to compute them.
 
-    This relies on remage writing evtids monotonically increasing.
+    This relies on remage writing all steps of an event contiguously. The
+    evtids do not need to be increasing (i.e. for files written by multiple
+    threads, see ``/RMG/Output/MergeThreadFiles``).
     """
     n_total = lh5.read_n_rows(f"{table}/evtid", stp_file) or 0
     if n_total == 0:
         return
 
-    evtids = lh5.read(f"{table}/evtid", stp_file).nda
-    diffs = np.diff(evtids)
-    if np.any(diffs < 0):
-        msg = (
-            f"evtids in {table} of {stp_file} are not monotonically increasing: "
-            "an event's steps would span separate blocks, breaking per-chunk "
-            "hit grouping"
-        )
-        raise ValueError(msg)
-    event_starts = np.concatenate(([0], np.flatnonzero(diffs) + 1, [n_total]))
+    if index_table is not None:
+        first_rows = np.sort(lh5.read_as(f"{index_table}/first_row", stp_file, "np"))
+        event_starts = np.concatenate((first_rows, [n_total]))
+    else:
+        evtids = lh5.read(f"{table}/evtid", stp_file).nda
+        diffs = np.diff(evtids)
+        run_starts = np.flatnonzero(diffs) + 1
+        if np.any(diffs < 0) and len(np.unique(evtids)) != len(run_starts) + 1:
+            msg = (
+                f"evtids in {table} of {stp_file} are not monotonically increasing "
+                "and the steps of an event are not contiguous: an event's steps "
+                "would span separate blocks, breaking per-chunk hit grouping"
+            )
+            raise ValueError(msg)
+        event_starts = np.concatenate(([0], run_starts, [n_total]))
 
     start = 0
     while start < n_total:
@@ -16,7 +16,6 @@
 #include "RMGAnalysisReader.hh"
 
 #include <filesystem>
-#include <random>
 namespace fs = std::filesystem;
 
 #include "G4AnalysisUtilities.hh"
@@ -29,11 +28,9 @@ namespace fs = std::filesystem;
 #include "G4XmlAnalysisReader.hh"
 
 #if RMG_HAS_HDF5
-#include "RMGConvertLH5.hh"
+#include "RMGLH5Reader.hh"
 #endif
-#include "RMGIpc.hh"
 #include "RMGLog.hh"
-#include "RMGOutputManager.hh"
 
 G4Mutex RMGAnalysisReader::fMutex = G4MUTEX_INITIALIZER;
 
@@ -79,9 +76,8 @@ RMGAnalysisReader::Access RMGAnalysisReader::OpenFile(
   invalid_lock.release();
   auto invalid_access = RMGAnalysisReader::Access(std::move(invalid_lock), nullptr, -1, nullptr, false);
 
-  if (fReader) return invalid_access;
+  if (fReader || fLH5Reader) return invalid_access;
 
-  fFileIsTemp = false;
   fFileName = file_name;
   auto path = fs::path(file_name);
 
@@ -90,8 +86,6 @@ RMGAnalysisReader::Access RMGAnalysisReader::OpenFile(
     return invalid_access;
   }
 
-  std::map<std::string, std::map<std::string, std::string>> units_map{};
-
   auto ext = !force_ext.empty() ? force_ext : G4Analysis::GetExtension(file_name);
   if (ext == "root") {
     fReader = G4RootAnalysisReader::Instance();
@@ -103,44 +97,17 @@ RMGAnalysisReader::Access RMGAnalysisReader::OpenFile(
 #endif
   } else if (ext == "lh5") {
 #if RMG_HAS_HDF5
-    std::uniform_int_distribution<int> dist(10000, 99999);
-    std::random_device rd;
-    std::string new_fn = ".rmg-vtx-" + std::to_string(dist(rd)) + "." + path.stem().string() +
-                         ".hdf5";
-    auto rmg_man = RMGOutputManager::Instance();
-    fs::path new_path = fs::path(new_fn);
-    if (!rmg_man->HasOutputFileNameNone())
-      new_path = fs::path(rmg_man->GetOutputFileName()).parent_path() / new_path;
-
-    std::error_code ec;
-    if (!fs::copy_file(path, new_path, ec)) {
-      RMGLog::Out(
-          RMGLog::error,
-          "copy of input file ",
-          file_name,
-          " failed. Does it exist? (",
-          ec.message(),
-          ")"
-      );
-      return invalid_access;
-    }
-    RMGIpc::SendIpcNonBlocking(RMGIpc::CreateMessage("tmpfile", new_path.string()));
-
-    auto result = RMGConvertLH5::ConvertFromLH5(new_path.string(), ntuple_dir_name, false, false, units_map);
-    if (!result) {
-      RMGLog::Out(
-          RMGLog::error,
-          "Conversion of input file ",
-          new_path.string(),
-          " to LH5 failed. Data is potentially corrupted."
-      );
+    // LH5 tables are read directly, without a G4VAnalysisReader.
+    fLH5Reader = RMGLH5Reader::Open(file_name, ntuple_dir_name, ntuple_name, fUnits);
+    if (!fLH5Reader) {
+      // the units of the columns read before the failure might already have been filled in.
+      fUnits = {};
+      RMGLog::Out(RMGLog::error, "Could not open table '", ntuple_name, "' in input file!");
       return invalid_access;
     }
-
     fHasUnits = true;
-    fFileName = new_path.string();
-    fReader = G4Hdf5AnalysisReader::Instance();
-    fFileIsTemp = true;
+    fNtupleId = 0;
+    return {std::move(lock), nullptr, fNtupleId, &fUnits, true, fLH5Reader.get()};
 #else
     RMGLog::Out(RMGLog::fatal, "HDF5 input not available, please recompile Geant4 with HDF5 support");
 #endif
@@ -153,14 +120,14 @@ RMGAnalysisReader::Access RMGAnalysisReader::OpenFile(
   }
 
   if (RMGLog::GetLogLevel() <= RMGLog::debug) fReader->SetVerboseLevel(10);
+  fOpenedG4ReaderFile = true;
 
   fNtupleId = fReader->GetNtuple(ntuple_name, fFileName, ntuple_dir_name);
   if (fNtupleId < 0) {
     RMGLog::Out(RMGLog::error, "Ntuple named '", ntuple_name, "' could not be found in input file!");
     return invalid_access;
   }
-  fUnits = units_map[ntuple_name];
-  return {std::move(lock), fReader, fNtupleId, fHasUnits ? &fUnits : nullptr, true};
+  return {std::move(lock), fReader, fNtupleId, nullptr, true};
 }
 
 void RMGAnalysisReader::CloseFile() {
@@ -171,27 +138,30 @@ void RMGAnalysisReader::CloseFile() {
 
   G4AutoLock lock(&fMutex);
 
-  if (!fReader) return;
+  if (!fReader && !fLH5Reader) return;
 
   // fReader is a thread-local singleton. Do not delete it here, otherwise geant4 will to delete it
   // again. also do not close files, as there is no way to close a specific file only.
   fReader = nullptr;
-  if (fFileIsTemp) {
-    std::error_code ec;
-    fs::remove(fs::path(fFileName), ec);
-  }
+  fLH5Reader.reset();
   fFileName = "";
-  fFileIsTemp = false;
   fNtupleId = -1;
   fHasUnits = false;
-  fHasUnits = {};
+  fUnits = {};
 }
 
 RMGAnalysisReader::Access RMGAnalysisReader::GetLockedReader() const {
 
   G4AutoLock lock(&fMutex);
 
-  return {std::move(lock), fReader, fNtupleId, fHasUnits ? &fUnits : nullptr, false};
+  return {
+      std::move(lock),
+      fReader,
+      fNtupleId,
+      fHasUnits ? &fUnits : nullptr,
+      false,
+      fLH5Reader.get()
+  };
 }
 
 G4AutoLock RMGAnalysisReader::GetLock() const {
@@ -209,6 +179,77 @@ G4AutoLock RMGAnalysisReader::GetLock() const {
 
 /* ========================================================================================== */
 
+void RMGAnalysisReader::Access::Seek(size_t offset) {
+  AssertSetup(false);
+#if RMG_HAS_HDF5
+  if (fLH5Reader) {
+    fLH5Reader->Skip(offset);
+    return;
+  }
+#endif
+  for (size_t i = 0; i < offset; i++) fReader->GetNtupleRow(fNtupleId);
+}
+
+bool RMGAnalysisReader::Access::SeekToEvent(size_t event, const std::string& count_column) {
+  AssertSetup(false);
+#if RMG_HAS_HDF5
+  if (fLH5Reader) {
+    const auto row = fLH5Reader->FindEventStart(count_column, event);
+    if (!row) return false;
+    fLH5Reader->Seek(*row);
+    return true;
+  }
+#endif
+  return false;
+}
+
+G4bool RMGAnalysisReader::Access::GetNtupleRow() {
+  AssertSetup(false);
+#if RMG_HAS_HDF5
+  if (fLH5Reader) return fLH5Reader->GetNextRow();
+#endif
+  return fReader->GetNtupleRow(fNtupleId);
+}
+
+G4bool RMGAnalysisReader::Access::SetNtupleDColumn(
+    const std::string& name,
+    G4double& value,
+    const std::vector<std::string>& allowed_units
+) {
+  AssertSetup(true);
+  AssertUnit(name, allowed_units);
+#if RMG_HAS_HDF5
+  if (fLH5Reader) return fLH5Reader->SetColumn(name, value);
+#endif
+  return fReader->SetNtupleDColumn(fNtupleId, name, value);
+}
+
+G4bool RMGAnalysisReader::Access::SetNtupleFColumn(
+    const std::string& name,
+    G4float& value,
+    const std::vector<std::string>& allowed_units
+) {
+  AssertSetup(true);
+  AssertUnit(name, allowed_units);
+#if RMG_HAS_HDF5
+  if (fLH5Reader) return fLH5Reader->SetColumn(name, value);
+#endif
+  return fReader->SetNtupleFColumn(fNtupleId, name, value);
+}
+
+G4bool RMGAnalysisReader::Access::SetNtupleIColumn(
+    const std::string& name,
+    G4int& value,
+    const std::vector<std::string>& allowed_units
+) {
+  AssertSetup(true);
+  AssertUnit(name, allowed_units);
+#if RMG_HAS_HDF5
+  if (fLH5Reader) return fLH5Reader->SetColumn(name, value);
+#endif
+  return fReader->SetNtupleIColumn(fNtupleId, name, value);
+}
+
 std::string RMGAnalysisReader::Access::GetUnit(const std::string& name) const {
   if (!fUnits) return "";
   return fUnits->at(name);
@@ -104,7 +104,8 @@ void RMGCalorimeterOutputScheme::AssignOutputNames(G4AnalysisManager* ana_man) {
 
     // store the floating point values (energy always float32, time always float64)
     ana_man->CreateNtupleFColumn(id, "edep_in_keV");
-    ana_man->CreateNtupleDColumn(id, "time_in_ns");
+    // with reshaped output, this already is a hit table; name the time like in the other ones.
+    ana_man->CreateNtupleDColumn(id, fReshapeHits ? "t0_in_ns" : "time_in_ns");
     ana_man->FinishNtuple(id);
   }
 }
@@ -15,10 +15,12 @@
 
 #include "RMGConvertLH5.hh"
 
+#include <algorithm>
 #include <cstdint>
 #include <fmt/ranges.h>
 #include <regex>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include "RMGIpc.hh"
@@ -251,6 +253,192 @@ bool RMGConvertLH5::ConvertNTupleToTable(H5::Group& det_group) {
     LH5Log(RMGLog::error, ntuple_log_prefix, "column count mismatch");
     return false;
   }
+
+  // the output scheme already grouped the steps into hits, use this to reshape the table.
+  if (ExistsByType(det_group, RMGVOutputScheme::fHitStartColumnName, H5O_TYPE_DATASET)) {
+    return ReshapeTableToHits(det_group, ntuple_log_prefix);
+  }
+  return true;
+}
+
+template<typename T>
+void RMGConvertLH5::CreateArrayDataset(
+    H5::Group& group,
+    std::string name,
+    const std::vector<T>& data
+) {
+  H5::PredType dtype = H5::PredType::NATIVE_DOUBLE;
+  if constexpr (std::is_same_v<T, int32_t>) dtype = H5::PredType::NATIVE_INT32;
+  if constexpr (std::is_same_v<T, int64_t>) dtype = H5::PredType::NATIVE_INT64;
+
+  // create an extendible dataset, like the ones written by Geant4.
+  hsize_t dims[1] = {data.size()};
+  hsize_t max_dims[1] = {H5S_UNLIMITED};
+  hsize_t chunk_dims[1] = {std::clamp<hsize_t>(data.size(), 1, 1 << 14)};
+  H5::DataSpace dspace(1, dims, max_dims);
+  H5::DSetCreatPropList plist;
+  plist.setChunk(1, chunk_dims);
+
+  auto dset = group.createDataSet(name, dtype, dspace, plist);
+  if (!data.empty()) dset.write(data.data(), dtype);
+  SetStringAttribute(dset, "datatype", "array<1>{real}");
+}
+
+bool RMGConvertLH5::ReshapeTableToHits(H5::Group& det_group, const std::string& ntuple_log_prefix) {
+  const auto& hit_start_name = RMGVOutputScheme::fHitStartColumnName;
+  if (!ExistsByType(det_group, "evtid", H5O_TYPE_DATASET) ||
+      !ExistsByType(det_group, "time", H5O_TYPE_DATASET)) {
+    LH5Log(RMGLog::error, ntuple_log_prefix, "missing evtid or time column, cannot reshape");
+    return false;
+  }
+  LH5Log(RMGLog::debug, ntuple_log_prefix, "reshaping steps to hits");
+
+  auto dset_hit_start = det_group.openDataSet(hit_start_name);
+  auto dset_evtid = det_group.openDataSet("evtid");
+  auto dset_time = det_group.openDataSet("time");
+  hsize_t n_steps = 0;
+  dset_hit_start.getSpace().getSimpleExtentDims(&n_steps);
+
+  // find the first step of each hit in blocks, and take the hit-level columns from it.
+  constexpr hsize_t buffer_rows = 1 << 16;
+  std::vector<int64_t> cumulative_length;
+  std::vector<int32_t> hit_evtid;
+  std::vector<double> hit_t0;
+  std::vector<int32_t> buf_hit_start;
+  std::vector<int32_t> buf_evtid;
+  std::vector<double> buf_time;
+  for (hsize_t offset = 0; offset < n_steps; offset += buffer_rows) {
+    hsize_t count = std::min(buffer_rows, n_steps - offset);
+    H5::DataSpace mem_space(1, &count);
+    auto read_block = [&](H5::DataSet& dset, auto& buf, const H5::PredType& dtype) {
+      buf.resize(count);
+      auto file_space = dset.getSpace();
+      file_space.selectHyperslab(H5S_SELECT_SET, &count, &offset);
+      dset.read(buf.data(), dtype, mem_space, file_space);
+    };
+    read_block(dset_hit_start, buf_hit_start, H5::PredType::NATIVE_INT32);
+    read_block(dset_evtid, buf_evtid, H5::PredType::NATIVE_INT32);
+    read_block(dset_time, buf_time, H5::PredType::NATIVE_DOUBLE);
+
+    for (hsize_t i = 0; i < count; i++) {
+      if (buf_hit_start[i] == 0) continue;
+      if (offset + i > 0) cumulative_length.push_back(static_cast<int64_t>(offset + i));
+      hit_evtid.push_back(buf_evtid[i]);
+      hit_t0.push_back(buf_time[i]);
+    }
+  }
+  if (n_steps > 0) cumulative_length.push_back(static_cast<int64_t>(n_steps));
+  if (cumulative_length.size() != hit_evtid.size()) {
+    LH5Log(RMGLog::error, ntuple_log_prefix, "first step is not marked as start of a hit");
+    return false;
+  }
+  dset_hit_start.close();
+  dset_evtid.close();
+  dset_time.close();
+
+  // all step-level columns become vectors of vectors, with the existing data as flattened data.
+  det_group.unlink(hit_start_name);
+  det_group.unlink("evtid");
+  auto table_columns = GetChildren(det_group);
+  for (auto& column : table_columns) {
+    std::string column_tmp = column + "__tmp";
+    det_group.moveLink(column, column_tmp);
+    auto vov_group = det_group.createGroup(column);
+    det_group.moveLink(column_tmp, column + "/flattened_data");
+    CreateArrayDataset(vov_group, "cumulative_length", cumulative_length);
+    SetStringAttribute(vov_group, "datatype", "array<1>{array<1>{real}}");
+  }
+
+  CreateArrayDataset(det_group, "evtid", hit_evtid);
+  CreateArrayDataset(det_group, "t0", hit_t0);
+  auto dset_t0 = det_group.openDataSet("t0");
+  SetStringAttribute(dset_t0, "units", "ns");
+  dset_t0.close();
+
+  // update the table lgdo datatype with the new column list (t0 is appended, as in the python
+  // post-processing).
+  table_columns.push_back("evtid");
+  std::sort(table_columns.begin(), table_columns.end());
+  table_columns.push_back("t0");
+  det_group.removeAttr("datatype");
+  SetStringAttribute(
+      det_group,
+      "datatype",
+      "table{" + fmt::format("{}", fmt::join(table_columns, ",")) + "}"
+  );
+
+  LH5Log(
+      RMGLog::debug,
+      ntuple_log_prefix,
+      "reshaped ",
+      n_steps,
+      " steps to ",
+      hit_evtid.size(),
+      " hits"
+  );
+  return true;
+}
+
+bool RMGConvertLH5::WriteEventIndex(
+    H5::Group& ntuples_group,
+    H5::Group& det_group,
+    const std::string& ntuple
+) {
+  if (!ExistsByType(det_group, "evtid", H5O_TYPE_DATASET)) {
+    LH5Log(RMGLog::error, "table ", ntuple, " has no evtid column, cannot write event index");
+    return false;
+  }
+
+  auto dset_evtid = det_group.openDataSet("evtid");
+  hsize_t n_rows = 0;
+  dset_evtid.getSpace().getSimpleExtentDims(&n_rows);
+
+  // find the runs of equal evtid in blocks. The output schemes write all rows of one event
+  // at once, so the rows of each event are contiguous.
+  constexpr hsize_t buffer_rows = 1 << 16;
+  std::vector<int32_t> index_evtid;
+  std::vector<int64_t> index_first_row;
+  std::vector<int64_t> index_n_rows;
+  std::vector<int32_t> buf_evtid;
+  for (hsize_t offset = 0; offset < n_rows; offset += buffer_rows) {
+    hsize_t count = std::min(buffer_rows, n_rows - offset);
+    H5::DataSpace mem_space(1, &count);
+    auto file_space = dset_evtid.getSpace();
+    file_space.selectHyperslab(H5S_SELECT_SET, &count, &offset);
+    buf_evtid.resize(count);
+    dset_evtid.read(buf_evtid.data(), H5::PredType::NATIVE_INT32, mem_space, file_space);
+
+    for (hsize_t i = 0; i < count; i++) {
+      if (!index_evtid.empty() && index_evtid.back() == buf_evtid[i]) {
+        index_n_rows.back()++;
+        continue;
+      }
+      index_evtid.push_back(buf_evtid[i]);
+      index_first_row.push_back(static_cast<int64_t>(offset + i));
+      index_n_rows.push_back(1);
+    }
+  }
+  dset_evtid.close();
+
+  if (!ExistsByType(ntuples_group, fIndexGroupName, H5O_TYPE_GROUP)) {
+    ntuples_group.createGroup(fIndexGroupName).close();
+  }
+  auto index_group = ntuples_group.openGroup(fIndexGroupName);
+  auto index_table = index_group.createGroup(ntuple);
+  CreateArrayDataset(index_table, "evtid", index_evtid);
+  CreateArrayDataset(index_table, "first_row", index_first_row);
+  CreateArrayDataset(index_table, "n_rows", index_n_rows);
+  SetStringAttribute(index_table, "datatype", "table{evtid,first_row,n_rows}");
+  index_table.close();
+  index_group.close();
+
+  LH5Log(
+      RMGLog::debug,
+      "wrote event index with ",
+      index_evtid.size(),
+      " events for table ",
+      ntuple
+  );
   return true;
 }
 
@@ -307,17 +495,24 @@ bool RMGConvertLH5::ConvertToLH5Internal() {
   auto ntuples = GetChildren(ntuples_group);
   bool ntuple_success = true;
 
-  const std::string links_group_name = "__by_uid__";
-  const std::string n_ev_name = "number_of_simulated_events";
+  const std::string& links_group_name = fLinksGroupName;
+  const std::string& n_ev_name = fEventNumberName;
   std::vector<std::string> links;
   RMGIpc::SendIpcNonBlocking(RMGIpc::CreateMessage("lh5_links_group_name", links_group_name));
   RMGIpc::SendIpcNonBlocking(RMGIpc::CreateMessage("lh5_event_number_name", n_ev_name));
+  if (fWriteEventIndex) {
+    RMGIpc::SendIpcNonBlocking(RMGIpc::CreateMessage("lh5_index_group_name", fIndexGroupName));
+  }
 
   for (auto& ntuple : ntuples) {
     if (ntuple.empty()) LH5Log(RMGLog::fatal, "empty ntuple name, how is this possible?");
 
     auto det_group = ntuples_group.openGroup(ntuple);
     ntuple_success &= ConvertNTupleToTable(det_group);
+    bool is_aux = fAuxNtuples.find(ntuple) != fAuxNtuples.end();
+    if (fWriteEventIndex && ntuple_success && !is_aux) {
+      ntuple_success &= WriteEventIndex(ntuples_group, det_group, ntuple);
+    }
     det_group.close();
 
     // Check fNtupleMeta object for an entry whose second field matches the current ntuple name.
@@ -352,7 +547,7 @@ bool RMGConvertLH5::ConvertToLH5Internal() {
     }
 
     // if this is an auxiliary table, move it one level up out of the group
-    if (fAuxNtuples.find(ntuple) != fAuxNtuples.end()) {
+    if (is_aux) {
       LH5Log(RMGLog::debug, "moving ntuple ", ntuple_group_name, "/", ntuple, " one group back");
       hfile.moveLink(std::string(ntuple_group_name).append("/").append(ntuple), ntuple);
     }
@@ -397,6 +592,20 @@ bool RMGConvertLH5::ConvertToLH5Internal() {
     links_group.close();
   }
 
+  // make the event index group an LH5 struct of tables
+  if (ExistsByType(ntuples_group, fIndexGroupName, H5O_TYPE_GROUP)) {
+    auto index_group = ntuples_group.openGroup(fIndexGroupName);
+    LH5Log(RMGLog::debug, "making the event index HDF5 group an LH5 struct");
+    auto index_tables = GetChildren(index_group);
+    std::sort(index_tables.begin(), index_tables.end());
+    SetStringAttribute(
+        index_group,
+        "datatype",
+        "struct{" + fmt::format("{}", fmt::join(index_tables, ",")) + "}"
+    );
+    index_group.close();
+  }
+
   if (ntuples_group.attrExists("type")) ntuples_group.removeAttr("type");
 
   // check other things that geant4 might write into the file, and delete them if they are empty.
@@ -427,7 +636,8 @@ bool RMGConvertLH5::ConvertToLH5(
     const std::map<int, std::pair<int, std::string>>& ntuple_meta,
     bool dry_run,
     bool part_of_batch,
-    int n_ev
+    int n_ev,
+    bool event_index
 ) {
   auto conv = RMGConvertLH5(
       hdf5_file_name,
@@ -436,7 +646,8 @@ bool RMGConvertLH5::ConvertToLH5(
       ntuple_meta,
       dry_run,
       part_of_batch,
-      n_ev
+      n_ev,
+      event_index
   );
   try {
     return conv.ConvertToLH5Internal();
@@ -605,7 +816,16 @@ bool RMGConvertLH5::ConvertFromLH5(
     bool part_of_batch,
     std::map<std::string, std::map<std::string, std::string>>& units_map
 ) {
-  auto conv = RMGConvertLH5(lh5_file_name, ntuple_group_name, {}, {}, dry_run, part_of_batch, -1);
+  auto conv = RMGConvertLH5(
+      lh5_file_name,
+      ntuple_group_name,
+      {},
+      {},
+      dry_run,
+      part_of_batch,
+      -1,
+      false
+  );
   try {
     return conv.ConvertFromLH5Internal(units_map);
   } catch (const H5::Exception& e) {
@@ -85,6 +85,19 @@ void RMGDefaultCli::SetupCli(CLI::App& app) {
   );
   app.add_flag("-i,--interactive", interactive, "Open an interactive macro command prompt");
   app.add_option("-t,--threads", nthreads, "Set the number of threads used by remage");
+  app.add_option(
+         "--events-per-task",
+         events_per_task,
+         "Set the number of events processed in one task by the task-based run manager"
+  )
+      ->type_name("INT");
+  app.add_option(
+         "--tasks",
+         ntasks,
+         "Set the number of tasks the events of a run are split into by the task-based run manager"
+  )
+      ->type_name("INT");
+  app.add_flag("--pin-threads", pin_threads, "Pin each worker thread to one CPU core");
   app.add_option("--rand-seed", rand_seed, "Set the random engine seed")->type_name("INT");
   app.add_option(
          "-g,--gdml-files",
@@ -112,6 +125,18 @@ void RMGDefaultCli::SetupCli(CLI::App& app) {
          "process number for offset calculations in pseudo-multithreading mode (internal)"
   )
       ->group(""); // group("") hides the option from help output.
+  app.add_flag(
+         "--dynamic-events",
+         dynamic_events,
+         "request batches of events from the wrapper in pseudo-multithreading mode (internal)"
+  )
+      ->group(""); // group("") hides the option from help output.
+  app.add_option(
+         "--fork-pipe-i-fd",
+         fork_pipe_fds_in,
+         "IPC input pipe of each process to fork after initialization (internal)"
+  )
+      ->group(""); // group("") hides the option from help output.
   app.add_option(
       "command_listings",
       macros,
@@ -181,7 +206,17 @@ void RMGDefaultCli::SetupRuntime(RMGManager& manager) {
     RMGLog::Out(RMGLog::fatal, "invalid configuration for multi-threading or multi-processing.");
   }
   manager.SetNumberOfThreads(nthreads);
+  manager.SetEventsPerTask(events_per_task);
+  manager.SetNumberOfTasks(ntasks);
+  if (pin_threads) manager.SetPinWorkerThreads();
   if (proc_num_offset >= 0) manager.EnableMultiProcessing(proc_num_offset);
+  if (dynamic_events) manager.EnableDynamicEventDistribution();
+  if (!fork_pipe_fds_in.empty()) {
+    if (proc_num_offset != 0) {
+      RMGLog::Out(RMGLog::fatal, "only the first process can fork the other processes.");
+    }
+    manager.EnableForkAfterInitialization(fork_pipe_fds_in);
+  }
   if (rand_seed >= 0) manager.SetRandEngineSeed(rand_seed);
 }
 
@@ -222,8 +257,11 @@ int RMGDefaultCli::RunSimulation(int argc, char** argv) {
   manager.Initialize();
   manager.Run();
 
-  if (manager.HadError()) return 1;
-  return manager.HadWarning() ? 2 : 0;
+  int exit_code = 0;
+  if (manager.HadError()) exit_code = 1;
+  else if (manager.HadWarning()) exit_code = 2;
+  // the first process also waits for the processes it forked.
+  return manager.WaitForForkedProcesses(exit_code);
 }
 
 // vim: tabstop=2 shiftwidth=2 expandtab
@@ -18,13 +18,16 @@
 #include <chrono>
 
 #include "G4AnalysisManager.hh"
+#include "G4Event.hh"
 #include "G4RunManager.hh"
 
 #include "RMGLog.hh"
 #include "RMGManager.hh"
+#include "RMGMasterGenerator.hh"
 #include "RMGOutputManager.hh"
 #include "RMGRun.hh"
 #include "RMGRunAction.hh"
+#include "RMGTelemetry.hh"
 
 RMGEventAction::RMGEventAction(RMGRunAction* run_action) : fRunAction(run_action) {}
 
@@ -68,14 +71,23 @@ void RMGEventAction::BeginOfEventAction(const G4Event* event) {
     );
   }
 
-  if (RMGOutputManager::Instance()->IsPersistencyEnabled()) { fRunAction->ClearOutputDataFields(); }
+  // the primaries of this event have already been generated, also for a new batch of events.
+  if (RMGManager::Instance()->IsDynamicEventDistribution() && fRunAction->GetMasterGenerator()) {
+    fRunAction->SetEventIDOffset(fRunAction->GetMasterGenerator()->GetEventBatchOffset());
+  }
+
+  if (RMGOutputManager::Instance()->IsPersistencyEnabled()) {
+    fRunAction->RotateOutputFileIfRequested();
+    fRunAction->ClearOutputDataFields();
+  }
 }
 
 void RMGEventAction::EndOfEventAction(const G4Event* event) {
 
-  if (RMGManager::ShouldAbortRun()) {
+  if (RMGManager::ShouldAbortRun() || event->IsAborted()) {
     return; // the run has been aborted somewhere else, do not persist the event.
   }
+  RMGTelemetry::EndOfEvent();
 
   auto oschemes = fRunAction->GetAllOutputDataFields();
 
@@ -91,6 +103,8 @@ void RMGEventAction::EndOfEventAction(const G4Event* event) {
   }
 
   // NOTE: G4analysisManager::AddNtupleRow() must be called here for event-oriented output
+
+  if (RMGOutputManager::Instance()->IsPersistencyEnabled()) fRunAction->CheckOutputFileLimits();
 }
 
 // vim: tabstop=2 shiftwidth=2 expandtab
@@ -17,6 +17,9 @@
 
 #include "G4ExceptionHandler.hh"
 
+#include "RMGIpc.hh"
+#include "RMGLogSink.hh"
+
 bool RMGExceptionHandler::Notify(
     const char* originOfException,
     const char* exceptionCode,
@@ -28,6 +31,9 @@ bool RMGExceptionHandler::Notify(
   // the UI manager aborts batch mode, but only emits warnings. Mark them as errors accordingly.
   if (code.starts_with("UIMAN")) { severity = FatalException; }
 
+  // the buffered log messages have been logged before this exception.
+  RMGLogSink::Flush();
+
   // do our remage-internal bookkeeping after changing severities.
   if (severity == JustWarning) {
     fHadWarning = true;
@@ -35,7 +41,11 @@ bool RMGExceptionHandler::Notify(
     fHadError = true;
   }
 
-  return G4ExceptionHandler::Notify(originOfException, exceptionCode, severity, description);
+  const bool abort =
+      G4ExceptionHandler::Notify(originOfException, exceptionCode, severity, description);
+  // the application will be aborted, so send all buffered IPC messages before.
+  if (abort) RMGIpc::Flush();
+  return abort;
 }
 
 // vim: tabstop=2 shiftwidth=2 expandtab
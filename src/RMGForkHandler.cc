@@ -0,0 +1,232 @@
+// Copyright (C) 2026
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "RMGForkHandler.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <string>
+
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+
+#include "G4ios.hh"
+#include "Randomize.hh"
+
+#include "RMGAnalysisReader.hh"
+#include "RMGIpc.hh"
+#include "RMGLog.hh"
+#include "RMGManager.hh"
+
+namespace {
+
+  // the exit code as seen in bash.
+  int ExitCode(int status) {
+    if (WIFEXITED(status)) return WEXITSTATUS(status);
+    if (WIFSIGNALED(status)) return 128 + WTERMSIG(status);
+    return 1;
+  }
+
+  // the signals the python wrapper forwards to its remage-cpp process.
+  constexpr int kForwardedSignals[] =
+      {SIGHUP, SIGINT, SIGQUIT, SIGTERM, SIGUSR1, SIGUSR2, SIGTSTP, SIGCONT};
+
+} // namespace
+
+G4bool RMGForkHandler::Notify(G4ApplicationState requested_state) {
+  // the geometry is closed and the physics tables are built right before the first run starts.
+  if (requested_state == G4State_GeomClosed && !fForked) Fork();
+  return true;
+}
+
+void RMGForkHandler::Fork() {
+
+  fForked = true;
+  auto manager = RMGManager::Instance();
+  if (!manager->IsExecSequential()) {
+    RMGLog::Out(RMGLog::fatal, "forking processes is only possible with a sequential run manager");
+  }
+  // the forked processes would share the file offsets of the open input files, and read from the
+  // same position. LH5 files are read without changing the file offset.
+  if (RMGAnalysisReader::HasOpenedG4ReaderFile()) {
+    RMGLog::Out(
+        RMGLog::fatal,
+        "forking processes is only possible with LH5 input files, use independent processes for "
+        "other input file formats"
+    );
+  }
+
+  // draw the seeds of all processes from the same engine, before forking.
+  const size_t n_children = fPipeFdsIn.size();
+  std::vector<long> seeds(n_children + 1);
+  for (auto& seed : seeds) {
+    seed = static_cast<long>(G4UniformRand() * std::numeric_limits<int>::max());
+  }
+
+  RMGLog::OutFormat(RMGLog::detail, "Forking {} processes after initialization", n_children);
+
+  // do not duplicate buffered output or IPC messages in the forked processes.
+  G4cout << std::flush;
+  G4cerr << std::flush;
+  std::fflush(nullptr);
+  RMGIpc::Flush();
+
+  const pid_t parent_pid = getpid();
+  fChildExitCodes = std::vector<std::atomic<int>>(n_children);
+  for (size_t i = 0; i < n_children; i++) {
+    const pid_t pid = fork();
+    if (pid < 0) RMGLog::Out(RMGLog::fatal, "could not fork process: ", std::strerror(errno));
+
+    if (pid == 0) {
+#ifdef __linux__
+      // do not outlive the first process, even if it gets killed.
+      prctl(PR_SET_PDEATHSIG, SIGTERM);
+      if (getppid() != parent_pid) _exit(1);
+#endif
+      const int proc_num = static_cast<int>(i) + 1;
+      for (size_t j = 0; j < n_children; j++) {
+        if (j != i) close(fPipeFdsIn[j]);
+      }
+      fChildPids.clear();
+      fChildExitCodes.clear();
+
+      RMGLog::SetProcNum(proc_num);
+      manager->EnableMultiProcessing(proc_num);
+      RMGIpc::SetupForkedProcess(fPipeFdsIn[i], proc_num);
+
+      CLHEP::HepRandom::setTheSeed(seeds[proc_num]);
+      RMGLog::OutFormat(
+          RMGLog::summary,
+          "Forked process {} (pid {}), CLHEP::HepRandom seed changed to: {}",
+          proc_num,
+          getpid(),
+          seeds[proc_num]
+      );
+      RMGIpc::SendIpcNonBlocking(
+          RMGIpc::CreateMessage(
+              "forked_process",
+              std::to_string(getpid()) + "\x1f" + std::to_string(seeds[proc_num])
+          )
+      );
+      return;
+    }
+
+    fChildPids.push_back(pid);
+    fChildExitCodes[i] = kRunning;
+  }
+
+  for (const int fd : fPipeFdsIn) close(fd);
+  InstallSignalHandlers();
+
+  CLHEP::HepRandom::setTheSeed(seeds[0]);
+  RMGLog::Out(RMGLog::summary, "CLHEP::HepRandom seed changed to: ", seeds[0], " (first process)");
+}
+
+void RMGForkHandler::InstallSignalHandlers() {
+
+  // the python wrapper only sees this process, so forward its signals to the forked processes.
+  // the handler itself might re-raise the signal with the default action.
+  struct sigaction forward{};
+  forward.sa_handler = &RMGForkHandler::ForwardSignal;
+  sigemptyset(&forward.sa_mask);
+  forward.sa_flags = SA_RESTART | SA_NODEFER;
+  for (const int sig : kForwardedSignals) sigaction(sig, &forward, &fPreviousActions[sig]);
+
+  struct sigaction child{};
+  child.sa_handler = &RMGForkHandler::OnChildExit;
+  sigemptyset(&child.sa_mask);
+  child.sa_flags = SA_RESTART | SA_NOCLDSTOP;
+  sigaction(SIGCHLD, &child, &fPreviousActions[SIGCHLD]);
+}
+
+void RMGForkHandler::ForwardSignal(int sig) {
+
+  for (size_t i = 0; i < fChildPids.size(); i++) {
+    if (fChildExitCodes[i] == kRunning) kill(fChildPids[i], sig);
+  }
+
+  const auto& previous = fPreviousActions[sig];
+  if (previous.sa_handler == SIG_IGN) return;
+  if (previous.sa_handler == SIG_DFL) {
+    // perform the default action on this process, and re-install this handler if it continues.
+    struct sigaction own{};
+    sigaction(sig, &previous, &own);
+    raise(sig);
+    sigaction(sig, &own, nullptr);
+    return;
+  }
+  previous.sa_handler(sig);
+}
+
+void RMGForkHandler::OnChildExit(int) {
+
+  const int saved_errno = errno;
+  for (size_t i = 0; i < fChildPids.size(); i++) {
+    if (fChildExitCodes[i] != kRunning) continue;
+    int status = 0;
+    if (waitpid(fChildPids[i], &status, WNOHANG) != fChildPids[i]) continue;
+    fChildExitCodes[i] = ExitCode(status);
+
+    // like the python wrapper does for independent processes, terminate all other processes if
+    // one has been killed.
+    if (WIFSIGNALED(status)) {
+      for (size_t j = 0; j < fChildPids.size(); j++) {
+        if (fChildExitCodes[j] == kRunning) kill(fChildPids[j], SIGTERM);
+      }
+      raise(SIGTERM);
+    }
+  }
+  errno = saved_errno;
+}
+
+int RMGForkHandler::WaitForForkedProcesses(int exit_code) {
+
+  if (fChildPids.empty()) return exit_code;
+
+  // collect the remaining processes here, and not in the signal handler.
+  sigaction(SIGCHLD, &fPreviousActions[SIGCHLD], nullptr);
+
+  std::vector<int> exit_codes{exit_code};
+  for (size_t i = 0; i < fChildPids.size(); i++) {
+    int status = 0;
+    while (fChildExitCodes[i] == kRunning) {
+      const pid_t pid = waitpid(fChildPids[i], &status, 0);
+      if (pid == fChildPids[i]) fChildExitCodes[i] = ExitCode(status);
+      else if (pid < 0 && errno != EINTR) fChildExitCodes[i] = 1;
+    }
+    exit_codes.push_back(fChildExitCodes[i]);
+    if (fChildExitCodes[i] != 0) {
+      RMGLog::OutFormat(
+          RMGLog::detail,
+          "Forked process {} exited with code {}",
+          i + 1,
+          fChildExitCodes[i].load()
+      );
+    }
+  }
+  fChildPids.clear();
+
+  if (std::find(exit_codes.begin(), exit_codes.end(), 1) != exit_codes.end()) return 1;
+  return *std::max_element(exit_codes.begin(), exit_codes.end());
+}
+
+// vim: tabstop=2 shiftwidth=2 expandtab
@@ -16,6 +16,7 @@
 #include "RMGGeneratorFromFile.hh"
 
 #include <cmath>
+#include <map>
 #include <vector>
 
 #include "G4ParticleGun.hh"
@@ -29,6 +30,10 @@
 namespace u = CLHEP;
 
 RMGAnalysisReader* RMGGeneratorFromFile::fReader = new RMGAnalysisReader();
+RMGAnalysisReader::Prefetcher<RMGGeneratorFromFile::EventData> RMGGeneratorFromFile::fPrefetcher(
+    fReader,
+    &RMGGeneratorFromFile::ReadEvents
+);
 
 RMGGeneratorFromFile::RMGGeneratorFromFile() : RMGVGenerator("FromFile") {
   this->DefineCommands();
@@ -71,123 +76,187 @@ void RMGGeneratorFromFile::OpenFile(std::string& name) {
       );
     }
   }
-}
 
-void RMGGeneratorFromFile::BeginOfRunAction(const G4Run*) {
+  // resolve the units only once, and not for every read row.
+  const std::map<std::string, double> energy_units =
+      {{"", u::MeV}, {"eV", u::eV}, {"keV", u::keV}, {"MeV", u::MeV}, {"GeV", u::GeV}};
+  const std::map<std::string, double> time_units =
+      {{"", u::ns}, {"ns", u::ns}, {"ms", u::ms}, {"s", u::s}};
+  const std::map<std::string, double> pos_units =
+      {{"", u::m}, {"nm", u::nm}, {"um", u::um}, {"mm", u::mm}, {"cm", u::cm}, {"m", u::m}};
 
-  if (!G4Threading::IsMasterThread()) return;
+  fEkinUnit = energy_units.at(reader.GetUnit("ekin"));
+  fTimeUnit = time_units.at(reader.GetUnit("time"));
+  fPosUnit = fIncludePosition ? pos_units.at(reader.GetUnit("xloc")) : u::m;
+  fReadPosition = fIncludePosition;
+}
 
-  auto reader = fReader->GetLockedReader();
-  if (!reader) {
-    RMGLog::Out(RMGLog::fatal, "vertex file '", fReader->GetFileName(), "' not found or in wrong format");
-  }
+void RMGGeneratorFromFile::ReadEvents(
+    RMGAnalysisReader::Access& reader,
+    std::vector<EventData>& events,
+    size_t n
+) {
+  for (size_t i = 0; i < n; i++) {
+    EventData event;
 
-  // in the multiprocessing-mode we get here with an offset on the main thread.
-  size_t start_event = RMGManager::Instance()->GetProcessNumberOffset() *
-                       G4RunManager::GetRunManager()->GetNumberOfEventsToBeProcessed();
-  // skip the first start_event rows from the input file.
-  if (start_event > 0) {
-    size_t skipped_events = 0, skipped_rows_this_evt = 0, n_part_this_evt = 1;
-    while ((skipped_events < start_event) ||
-           (skipped_events == start_event && skipped_rows_this_evt < n_part_this_evt)) {
+    int n_part = 1;
+    while (static_cast<int>(event.particles.size()) < n_part) {
       fRowData = RowData(); // initialize sentinel values.
 
       if (!reader.GetNtupleRow()) {
-        RMGLog::Out(RMGLog::fatal, "[initial seek] No more vertices available in input file!");
+        event.is_complete = false;
         break;
       }
 
-      if (!fRowData.IsValid(fIncludePosition)) {
-        RMGLog::Out(
-            RMGLog::fatal,
-            "[initial seek] At least one of the columns does not exist or of wrong type"
-        );
+      if (!fRowData.IsValid(fReadPosition)) {
+        event.is_valid = false;
         break;
       }
 
-      if (fRowData.fNpart > 0) {
-        skipped_events += 1;
-        skipped_rows_this_evt = 0;
-        n_part_this_evt = fRowData.fNpart;
+      fRowData.fEkin *= fEkinUnit;
+      fRowData.fTime *= fTimeUnit;
+      fRowData.fXpos *= fPosUnit;
+      fRowData.fYpos *= fPosUnit;
+      fRowData.fZpos *= fPosUnit;
+      event.particles.push_back(fRowData); // make copy of data.
+
+      if (event.particles.size() == 1) {
+        n_part = fRowData.fNpart;
+        if (n_part <= 0) {
+          event.is_valid_particle = false;
+          break;
+        }
+      } else if (fRowData.fNpart != 0) {
+        event.is_valid_particle = false;
+        break;
       }
-
-      skipped_rows_this_evt++;
     }
+
+    // do not add an empty event at the end of the file.
+    if (!event.is_complete && event.particles.empty()) break;
+    const bool is_complete = event.is_complete;
+    events.push_back(std::move(event));
+    fEventsRead++;
+    if (!is_complete) break;
   }
 }
 
-void RMGGeneratorFromFile::EndOfRunAction(const G4Run*) {
+void RMGGeneratorFromFile::BeginOfRunAction(const G4Run*) {
 
   if (!G4Threading::IsMasterThread()) return;
 
-  fReader->CloseFile();
-}
-
+  fPrefetcher.Reset();
 
-void RMGGeneratorFromFile::GeneratePrimaries(G4Event* event) {
+  auto reader = fReader->GetLockedReader();
+  if (!reader) {
+    RMGLog::Out(RMGLog::fatal, "vertex file '", fReader->GetFileName(), "' not found or in wrong format");
+  }
 
-  auto locked_reader = fReader->GetLockedReader();
+  // with dynamic event distribution, the events are read for each batch of events.
+  fEventsRead = 0;
+  if (RMGManager::Instance()->IsDynamicEventDistribution()) return;
 
-  if (!locked_reader) {
-    RMGLog::Out(RMGLog::error, "Ntuple named 'pos' could not be found in input file!");
-    return;
+  // in the multiprocessing-mode we get here with an offset on the main thread.
+  size_t start_event = RMGManager::Instance()->GetProcessNumberOffset() *
+                       G4RunManager::GetRunManager()->GetNumberOfEventsToBeProcessed();
+  // skip the first start_event events from the input file. Formats with random access find the
+  // event boundaries from the n_part column directly, otherwise all rows have to be read.
+  if (start_event > 0 && !reader.SeekToEvent(start_event, "n_part")) {
+    SkipEvents(reader, start_event);
   }
+  fEventsRead = start_event;
+}
 
-  std::vector<RowData> particles;
+void RMGGeneratorFromFile::SkipEvents(RMGAnalysisReader::Access& reader, size_t n) {
 
-  int n_part = 1, n = 0;
-  bool is_valid = true, is_valid_particle = true;
-  while (n < n_part) {
+  size_t skipped_events = 0, skipped_rows_this_evt = 0, n_part_this_evt = 1;
+  while ((skipped_events < n) || (skipped_events == n && skipped_rows_this_evt < n_part_this_evt)) {
     fRowData = RowData(); // initialize sentinel values.
 
-    if (!locked_reader.GetNtupleRow()) {
-      RMGLog::Out(RMGLog::error, "No more vertices available in input file!");
-      return;
+    if (!reader.GetNtupleRow()) {
+      RMGLog::Out(RMGLog::fatal, "[initial seek] No more vertices available in input file!");
+      break;
     }
 
-    if (!fRowData.IsValid(fIncludePosition)) {
-      is_valid = false;
+    if (!fRowData.IsValid(fReadPosition)) {
+      RMGLog::Out(
+          RMGLog::fatal,
+          "[initial seek] At least one of the columns does not exist or of wrong type"
+      );
       break;
     }
 
-    particles.push_back(fRowData); // make copy of data.
-    if (n == 0) {
-      n_part = fRowData.fNpart;
-      if (n_part <= 0) {
-        is_valid_particle = false;
-        break;
-      }
-    } else if (fRowData.fNpart != 0) {
-      is_valid_particle = false;
-      break;
+    if (fRowData.fNpart > 0) {
+      skipped_events += 1;
+      skipped_rows_this_evt = 0;
+      n_part_this_evt = fRowData.fNpart;
     }
-    n++;
+
+    skipped_rows_this_evt++;
+  }
+}
+
+void RMGGeneratorFromFile::BeginOfEventBatch(size_t first_event, size_t n_events) {
+
+  fEventBatch.clear();
+  fEventBatchIndex = 0;
+
+  auto reader = fReader->GetLockedReader();
+  if (!reader) return;
+
+  // the batches are claimed in order, so the reader never has to go back. The events of the
+  // batches claimed by other processes have to be skipped.
+  if (first_event < fEventsRead) {
+    RMGLog::OutFormat(
+        RMGLog::fatal,
+        "input of event {} has already been read (at event {})",
+        first_event,
+        fEventsRead
+    );
+  }
+  if (first_event > fEventsRead && !reader.SeekToEvent(first_event, "n_part")) {
+    SkipEvents(reader, first_event - fEventsRead);
   }
+  fEventsRead = first_event;
 
-  // exit critical section.
-  auto unit_ekin = locked_reader.GetUnit("ekin");
-  auto unit_time = locked_reader.GetUnit("time");
-  auto unit_pos = fIncludePosition ? locked_reader.GetUnit("xloc") : "";
-  locked_reader.unlock();
+  fEventBatch.reserve(n_events);
+  ReadEvents(reader, fEventBatch, n_events);
+}
+
+void RMGGeneratorFromFile::EndOfRunAction(const G4Run*) {
+
+  if (!G4Threading::IsMasterThread()) return;
+
+  fReader->CloseFile();
+}
+
+
+void RMGGeneratorFromFile::GeneratePrimaries(G4Event* event) {
+
+  const EventData* event_data = nullptr;
+  if (RMGManager::Instance()->IsDynamicEventDistribution()) {
+    if (fEventBatchIndex < fEventBatch.size()) event_data = &fEventBatch[fEventBatchIndex++];
+  } else {
+    // events are read in blocks from the file, this only needs a lock when a new block is read.
+    event_data = fPrefetcher.Next(fPrefetched);
+  }
+
+  if (!event_data || !event_data->is_complete) {
+    RMGLog::Out(RMGLog::error, "No more vertices available in input file!");
+    return;
+  }
 
   // check for NaN sentinel values - i.e. non-existing columns (there is no error message).
-  if (!is_valid) {
+  if (!event_data->is_valid) {
     RMGLog::Out(RMGLog::error, "At least one of the columns does not exist or of wrong type");
     return;
   }
-  if (!is_valid_particle || particles.empty()) {
+  if (!event_data->is_valid_particle || event_data->particles.empty()) {
     RMGLog::Out(RMGLog::error, "Event particle count not valid in input file");
     return;
   }
 
-  const std::map<std::string, double> energy_units =
-      {{"", u::MeV}, {"eV", u::eV}, {"keV", u::keV}, {"MeV", u::MeV}, {"GeV", u::GeV}};
-  const std::map<std::string, double> time_units =
-      {{"", u::ns}, {"ns", u::ns}, {"ms", u::ms}, {"s", u::s}};
-  const std::map<std::string, double> pos_units =
-      {{"", u::m}, {"nm", u::nm}, {"um", u::um}, {"mm", u::mm}, {"cm", u::cm}, {"m", u::m}};
-
-  for (const auto& row_data : particles) {
+  for (const auto& row_data : event_data->particles) {
 
     auto particle = G4ParticleTable::GetParticleTable()->FindParticle(row_data.fG4Pid);
     if (!particle) {
@@ -202,23 +271,21 @@ void RMGGeneratorFromFile::GeneratePrimaries(G4Event* event) {
         row_data.fPx,
         row_data.fPy,
         row_data.fPz,
-        row_data.fEkin * energy_units.at(unit_ekin) / u::MeV,
-        row_data.fTime * time_units.at(unit_time) / u::ns
+        row_data.fEkin / u::MeV,
+        row_data.fTime / u::ns
     );
 
     G4ThreeVector momentum{row_data.fPx, row_data.fPy, row_data.fPz};
 
     fGun->SetParticleDefinition(particle);
-    if (!fIncludePosition) {
+    if (!fReadPosition) {
       fGun->SetParticlePosition(fParticlePosition);
     } else {
-      fGun->SetParticlePosition(
-          G4ThreeVector{row_data.fXpos, row_data.fYpos, row_data.fZpos} * pos_units.at(unit_pos)
-      );
+      fGun->SetParticlePosition(G4ThreeVector{row_data.fXpos, row_data.fYpos, row_data.fZpos});
     }
-    fGun->SetParticleTime(row_data.fTime * time_units.at(unit_time));
+    fGun->SetParticleTime(row_data.fTime);
     fGun->SetParticleMomentumDirection(momentum);
-    fGun->SetParticleEnergy(row_data.fEkin * energy_units.at(unit_ekin));
+    fGun->SetParticleEnergy(row_data.fEkin);
 
     fGun->GeneratePrimaryVertex(event);
   }
@@ -17,173 +17,78 @@
 #include "RMGGeneratorMUSUNCosmicMuons.hh"
 
 #include <cmath>
-#include <filesystem>
-#include <iterator>
-#include <vector>
 
 #include "G4GenericMessenger.hh"
 #include "G4ParticleGun.hh"
 #include "G4ParticleTable.hh"
+#include "G4RunManager.hh"
+#include "G4Threading.hh"
 #include "G4ThreeVector.hh"
-#include "Randomize.hh"
 
-#include "RMGHardware.hh"
 #include "RMGLog.hh"
+#include "RMGManager.hh"
 #include "RMGVGenerator.hh"
 
 namespace u = CLHEP;
 
-RMGAnalysisReader* RMGGeneratorMUSUNCosmicMuons::fAnalysisReader = new RMGAnalysisReader();
-RMGGeneratorMUSUNCosmicMuons_Data* RMGGeneratorMUSUNCosmicMuons::fInputData = nullptr;
-bool RMGGeneratorMUSUNCosmicMuons::fHasCartesianMomentum = false;
-
 RMGGeneratorMUSUNCosmicMuons::RMGGeneratorMUSUNCosmicMuons() : RMGVGenerator("MUSUNCosmicMuons") {
   this->DefineCommands();
   fGun = std::make_unique<G4ParticleGun>();
-  fPathToTmpFolder = std::filesystem::temp_directory_path();
-}
-
-bool RMGGeneratorMUSUNCosmicMuons::PrepareCopy(std::string pathToFile) {
-  /*
-  The working assumption is that the user uses the output directly from MUSUN, i.e. there is no header.
-  To allow proper multiprocessing, we want the file to be read using G4CsvAnalysisReader.
-  To do this, we copy the file to /var/tmp with the appropriate header.
-  To determine the header format, we need to determine the number of columns.
-  */
-
-  // Define fPathToTmpFile
-  std::filesystem::path originalFilePath(pathToFile);
-  std::filesystem::path fileName = originalFilePath.filename();
-  fPathToTmpFile = fPathToTmpFolder / fileName;
-
-  // Check if the original file exists / the tmp file does not exist
-  std::ifstream originalFile(pathToFile);
-  if (!originalFile) RMGLog::Out(RMGLog::fatal, "MUSUN file ", pathToFile, " not found! Exit.");
-
-  if (std::filesystem::exists(fPathToTmpFile)) {
-    RMGLog::Out(RMGLog::warning, "Temporary file already exists. Deleting it.");
-    std::filesystem::remove(fPathToTmpFile);
-  }
-
-  // Counting the number of columns to identify which header to use
-  std::string firstLine;
-  if (!std::getline(originalFile, firstLine)) {
-    RMGLog::Out(RMGLog::error, "Error: File is empty");
-    return false; // the return value denotes the file format, just return any.
-  }
-  std::istringstream iss(firstLine);
-  std::vector<std::string> tokens(
-      std::istream_iterator<std::string>{iss},
-      std::istream_iterator<std::string>()
-  );
-  size_t numColumns = tokens.size();
-
-  // Define header template
-  std::string header_template = "#class tools::wcsv::ntuple\n"
-                                "#title MUSUN\n"
-                                "#separator 11\n"
-                                "#vector_separator 10\n"
-                                "#column int ID\n"
-                                "#column int type\n"
-                                "#column double Ekin\n"
-                                "#column double x\n"
-                                "#column double y\n"
-                                "#column double z\n";
-
-  // Based on the number of columns, add additional columns
-  if (numColumns == 8) {
-    header_template += "#column double theta\n"
-                       "#column double phi\n";
-  } else if (numColumns == 9) {
-    header_template += "#column double px\n"
-                       "#column double py\n"
-                       "#column double pz\n";
-  } else
-    RMGLog::Out(
-        RMGLog::fatal,
-        "MUSUN format not identified! It has " + to_string(numColumns) + " columns. Exit."
-    );
-
-
-  // Create a temporary file and write the header
-  std::ofstream tmpFile(fPathToTmpFile);
-  if (!tmpFile) RMGLog::Out(RMGLog::fatal, "Unable to create temporary file! Exit.");
-
-  tmpFile << header_template;
-
-  // Copy contents from original file to temporary file
-  tmpFile << firstLine << std::endl;
-  tmpFile << originalFile.rdbuf();
-
-  // Close files
-  originalFile.close();
-  tmpFile.close();
-
-  return numColumns == 9;
 }
 
 void RMGGeneratorMUSUNCosmicMuons::BeginOfRunAction(const G4Run*) {
 
-  if (!fInputData) {
-    if (!G4Threading::IsMasterThread()) {
-      RMGLog::OutDev(RMGLog::fatal, "on worker, but data not initialized");
-    }
+  if (!G4Threading::IsMasterThread()) return;
 
-    // include in lock
-    auto lock = fAnalysisReader->GetLock();
-    fHasCartesianMomentum = PrepareCopy(fPathToFile);
-
-    auto reader = fAnalysisReader->OpenFile(fPathToTmpFile, "", "MUSUN", std::move(lock), "csv");
-    if (!reader) RMGLog::Out(RMGLog::fatal, "Temp MUSUN file not found! Exit.");
-
-    fInputData = new RMGGeneratorMUSUNCosmicMuons_Data;
-    reader.SetNtupleIColumn("ID", (fInputData->fID));
-    reader.SetNtupleIColumn("type", (fInputData->fType));
-    reader.SetNtupleDColumn("Ekin", (fInputData->fEkin));
-    reader.SetNtupleDColumn("x", (fInputData->fX));
-    reader.SetNtupleDColumn("y", (fInputData->fY));
-    reader.SetNtupleDColumn("z", (fInputData->fZ));
-    if (!fHasCartesianMomentum) {
-      reader.SetNtupleDColumn("theta", (fInputData->fTheta));
-      reader.SetNtupleDColumn("phi", (fInputData->fPhi));
-    } else {
-      reader.SetNtupleDColumn("px", (fInputData->fPx));
-      reader.SetNtupleDColumn("py", (fInputData->fPy));
-      reader.SetNtupleDColumn("pz", (fInputData->fPz));
+  // the file is only indexed once, as long as it does not change.
+  if (!fReader || fReader->GetFileName() != fPathToFile) {
+    fReader = RMGMUSUNReader::Open(fPathToFile);
+    if (!fReader) {
+      RMGLog::Out(RMGLog::fatal, "MUSUN file ", fPathToFile, " could not be read! Exit.");
     }
   }
-}
 
-void RMGGeneratorMUSUNCosmicMuons::EndOfRunAction(const G4Run*) {
-  if (!G4Threading::IsMasterThread()) return;
+  // like for the other input files, each run starts reading at the beginning of the file. In the
+  // multiprocessing-mode we get here with an offset on the main thread.
+  fNextRow = RMGManager::Instance()->GetProcessNumberOffset() *
+             G4RunManager::GetRunManager()->GetNumberOfEventsToBeProcessed();
+  // with dynamic event distribution, the rows are only known for each batch.
+  fEventBatchNext = fEventBatchEnd = 0;
 
-  auto reader = fAnalysisReader->GetLockedReader();
-  if (reader) { std::filesystem::remove(fPathToTmpFile); }
+  auto particle_table = G4ParticleTable::GetParticleTable();
+  fMuMinus = particle_table->FindParticle("mu-");
+  fMuPlus = particle_table->FindParticle("mu+");
 }
 
+void RMGGeneratorMUSUNCosmicMuons::BeginOfEventBatch(size_t first_event, size_t n_events) {
+  // with random access to the rows, the row is the global event index.
+  fEventBatchNext = first_event;
+  fEventBatchEnd = first_event + n_events;
+}
 
 void RMGGeneratorMUSUNCosmicMuons::GeneratePrimaries(G4Event* event) {
 
-  auto reader = fAnalysisReader->GetLockedReader();
-
-  if (!reader) {
-    RMGLog::Out(RMGLog::error, "MUSUN ntuple could not be found in input file!");
+  if (!fReader) {
+    RMGLog::Out(RMGLog::error, "MUSUN file has not been opened!");
     return;
   }
 
-  if (!reader.GetNtupleRow()) {
+  // the rows are parsed directly from the mapped file, this does not need any lock.
+  size_t row = 0;
+  if (RMGManager::Instance()->IsDynamicEventDistribution()) {
+    row = fEventBatchNext < fEventBatchEnd ? fEventBatchNext++ : fReader->GetNumberOfRows();
+  } else {
+    row = fNextRow.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (row >= fReader->GetNumberOfRows()) {
     RMGLog::Out(RMGLog::error, "no more input rows in MUSUN file!");
     return;
   }
+  RMGGeneratorMUSUNCosmicMuons_Data input_data{};
+  if (!fReader->ReadRow(row, input_data)) return;
+  const bool has_cartesian = fReader->HasCartesianMomentum();
 
-  // copy data and end critical section.
-  RMGGeneratorMUSUNCosmicMuons_Data input_data = *fInputData;
-  bool has_cartesian = fHasCartesianMomentum;
-  reader.unlock();
-
-  auto theParticleTable = G4ParticleTable::GetParticleTable();
-  if (input_data.fType == 10) fGun->SetParticleDefinition(theParticleTable->FindParticle("mu-"));
-  else fGun->SetParticleDefinition(theParticleTable->FindParticle("mu+"));
+  fGun->SetParticleDefinition(input_data.fType == 10 ? fMuMinus : fMuPlus);
 
   RMGLog::OutFormat(
       RMGLog::debug_event,
@@ -16,6 +16,7 @@
 #include "RMGGermaniumOutputScheme.hh"
 
 #include <set>
+#include <vector>
 
 #include "G4AnalysisManager.hh"
 #include "G4Event.hh"
@@ -26,7 +27,6 @@
 
 #include "RMGGermaniumDetector.hh"
 #include "RMGHardware.hh"
-#include "RMGIpc.hh"
 #include "RMGLog.hh"
 #include "RMGManager.hh"
 #include "RMGNavigationTools.hh"
@@ -67,7 +67,7 @@ void RMGGermaniumOutputScheme::AssignOutputNames(G4AnalysisManager* ana_man) {
   CreateNtupleFOrDColumn(ana_man, detector_origins_id, "yloc_in_m", fStoreSinglePrecisionPosition);
   CreateNtupleFOrDColumn(ana_man, detector_origins_id, "zloc_in_m", fStoreSinglePrecisionPosition);
   ana_man->FinishNtuple(detector_origins_id);
-  RMGIpc::SendIpcNonBlocking(RMGIpc::CreateMessage("output_ntuple_deduplicate", "detector_origins"));
+  rmg_man->RegisterNtupleDeduplication("detector_origins");
 
   std::set<int> registered_uids;
   std::map<std::string, int> registered_ntuples;
@@ -151,6 +151,7 @@ void RMGGermaniumOutputScheme::AssignOutputNames(G4AnalysisManager* ana_man) {
       CreateNtupleFOrDColumn(ana_man, id, "v_pre_in_m\\ns", fStoreSinglePrecisionPosition);
       CreateNtupleFOrDColumn(ana_man, id, "v_post_in_m\\ns", fStoreSinglePrecisionPosition);
     }
+    if (fReshapeHits) ana_man->CreateNtupleIColumn(id, fHitStartColumnName);
     ana_man->FinishNtuple(id);
   }
 }
@@ -236,13 +237,15 @@ void RMGGermaniumOutputScheme::StoreEvent(const G4Event* event) {
     RMGLog::OutDev(RMGLog::debug_event, "Filling persistent data vectors");
     const auto ana_man = G4AnalysisManager::Instance();
 
+    std::vector<OrderedStep<RMGDetectorHit>> steps;
     for (auto hit : *hit_coll->GetVector()) {
-
       // skip hits with no energy deposit (only when discarding zero-energy hits is enabled)
       if (!hit or (hit->energy_deposition == 0 and this->fDiscardZeroEnergyHits)) continue;
+      steps.push_back({hit, rmg_man->GetNtupleID(hit->detector_uid), false});
+    }
 
+    for (const auto& [hit, ntupleid, hit_start] : OrderStepsIntoHits(std::move(steps))) {
       hit->Print();
-      auto ntupleid = rmg_man->GetNtupleID(hit->detector_uid);
 
       int col_id = 0;
       // store the indices
@@ -366,6 +369,7 @@ void RMGGermaniumOutputScheme::StoreEvent(const G4Event* event) {
             fStoreSinglePrecisionPosition
         );
       }
+      if (fReshapeHits) ana_man->FillNtupleIColumn(ntupleid, col_id++, hit_start);
       // NOTE: must be called here for hit-oriented output
       ana_man->AddNtupleRow(ntupleid);
     }
@@ -383,7 +387,7 @@ std::optional<bool> RMGGermaniumOutputScheme::StackingActionNewStage(const int s
   return ShouldDiscardEvent(event) ? std::make_optional(false) : std::nullopt;
 }
 
-void RMGGermaniumOutputScheme::EndOfRunAction(const G4Run*) {
+void RMGGermaniumOutputScheme::EndOfOutputFile() {
   auto rmg_man = RMGOutputManager::Instance();
   if (!rmg_man->IsPersistencyEnabled() ||
       (G4Threading::IsMasterThread() && !RMGManager::Instance()->IsExecSequential()))
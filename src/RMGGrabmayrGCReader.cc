@@ -17,13 +17,54 @@
 
 #include "RMGGrabmayrGCReader.hh"
 
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include <unistd.h>
+
+#include "G4AutoLock.hh"
 #include "G4Tokenizer.hh"
 #include "Randomize.hh"
 
 #include "RMGLog.hh"
 
+namespace fs = std::filesystem;
+
+namespace {
+
+  constexpr char kCacheMagic[8] = "RMGGC01";
+
+  // identifies the version of the source file, a cache file is only valid for the same version.
+  struct SourceStamp {
+      std::uint64_t size = 0;
+      std::int64_t mtime = 0;
+  };
+
+  SourceStamp GetSourceStamp(const std::string& file_name) {
+    std::error_code ec;
+    SourceStamp stamp;
+    stamp.size = fs::file_size(file_name, ec);
+    stamp.mtime = fs::last_write_time(file_name, ec).time_since_epoch().count();
+    return stamp;
+  }
+
+  template<typename T> void WriteArray(std::ofstream& out, const std::vector<T>& vec) {
+    out.write(reinterpret_cast<const char*>(vec.data()), vec.size() * sizeof(T));
+  }
+
+  template<typename T> void ReadArray(std::ifstream& in, std::vector<T>& vec, size_t n) {
+    vec.resize(n);
+    in.read(reinterpret_cast<char*>(vec.data()), n * sizeof(T));
+  }
+
+} // namespace
 
 G4ThreadLocal RMGGrabmayrGCReader* RMGGrabmayrGCReader::instance = nullptr;
+std::map<std::string, std::shared_ptr<const RMGGrabmayrGCReader::CascadeTable>>
+    RMGGrabmayrGCReader::fTables;
+G4Mutex RMGGrabmayrGCReader::fTablesMutex = G4MUTEX_INITIALIZER;
 
 RMGGrabmayrGCReader* RMGGrabmayrGCReader::GetInstance() {
   if (instance == nullptr) { instance = new RMGGrabmayrGCReader(); }
@@ -36,9 +77,7 @@ RMGGrabmayrGCReader::~RMGGrabmayrGCReader() { CloseFiles(); }
 
 void RMGGrabmayrGCReader::CloseFiles() {
   RMGLog::Out(RMGLog::detail, "Closing gamma cascade files");
-  for (const auto& el : fCascadeFiles) {
-    if (el.second->is_open()) { el.second->close(); }
-  }
+  fCascadeFiles.clear();
 }
 
 // Returns true if there exists a cascade file for the Isotope Z, A
@@ -55,84 +94,195 @@ GammaCascadeLine RMGGrabmayrGCReader::GetNextEntry(G4int z, G4int a) {
   auto it = fCascadeFiles.find(key);
   if (it == fCascadeFiles.end())
     RMGLog::OutFormat(RMGLog::fatal, "Isotope Z: {} A: {} does not exist.", z, a);
-  // read next line from file
+
+  auto& file = it->second;
+  const auto& table = *file.table;
+  if (file.next >= table.size()) {
+    RMGLog::Out(RMGLog::debug_event, "Gamma cascade file EOF reached, starting from the beginning");
+    file.next = 0;
+  }
+  const size_t i = file.next++;
+
+  GammaCascadeLine gamma_cascade{};
+  gamma_cascade.en = table.en[i];
+  gamma_cascade.ex = table.ex[i];
+  gamma_cascade.em = table.em[i];
+  gamma_cascade.m = static_cast<G4int>(table.offsets[i + 1] - table.offsets[i]);
+  gamma_cascade.eg.assign(
+      table.eg.begin() + table.offsets[i],
+      table.eg.begin() + table.offsets[i + 1]
+  );
+  return gamma_cascade;
+}
+
+std::shared_ptr<RMGGrabmayrGCReader::CascadeTable> RMGGrabmayrGCReader::ParseTable(
+    const std::string& file_name
+) {
+  std::ifstream file(file_name);
+  if (!file.is_open())
+    RMGLog::Out(RMGLog::fatal, "Gamma cascade file: " + file_name + " not found! Exit.");
+
+  auto table = std::make_shared<CascadeTable>();
+  table->offsets.push_back(0);
   std::string line;
-  do { // NOLINT(cppcoreguidelines-avoid-do-while)
-    if (!std::getline(*(it->second), line)) {
-      // if end-of-file is reached, reset file and read first line
-      RMGLog::Out(RMGLog::debug_event, "Gamma cascade file EOF reached, re-opening the file");
-      it->second->clear();                 // clear EOF flag
-      it->second->seekg(0, std::ios::beg); // move to beginning of file
-      if (!std::getline(*(it->second), line)) {
-        RMGLog::Out(RMGLog::fatal, "Failed to read next line after re-opening the file. Exit!");
-      }
+  while (std::getline(file, line)) {
+    // skip header lines.
+    if (line.empty() || line[0] == '%' || line.find("version") != std::string::npos) continue;
+
+    const char* pos = line.c_str();
+    char* next = nullptr;
+    G4int values[4];
+    int n_values = 0;
+    for (; n_values < 4; n_values++) {
+      values[n_values] = static_cast<G4int>(std::strtol(pos, &next, 10));
+      if (next == pos) break;
+      pos = next;
+    }
+    if (n_values == 0) continue; // whitespace-only line.
+    if (n_values < 4 || values[2] < 0) {
+      RMGLog::Out(RMGLog::fatal, "Failed to read gamma cascade from file ", file_name, ". Exit!");
     }
-  } while (line[0] == '%' || (line.find("version") !=
-                              std::string::npos)); // This could be outsourced to SetStartLocation
 
-  // parse line and return as struct
-  GammaCascadeLine gamma_cascade{};
-  std::istringstream iss(line);
-  iss >> gamma_cascade.en >> gamma_cascade.ex >> gamma_cascade.m >> gamma_cascade.em;
-  gamma_cascade.eg.reserve(gamma_cascade.m);
-  int eg_value = 0;
-  for (int i = 0; i < gamma_cascade.m; i++) {
-    if (!(iss >> eg_value)) {
-      RMGLog::Out(RMGLog::fatal, "Failed to read gamma energy from file. Exit!");
+    table->en.push_back(values[0]);
+    table->ex.push_back(values[1]);
+    table->em.push_back(values[3]);
+    for (int i = 0; i < values[2]; i++) {
+      const auto eg_value = static_cast<G4int>(std::strtol(pos, &next, 10));
+      if (next == pos) RMGLog::Out(RMGLog::fatal, "Failed to read gamma energy from file. Exit!");
+      table->eg.push_back(eg_value);
+      pos = next;
     }
-    gamma_cascade.eg.push_back(eg_value);
+    table->offsets.push_back(table->eg.size());
   }
-  return gamma_cascade;
+
+  if (table->size() == 0)
+    RMGLog::Out(RMGLog::fatal, "Gamma cascade file: " + file_name + " has no entries! Exit.");
+
+  return table;
 }
 
+std::shared_ptr<RMGGrabmayrGCReader::CascadeTable> RMGGrabmayrGCReader::ReadBinaryCache(
+    const std::string& cache_name,
+    const std::string& file_name
+) {
+  std::ifstream in(cache_name, std::ios::binary);
+  if (!in.is_open()) return nullptr;
+
+  char magic[sizeof(kCacheMagic)];
+  SourceStamp stamp;
+  std::uint64_t n_entries = 0, n_eg = 0;
+  in.read(magic, sizeof(magic));
+  in.read(reinterpret_cast<char*>(&stamp), sizeof(stamp));
+  in.read(reinterpret_cast<char*>(&n_entries), sizeof(n_entries));
+  in.read(reinterpret_cast<char*>(&n_eg), sizeof(n_eg));
+
+  const auto source_stamp = GetSourceStamp(file_name);
+  if (!in || std::memcmp(magic, kCacheMagic, sizeof(magic)) != 0 ||
+      stamp.size != source_stamp.size || stamp.mtime != source_stamp.mtime) {
+    RMGLog::Out(RMGLog::detail, "Ignoring outdated gamma cascade cache file ", cache_name);
+    return nullptr;
+  }
 
-void RMGGrabmayrGCReader::SetStartLocation(std::ifstream& file) const {
-  if (!file.is_open())
-    RMGLog::Out(RMGLog::fatal, "The file is not open to set start location! Exit.");
-  file.clear();                 // clear EOF flag
-  file.seekg(0, std::ios::beg); // move to beginning of file
-  // Skip Header
-  std::string line;
-  int header_length = 0;
-  do { // NOLINT(cppcoreguidelines-avoid-do-while)
-    std::getline(file, line);
-    header_length++;
-  } while (line[0] == '%' || (line.find("version") != std::string::npos));
+  auto table = std::make_shared<CascadeTable>();
+  ReadArray(in, table->en, n_entries);
+  ReadArray(in, table->ex, n_entries);
+  ReadArray(in, table->em, n_entries);
+  ReadArray(in, table->offsets, n_entries + 1);
+  ReadArray(in, table->eg, n_eg);
+  if (!in || n_entries == 0 || table->offsets.back() != n_eg) {
+    RMGLog::Out(RMGLog::warning, "Ignoring invalid gamma cascade cache file ", cache_name);
+    return nullptr;
+  }
+  return table;
+}
 
-  // In case the Random start location macro is set
-  if (fGammaCascadeRandomStartLocation) {
-    int n_entries_in_file = 0;
-    // Seems excessiv to read through the entire file, there has to be a quicker way?
-    while (std::getline(file, line)) n_entries_in_file++;
+void RMGGrabmayrGCReader::WriteBinaryCache(
+    const CascadeTable& table,
+    const std::string& cache_name,
+    const std::string& file_name
+) {
+  // other processes might read or write the same cache, so write it to a temporary file first.
+  const auto tmp_name = cache_name + ".tmp" + std::to_string(::getpid());
+  {
+    std::ofstream out(tmp_name, std::ios::binary);
+    const auto stamp = GetSourceStamp(file_name);
+    const std::uint64_t n_entries = table.size(), n_eg = table.eg.size();
+    out.write(kCacheMagic, sizeof(kCacheMagic));
+    out.write(reinterpret_cast<const char*>(&stamp), sizeof(stamp));
+    out.write(reinterpret_cast<const char*>(&n_entries), sizeof(n_entries));
+    out.write(reinterpret_cast<const char*>(&n_eg), sizeof(n_eg));
+    WriteArray(out, table.en);
+    WriteArray(out, table.ex);
+    WriteArray(out, table.em);
+    WriteArray(out, table.offsets);
+    WriteArray(out, table.eg);
+    if (!out) {
+      RMGLog::Out(RMGLog::detail, "Could not write gamma cascade cache file ", cache_name);
+      out.close();
+      std::error_code ec;
+      fs::remove(tmp_name, ec);
+      return;
+    }
+  }
+
+  std::error_code ec;
+  fs::rename(tmp_name, cache_name, ec);
+  if (ec) {
+    RMGLog::Out(RMGLog::detail, "Could not write gamma cascade cache file ", cache_name);
+    fs::remove(tmp_name, ec);
+  }
+}
 
-    file.clear();                 // clear EOF flag
-    file.seekg(0, std::ios::beg); // move to beginning of file
+std::shared_ptr<const RMGGrabmayrGCReader::CascadeTable> RMGGrabmayrGCReader::LoadTable(
+    const std::string& file_name,
+    bool cache
+) {
+  G4AutoLock lock(&fTablesMutex);
+
+  // the file has already been loaded by another thread.
+  auto it = fTables.find(file_name);
+  if (it != fTables.end()) return it->second;
+
+  const auto cache_name = file_name + ".rmgcache";
+  std::shared_ptr<CascadeTable> table = cache ? ReadBinaryCache(cache_name, file_name) : nullptr;
+  if (table) {
+    RMGLog::Out(RMGLog::detail, "Read gamma cascades from cache file ", cache_name);
+  } else {
+    RMGLog::Out(RMGLog::detail, "Reading gamma cascade file ", file_name);
+    table = ParseTable(file_name);
+    if (cache) WriteBinaryCache(*table, cache_name, file_name);
+  }
+  RMGLog::OutFormat(RMGLog::debug, "Loaded {} gamma cascades from {}", table->size(), file_name);
 
-    int start_location = (int)(n_entries_in_file * G4UniformRand() + header_length);
+  fTables.emplace(file_name, table);
+  return table;
+}
 
-    RMGLog::Out(RMGLog::detail, "Random start location: ", start_location);
-    for (int j = 0; j < start_location; j++) std::getline(file, line);
+void RMGGrabmayrGCReader::SetStartLocation(CascadeFile& file) const {
+  file.next = 0;
+
+  // In case the Random start location macro is set
+  if (fGammaCascadeRandomStartLocation) {
+    const auto n_entries = file.table->size();
+    file.next = std::min(static_cast<size_t>(n_entries * G4UniformRand()), n_entries - 1);
+    RMGLog::Out(RMGLog::detail, "Random start location: ", file.next);
   }
 }
 
 void RMGGrabmayrGCReader::SetGammaCascadeFile(const G4int z, const G4int a, const G4String file_name) {
 
-  RMGLog::Out(RMGLog::detail, "Opening file ", file_name);
-  std::unique_ptr<std::ifstream> file = std::make_unique<std::ifstream>(file_name);
-
   if (z == 0 || a == 0)
     RMGLog::OutFormat(RMGLog::fatal, "Isotope Z: {} A: {} does not exist.", z, a);
-  if (!file || !file->is_open())
-    RMGLog::Out(RMGLog::fatal, "Gamma cascade file: " + file_name + " not found! Exit.");
 
-  SetStartLocation(*file);
+  CascadeFile file{LoadTable(file_name, fUseBinaryCache), 0};
+  SetStartLocation(file);
 
-  fCascadeFiles.insert(std::make_pair(std::make_pair(z, a), std::move(file)));
+  fCascadeFiles.insert_or_assign(std::make_pair(z, a), std::move(file));
 }
 
 void RMGGrabmayrGCReader::RandomizeFiles() {
   RMGLog::Out(RMGLog::detail, "(Un)-Randomizing start locations");
-  for (auto& el : fCascadeFiles) { SetStartLocation(*el.second); }
+  for (auto& el : fCascadeFiles) { SetStartLocation(el.second); }
 }
 
 void RMGGrabmayrGCReader::SetGammaCascadeRandomStartLocation(const int answer) {
@@ -164,6 +314,19 @@ void RMGGrabmayrGCReader::DefineCommands() {
       .SetDefaultValue("0")
       .SetStates(G4State_PreInit, G4State_Idle);
 
+  fGenericMessenger->DeclareProperty("UseBinaryCache", fUseBinaryCache)
+      .SetGuidance(
+          "Store the parsed gamma cascades in a binary cache file next to each cascade file, and "
+          "read them from there in later runs"
+      )
+      .SetGuidance("note: this only applies to cascade files that are set after this command.")
+      .SetGuidance(
+          std::string("This is ") + (fUseBinaryCache ? "enabled" : "disabled") + " by default"
+      )
+      .SetParameterName("boolean", true)
+      .SetDefaultValue("true")
+      .SetStates(G4State_PreInit, G4State_Idle);
+
   // SetGammaCascadeFile cannot be defined with the G4GenericMessenger (it has too many parameters).
   fUIMessenger = std::make_unique<GCMessenger>(this);
 }
@@ -18,15 +18,23 @@
 #include <algorithm>
 #include <filesystem>
 #include <format>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include <unistd.h>
 namespace fs = std::filesystem;
 
 #include "G4GenericMessenger.hh"
-#include "G4GeomTestVolume.hh"
+#include "G4LogicalSkinSurface.hh"
 #include "G4LogicalVolume.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4OpticalSurface.hh"
 #include "G4PhysicalVolumeStore.hh"
 #include "G4SDManager.hh"
 #include "G4UserLimits.hh"
 #include "G4VPhysicalVolume.hh"
+#include "G4Version.hh"
 
 #include "RMGCalorimeterDetector.hh"
 #include "RMGCalorimeterOutputScheme.hh"
@@ -137,11 +145,9 @@ G4VPhysicalVolume* RMGHardware::Construct() {
       }
     }
 
-    // Check for overlaps, but with no verbose output.
-    if (!fGDMLDisableOverlapCheck) {
-      RMGLog::Out(RMGLog::summary, "Checking for overlaps in GDML geometry...");
-      auto test_vol = new G4GeomTestVolume(fWorld, 0, fGDMLOverlapCheckNumPoints, /* verbosity = */ false);
-      test_vol->TestOverlapInTree();
+    // Check for overlaps, but with no verbose output. The geometry is the same in all processes.
+    if (!fGDMLDisableOverlapCheck && RMGManager::Instance()->GetProcessNumberOffset() == 0) {
+      this->CheckGDMLOverlaps();
     }
 #else
     RMGLog::OutDev(RMGLog::fatal, "GDML support is not available!");
@@ -312,6 +318,8 @@ G4VPhysicalVolume* RMGHardware::Construct() {
     }
   }
 
+  this->SetupOpticalDetectorEfficiencies();
+
   return fWorld;
 }
 
@@ -585,6 +593,143 @@ void RMGHardware::SetEminLimitForParticle(double ekin_min, std::string name, std
   );
 }
 
+void RMGHardware::SetOpticalDetectorEfficiency(std::string file_name, std::string name) {
+
+  if (!fs::exists(file_name)) {
+    RMGLog::OutFormat(RMGLog::fatal, "Detection efficiency file {} does not exist", file_name);
+  }
+
+  fPhysVolOpticalEfficiencyFiles.insert_or_assign(name, file_name);
+
+  RMGLog::OutFormat(RMGLog::detail, "Set detection efficiency for {:s} from {:s}", name, file_name);
+}
+
+std::unique_ptr<G4PhysicsFreeVector> RMGHardware::ReadOpticalEfficiencyFile(
+    const std::string& file_name
+) {
+  std::ifstream file(file_name);
+  if (!file.is_open()) {
+    RMGLog::OutFormat(RMGLog::fatal, "Could not open detection efficiency file {}", file_name);
+  }
+
+  // the file holds (wavelength, efficiency) pairs, the physics vector needs increasing energies.
+  std::map<double, double> table;
+  std::string line;
+  while (std::getline(file, line)) {
+    line = line.substr(0, line.find('#'));
+    if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+
+    std::istringstream iss(line);
+    double wvl = 0, eff = 0;
+    if (!(iss >> wvl >> eff) || wvl <= 0 || eff < 0 || eff > 1) {
+      RMGLog::OutFormat(
+          RMGLog::fatal,
+          "Invalid line '{}' in detection efficiency file {} (expected wavelength in nm and "
+          "efficiency between 0 and 1)",
+          line,
+          file_name
+      );
+    }
+    table.insert_or_assign(CLHEP::h_Planck * CLHEP::c_light / (wvl * CLHEP::nm), eff);
+  }
+
+  if (table.size() < 2) {
+    RMGLog::OutFormat(
+        RMGLog::fatal,
+        "Detection efficiency file {} needs to contain at least two entries",
+        file_name
+    );
+  }
+
+  std::vector<double> energies, values;
+  for (const auto& [e, v] : table) {
+    energies.push_back(e);
+    values.push_back(v);
+  }
+  return std::make_unique<G4PhysicsFreeVector>(energies, values);
+}
+
+void RMGHardware::SetupOpticalDetectorEfficiencies() {
+
+  fOpticalDetectorEfficiencies.clear();
+  fOpticalEfficiencyTables.clear();
+
+  // tables from files, read only once even if they are used for multiple volumes.
+  std::map<const G4VPhysicalVolume*, const G4PhysicsVector*> pv_tables;
+  std::map<std::string, const G4PhysicsVector*> file_tables;
+  for (const auto& [vol_name, file_name] : fPhysVolOpticalEfficiencyFiles) {
+    auto volumes = RMGNavigationTools::FindPhysicalVolume(vol_name);
+    if (volumes.empty()) {
+      RMGLog::OutFormat(
+          RMGLog::error,
+          "No matching volumes for '{}' found, skipping detection efficiency setting",
+          vol_name
+      );
+      continue;
+    }
+
+    auto [it, inserted] = file_tables.try_emplace(file_name, nullptr);
+    if (inserted) {
+      fOpticalEfficiencyTables.emplace_back(ReadOpticalEfficiencyFile(file_name));
+      it->second = fOpticalEfficiencyTables.back().get();
+    }
+    for (const auto& vol : volumes) pv_tables.insert_or_assign(vol, it->second);
+  }
+
+  for (const auto& [k, v] : fDetectorMetadata) {
+    if (v.type != RMGDetectorType::kOptical) continue;
+
+    auto volumes = RMGNavigationTools::FindPhysicalVolume(k.first, std::to_string(k.second));
+    if (volumes.empty()) continue;
+    const auto pv = *volumes.begin();
+    const auto lv = pv->GetLogicalVolume();
+
+    // precedence: macro command, skin surface, material.
+    const G4PhysicsVector* efficiency = nullptr;
+    std::string source;
+    if (auto it = pv_tables.find(pv); it != pv_tables.end()) {
+      efficiency = it->second;
+      source = "file";
+    }
+    if (!efficiency) {
+      auto skin = G4LogicalSkinSurface::GetSurface(lv);
+      auto surface = skin ? dynamic_cast<G4OpticalSurface*>(skin->GetSurfaceProperty()) : nullptr;
+      auto mpt = surface ? surface->GetMaterialPropertiesTable() : nullptr;
+      if (mpt && (efficiency = mpt->GetProperty("RMG_DETECTIONEFFICIENCY"))) {
+        source = "surface " + surface->GetName();
+      }
+    }
+    if (!efficiency) {
+      auto mpt = lv->GetMaterial()->GetMaterialPropertiesTable();
+      if (mpt && (efficiency = mpt->GetProperty("RMG_DETECTIONEFFICIENCY"))) {
+        source = "material " + lv->GetMaterial()->GetName();
+      }
+    }
+    if (!efficiency) continue;
+
+    auto [it, inserted] = fOpticalDetectorEfficiencies.try_emplace(v.uid, efficiency);
+    if (!inserted && it->second != efficiency) {
+      RMGLog::OutFormat(
+          RMGLog::error,
+          "Conflicting detection efficiencies for optical detector uid {}, ignoring the one of "
+          "volume '{}' (copy nr. {})",
+          v.uid,
+          k.first,
+          k.second
+      );
+      continue;
+    }
+
+    RMGLog::OutFormat(
+        RMGLog::detail,
+        "Applying detection efficiency from {} to optical detector '{}' (uid={})",
+        source,
+        k.first,
+        v.uid
+    );
+  }
+}
+
 bool RMGHardware::IsEminLimitParticleSelected(
     const G4LogicalVolume* logical,
     const std::string& particle_name
@@ -605,6 +750,81 @@ void RMGHardware::RegisterDetectorsFromGDML(std::string s) {
   }
 }
 
+void RMGHardware::CheckGDMLOverlaps() {
+
+  // the verdict only depends on the solids and placements of the geometry and on the check
+  // parameters. Hash the parsed geometry instead of the GDML files, as these can include other
+  // files (with <file> elements or XML entities).
+  fs::path cache_file;
+  if (!fGDMLCheckCacheDir.empty()) {
+    std::ostringstream key;
+    key.precision(17);
+    key << "overlaps " << G4VERSION_NUMBER << " " << fGDMLOverlapCheckNumPoints << "\n";
+    for (const auto* lv : *G4LogicalVolumeStore::GetInstance()) {
+      key << "lv " << lv->GetName() << "\n";
+      lv->GetSolid()->StreamInfo(key);
+      for (size_t i = 0; i < lv->GetNoDaughters(); i++) {
+        const auto* pv = lv->GetDaughter(i);
+        key << "pv " << pv->GetName() << " " << pv->GetCopyNo() << " "
+            << pv->GetLogicalVolume()->GetName() << " " << pv->GetTranslation() << " "
+            << pv->GetObjectRotationValue() << "\n";
+      }
+    }
+    const auto hash = RMGTools::Hash(key.str());
+    cache_file = fs::path(fGDMLCheckCacheDir) / std::format("overlaps-{:016x}.txt", hash);
+  }
+
+  std::vector<std::string> overlaps;
+  if (!cache_file.empty() && fs::exists(cache_file)) {
+    RMGLog::Out(
+        RMGLog::summary,
+        "Skipping overlap check of unchanged GDML geometry, cached result in ",
+        cache_file.string()
+    );
+    std::ifstream in(cache_file);
+    for (std::string line; std::getline(in, line);) {
+      if (!line.empty()) overlaps.push_back(line);
+    }
+  } else {
+    const size_t n_threads = fGDMLOverlapCheckThreads > 0 ? fGDMLOverlapCheckThreads
+                                                          : std::thread::hardware_concurrency();
+    RMGLog::OutFormat(
+        RMGLog::summary,
+        "Checking for overlaps in GDML geometry (with {} threads)...",
+        n_threads
+    );
+    const auto overlapping =
+        RMGNavigationTools::CheckOverlapsInTree(fWorld, fGDMLOverlapCheckNumPoints, n_threads);
+    for (const auto* pv : overlapping) {
+      overlaps.push_back(std::format("{} ({})", pv->GetName(), pv->GetCopyNo()));
+    }
+
+    if (!cache_file.empty()) {
+      // write to a temporary file first, so that concurrent jobs never read a partial result.
+      std::error_code ec;
+      fs::create_directories(cache_file.parent_path(), ec);
+      auto tmp_file = cache_file;
+      tmp_file += ".tmp" + std::to_string(::getpid());
+      std::ofstream out(tmp_file);
+      for (const auto& o : overlaps) out << o << "\n";
+      out.close();
+      if (out.fail()) {
+        RMGLog::Out(RMGLog::warning, "Could not write overlap check cache ", cache_file.string());
+        fs::remove(tmp_file, ec);
+      } else fs::rename(tmp_file, cache_file, ec);
+    }
+  }
+
+  if (!overlaps.empty()) {
+    RMGLog::OutFormat(
+        RMGLog::warning,
+        "Found overlaps of {} volume(s) in GDML geometry: {}",
+        overlaps.size(),
+        fmt::join(overlaps, ", ")
+    );
+  }
+}
+
 void RMGHardware::DefineCommands() {
 
   fMessenger = std::make_unique<G4GenericMessenger>(
@@ -623,6 +843,24 @@ void RMGHardware::DefineCommands() {
       .SetGuidance("Change the number of points sampled for overlap checks")
       .SetStates(G4State_PreInit);
 
+  fMessenger->DeclareProperty("GDMLOverlapCheckThreads", fGDMLOverlapCheckThreads)
+      .SetGuidance("Change the number of threads used for overlap checks")
+      .SetGuidance("The volumes are distributed over all available CPU cores by default (0).")
+      .SetParameterName("n", false)
+      .SetRange("n >= 0")
+      .SetStates(G4State_PreInit);
+
+  fMessenger->DeclareProperty("GDMLCheckCache", fGDMLCheckCacheDir)
+      .SetGuidance("Directory to cache the result of overlap checks in.")
+      .SetGuidance(
+          "The result is cached per solids and placements of the loaded geometry (including all "
+          "files included by the GDML files) and number of points. The overlap check of an "
+          "unchanged geometry is skipped, and only the cached overlaps are reported."
+      )
+      .SetGuidance("The cache is disabled by default.")
+      .SetParameterName("dir", false)
+      .SetStates(G4State_PreInit);
+
   fMessenger->DeclareProperty("GDMLDisableXmlCheck", fGDMLDisableXmlCheck)
       .SetGuidance("Disable the automatic xml validity check after loading a GDML file")
       .SetParameterName("boolean", true)
@@ -26,12 +26,14 @@ RMGHardwareMessenger::RMGHardwareMessenger(RMGHardware* hw) : fHardware(hw) {
   this->DefineRegisterDetector();
   this->DefineStepLimits();
   this->DefineSelectiveEminLimits();
+  this->DefineOpticalDetectorEfficiency();
 }
 
 RMGHardwareMessenger::~RMGHardwareMessenger() {
   delete fRegisterCmd;
   delete fStepLimitsCmd;
   delete fSelectiveEminLimitCmd;
+  delete fOpticalEfficiencyCmd;
 }
 
 void RMGHardwareMessenger::SetNewValue(G4UIcommand* command, G4String newValues) {
@@ -39,6 +41,7 @@ void RMGHardwareMessenger::SetNewValue(G4UIcommand* command, G4String newValues)
   if (command == fRegisterCmd) RegisterDetectorCmd(newValues);
   else if (command == fStepLimitsCmd) StepLimitsCmd(newValues);
   else if (command == fSelectiveEminLimitCmd) SelectiveEminLimitCmd(newValues);
+  else if (command == fOpticalEfficiencyCmd) OpticalDetectorEfficiencyCmd(newValues);
 }
 
 void RMGHardwareMessenger::DefineRegisterDetector() {
@@ -122,6 +125,28 @@ void RMGHardwareMessenger::DefineSelectiveEminLimits() {
   fSelectiveEminLimitCmd->AvailableForStates(G4State_PreInit);
 }
 
+void RMGHardwareMessenger::DefineOpticalDetectorEfficiency() {
+
+  fOpticalEfficiencyCmd = new G4UIcommand("/RMG/Geometry/SetOpticalDetectorEfficiency", this);
+  fOpticalEfficiencyCmd->SetGuidance(
+      "Sets a wavelength-dependent detection efficiency for an optical detector"
+  );
+  fOpticalEfficiencyCmd->SetGuidance(
+      "note: photons are rejected before a hit is recorded. Takes precedence over a "
+      "RMG_DETECTIONEFFICIENCY property of the skin surface or material of the volume."
+  );
+
+  auto p_file = new G4UIparameter("file_name", 's', false);
+  p_file->SetGuidance("text file with two columns: wavelength in nm and efficiency (0 to 1)");
+  fOpticalEfficiencyCmd->SetParameter(p_file);
+
+  auto p_pv = new G4UIparameter("pv_name", 's', false);
+  p_pv->SetGuidance("Detector physical volume, accepts regex patterns");
+  fOpticalEfficiencyCmd->SetParameter(p_pv);
+
+  fOpticalEfficiencyCmd->AvailableForStates(G4State_PreInit);
+}
+
 void RMGHardwareMessenger::RegisterDetectorCmd(const std::string& parameters) {
   G4Tokenizer next(parameters);
 
@@ -162,4 +187,13 @@ void RMGHardwareMessenger::SelectiveEminLimitCmd(const std::string& parameters)
   fHardware->SetEminLimitForParticle(num, pv_name, particle_name);
 }
 
+void RMGHardwareMessenger::OpticalDetectorEfficiencyCmd(const std::string& parameters) {
+  G4Tokenizer next(parameters);
+
+  auto file_name = next();
+  auto pv_name = next();
+
+  fHardware->SetOpticalDetectorEfficiency(file_name, pv_name);
+}
+
 // vim: tabstop=2 shiftwidth=2 expandtab
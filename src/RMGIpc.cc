@@ -15,6 +15,11 @@
 
 #include "RMGIpc.hh"
 
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+
 #include <poll.h>
 #include <unistd.h>
 
@@ -23,6 +28,24 @@
 #include "RMGLog.hh"
 #include "RMGVersion.hh"
 
+namespace {
+
+#ifdef PIPE_BUF
+  // writes of up to this size to a pipe are atomic, i.e. never interleaved with other processes.
+  constexpr size_t kMaxWriteSize = PIPE_BUF;
+#else
+  constexpr size_t kMaxWriteSize = 512; // the POSIX minimum.
+#endif
+
+  uint32_t FramePayloadSize(const char* header) {
+    uint32_t size = 0;
+    for (int i = 0; i < 4; i++) {
+      size |= static_cast<uint32_t>(static_cast<uint8_t>(header[i])) << (8 * i);
+    }
+    return size;
+  }
+
+} // namespace
 
 void RMGIpc::Setup(int ipc_pipe_fd_out, int ipc_pipe_fd_in, int proc_num) {
   if (!G4Threading::IsMasterThread()) {
@@ -34,6 +57,9 @@ void RMGIpc::Setup(int ipc_pipe_fd_out, int ipc_pipe_fd_in, int proc_num) {
   fProcNum = proc_num;
   if (fIpcFdOut < 0 || fIpcFdIn < 0) return;
 
+  // do not lose buffered messages at a regular exit.
+  std::atexit([] { Flush(); });
+
   bool perform_versioncheck = true;
   if (auto check_s = std::getenv("RMG_IPC_DISABLE_VERSION_CHECK")) {
     perform_versioncheck = std::atoi(check_s) > 0;
@@ -47,15 +73,24 @@ void RMGIpc::Setup(int ipc_pipe_fd_out, int ipc_pipe_fd_in, int proc_num) {
   }
 }
 
-bool RMGIpc::SendIpcBlocking(std::string msg) {
+void RMGIpc::SetupForkedProcess(int ipc_pipe_fd_in, int proc_num) {
+  fProcNum = proc_num;
+  if (fIpcFdOut < 0) return;
+  fIpcFdIn = ipc_pipe_fd_in;
+}
+
+bool RMGIpc::SendIpcBlocking(const std::string& msg, std::string* response) {
   if (!G4Threading::IsMasterThread()) {
     RMGLog::OutDev(RMGLog::fatal, "can only be used on the master thread");
   }
   if (fIpcFdOut < 0) return false;
 
-  msg += "\x05"; // ASCII ENQ enquiry = ask for continuation.
-
-  if (!SendIpcNonBlocking(msg)) { return false; }
+  // the buffered messages are sent first, to keep the order of all messages.
+  {
+    std::lock_guard lock(fSendMutex);
+    AppendFrames(msg, kFlagBlocking);
+    if (!FlushLocked()) return false;
+  }
 
   // wait for result.
   pollfd pfd{.fd = fIpcFdIn, .events = POLLIN, .revents = 0};
@@ -64,39 +99,95 @@ bool RMGIpc::SendIpcBlocking(std::string msg) {
   int ready = 0;
   ready = poll(&pfd, 1, timeout);
   while ((ready == -1 && errno == EINTR) || ready == 0) { ready = poll(&pfd, 1, timeout); }
-  char ack[2] = "";
-  auto acklen = read(fIpcFdIn, ack, sizeof(ack));
-  if (acklen != 1 || ack[0] != '\x06') {
+  // the ACK might be preceded by response data.
+  std::string data;
+  char buf[64];
+  while (data.empty() || data.back() != '\x06') {
+    auto len = read(fIpcFdIn, buf, sizeof(buf));
+    if (len == -1 && errno == EINTR) continue;
+    if (len <= 0) {
+      RMGLog::Out(RMGLog::fatal, "IPC error: wrong ACK");
+      return false;
+    }
+    data.append(buf, len);
+  }
+  if (response) *response = data.substr(0, data.size() - 1);
+  else if (data.size() != 1) {
     RMGLog::Out(RMGLog::fatal, "IPC error: wrong ACK");
     return false;
   }
   return true;
 }
 
-bool RMGIpc::SendIpcNonBlocking(std::string msg) {
+bool RMGIpc::SendIpcNonBlocking(const std::string& msg) {
   if (fIpcFdOut < 0) return false;
 
-  msg = std::to_string(fProcNum) + "\x1e" + msg;
+  std::lock_guard lock(fSendMutex);
+  AppendFrames(msg, 0);
+  if (fSendBuffer.size() >= kSendBufferSize) return FlushLocked();
+  return true;
+}
 
-  msg += "\x1d"; // ASCII GS group separator = end of message.
-  if (msg.size() > SSIZE_MAX) {
-    RMGLog::Out(RMGLog::error, "IPC message transmit failed for too-large message");
-    return false;
-  }
+bool RMGIpc::Flush() {
+  if (fIpcFdOut < 0) return false;
 
-  auto len = write(fIpcFdOut, msg.c_str(), msg.size());
+  std::lock_guard lock(fSendMutex);
+  return FlushLocked();
+}
 
-  if (len < 0) {
-    RMGLog::Out(RMGLog::error, "IPC message transmit failed with errno=", errno);
-    return false;
-  }
+void RMGIpc::AppendFrames(std::string_view msg, uint8_t flags) {
+  // split long messages into frames that can be written atomically. The receiver joins the
+  // frames of each process, which are marked as continued except for the last one.
+  const size_t max_payload = kMaxWriteSize - kFrameHeaderSize;
+  do {
+    const auto payload = msg.substr(0, max_payload);
+    msg.remove_prefix(payload.size());
+    const auto size = static_cast<uint32_t>(payload.size());
+    const auto proc_num = static_cast<uint16_t>(std::max(fProcNum, 0));
+    const char header[kFrameHeaderSize] = {
+        static_cast<char>(size & 0xff),
+        static_cast<char>((size >> 8) & 0xff),
+        static_cast<char>((size >> 16) & 0xff),
+        static_cast<char>((size >> 24) & 0xff),
+        static_cast<char>(proc_num & 0xff),
+        static_cast<char>((proc_num >> 8) & 0xff),
+        static_cast<char>(msg.empty() ? flags : kFlagContinued),
+        0,
+    };
+    fSendBuffer.append(header, kFrameHeaderSize);
+    fSendBuffer.append(payload);
+  } while (!msg.empty());
+}
 
-  if ((size_t)len != msg.size()) {
-    // TODO: better handle this case.
-    RMGLog::Out(RMGLog::error, "IPC message not fully transmitted. missing=", msg.size() - len);
-    return false;
+bool RMGIpc::FlushLocked() {
+  // all processes share the same pipe, so only write whole frames with each call.
+  bool success = true;
+  size_t begin = 0, end = 0;
+  while (end < fSendBuffer.size()) {
+    const size_t frame_size = kFrameHeaderSize + FramePayloadSize(fSendBuffer.data() + end);
+    if (end + frame_size - begin > kMaxWriteSize) {
+      success &= Write(fSendBuffer.data() + begin, end - begin);
+      begin = end;
+    }
+    end += frame_size;
   }
+  if (end > begin) success &= Write(fSendBuffer.data() + begin, end - begin);
+  fSendBuffer.clear();
+  return success;
+}
 
+bool RMGIpc::Write(const char* data, size_t size) {
+  while (size > 0) {
+    const auto len = write(fIpcFdOut, data, size);
+    if (len < 0 && errno == EINTR) continue;
+    if (len < 0) {
+      RMGLog::Out(RMGLog::error, "IPC message transmit failed with errno=", errno);
+      return false;
+    }
+    // this does not happen for atomic writes to a blocking pipe, but is possible otherwise.
+    data += len;
+    size -= len;
+  }
   return true;
 }
 
@@ -0,0 +1,232 @@
+// Copyright (C) 2026
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "RMGLH5Reader.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <regex>
+
+#include "RMGLog.hh"
+
+namespace {
+
+  std::string GetStringAttribute(H5::H5Object& obj, const std::string& attr_name) {
+    if (!obj.attrExists(attr_name)) return "";
+    auto attr = obj.openAttribute(attr_name);
+    if (attr.getDataType().getClass() != H5T_STRING) return "";
+    std::string value;
+    attr.read(attr.getDataType(), value);
+    return value;
+  }
+
+} // namespace
+
+std::unique_ptr<RMGLH5Reader> RMGLH5Reader::Open(
+    const std::string& file_name,
+    const std::string& ntuple_dir_name,
+    const std::string& ntuple_name,
+    std::map<std::string, std::string>& units
+) {
+  std::unique_ptr<RMGLH5Reader> reader(new RMGLH5Reader());
+  reader->fTableName = ntuple_dir_name + "/" + ntuple_name;
+
+  try {
+    reader->fFile = H5::H5File(file_name, H5F_ACC_RDONLY);
+    if (!reader->fFile.nameExists(reader->fTableName) ||
+        reader->fFile.childObjType(reader->fTableName) != H5O_TYPE_GROUP) {
+      RMGLog::OutFormat(RMGLog::error, "table {} not found in {}", reader->fTableName, file_name);
+      return nullptr;
+    }
+    reader->fTable = reader->fFile.openGroup(reader->fTableName);
+
+    static const std::regex table_dtype_re("^table\\{.*\\}$");
+    if (!std::regex_match(GetStringAttribute(reader->fTable, "datatype"), table_dtype_re)) {
+      RMGLog::OutFormat(
+          RMGLog::error,
+          "{} in {} is not an LH5 table",
+          reader->fTableName,
+          file_name
+      );
+      return nullptr;
+    }
+
+    // all columns have to be flat arrays of the same length.
+    bool first_column = true;
+    for (hsize_t i = 0; i < reader->fTable.getNumObjs(); i++) {
+      const auto name = reader->fTable.getObjnameByIdx(i);
+      if (reader->fTable.childObjType(name) != H5O_TYPE_DATASET) {
+        RMGLog::OutFormat(RMGLog::debug, "skipping non-flat column {} of table", name);
+        continue;
+      }
+      auto dset = reader->fTable.openDataSet(name);
+      auto space = dset.getSpace();
+      if (!space.isSimple() || space.getSimpleExtentNdims() != 1) {
+        RMGLog::OutFormat(RMGLog::debug, "skipping non-flat column {} of table", name);
+        continue;
+      }
+      hsize_t dims[1];
+      space.getSimpleExtentDims(dims);
+      if (first_column) {
+        reader->fNRows = dims[0];
+        first_column = false;
+      } else if (reader->fNRows != dims[0]) {
+        RMGLog::OutFormat(
+            RMGLog::error,
+            "mismatch of entry count for column {} of table {} ({} vs {})",
+            name,
+            reader->fTableName,
+            reader->fNRows,
+            dims[0]
+        );
+        return nullptr;
+      }
+      units[name] = GetStringAttribute(dset, "units");
+    }
+  } catch (const H5::Exception& e) {
+    RMGLog::OutFormat(RMGLog::error, "could not open LH5 file {}: {}", file_name, e.getDetailMsg());
+    return nullptr;
+  }
+
+  RMGLog::OutFormat(
+      RMGLog::debug,
+      "opened LH5 table {} with {} rows",
+      reader->fTableName,
+      reader->fNRows
+  );
+  return reader;
+}
+
+bool RMGLH5Reader::BindColumn(const std::string& name, void* target, const H5::PredType& mem_type) {
+  try {
+    if (!fTable.nameExists(name) || fTable.childObjType(name) != H5O_TYPE_DATASET) return false;
+    const size_t size = mem_type.getSize();
+    fColumns.push_back({fTable.openDataSet(name), &mem_type, target, size, {}});
+  } catch (const H5::Exception& e) {
+    RMGLog::OutFormat(RMGLog::error, "could not bind column {}: {}", name, e.getDetailMsg());
+    return false;
+  }
+  fBufferRows = 0; // invalidate the buffers.
+  return true;
+}
+
+bool RMGLH5Reader::SetColumn(const std::string& name, double& value) {
+  return BindColumn(name, &value, H5::PredType::NATIVE_DOUBLE);
+}
+
+bool RMGLH5Reader::SetColumn(const std::string& name, float& value) {
+  return BindColumn(name, &value, H5::PredType::NATIVE_FLOAT);
+}
+
+bool RMGLH5Reader::SetColumn(const std::string& name, int& value) {
+  return BindColumn(name, &value, H5::PredType::NATIVE_INT);
+}
+
+bool RMGLH5Reader::ReadBuffer(size_t start) {
+  hsize_t offset[1] = {start};
+  hsize_t count[1] = {std::min(kBufferCapacity, fNRows - start)};
+  try {
+    H5::DataSpace mem_space(1, count);
+    for (auto& col : fColumns) {
+      col.buffer.resize(count[0] * col.size);
+      auto file_space = col.dset.getSpace();
+      file_space.selectHyperslab(H5S_SELECT_SET, count, offset);
+      col.dset.read(col.buffer.data(), *col.mem_type, mem_space, file_space);
+    }
+  } catch (const H5::Exception& e) {
+    RMGLog::OutFormat(
+        RMGLog::error,
+        "could not read rows of table {}: {}",
+        fTableName,
+        e.getDetailMsg()
+    );
+    fBufferRows = 0;
+    return false;
+  }
+  fBufferStart = start;
+  fBufferRows = count[0];
+  return true;
+}
+
+std::optional<size_t> RMGLH5Reader::FindEventStart(const std::string& count_column, size_t event) {
+  if (event == 0) return 0;
+
+  auto it = fEventStarts.find(count_column);
+  if (it == fEventStarts.end()) {
+    if (!BuildEventIndex(count_column)) return std::nullopt;
+    it = fEventStarts.find(count_column);
+  }
+
+  const auto& starts = it->second;
+  if (event < starts.size()) return starts[event];
+  if (event == starts.size()) return fNRows;
+  return std::nullopt;
+}
+
+bool RMGLH5Reader::BuildEventIndex(const std::string& count_column) {
+  std::vector<size_t> starts;
+  try {
+    if (!fTable.nameExists(count_column)) return false;
+    auto dset = fTable.openDataSet(count_column);
+    auto file_space = dset.getSpace();
+
+    std::vector<int> counts(kBufferCapacity);
+    for (size_t start = 0; start < fNRows; start += kBufferCapacity) {
+      hsize_t offset[1] = {start};
+      hsize_t count[1] = {std::min(kBufferCapacity, fNRows - start)};
+      H5::DataSpace mem_space(1, count);
+      file_space.selectHyperslab(H5S_SELECT_SET, count, offset);
+      dset.read(counts.data(), H5::PredType::NATIVE_INT, mem_space, file_space);
+
+      for (size_t i = 0; i < count[0]; i++) {
+        if (counts[i] > 0) starts.push_back(start + i);
+      }
+    }
+  } catch (const H5::Exception& e) {
+    RMGLog::OutFormat(
+        RMGLog::error,
+        "could not read column {} of table {}: {}",
+        count_column,
+        fTableName,
+        e.getDetailMsg()
+    );
+    return false;
+  }
+
+  RMGLog::OutFormat(
+      RMGLog::debug,
+      "indexed {} events in column {} of table {}",
+      starts.size(),
+      count_column,
+      fTableName
+  );
+  fEventStarts[count_column] = std::move(starts);
+  return true;
+}
+
+bool RMGLH5Reader::GetNextRow() {
+  if (fRow >= fNRows) return false;
+
+  if (fRow < fBufferStart || fRow >= fBufferStart + fBufferRows) {
+    if (!ReadBuffer(fRow)) return false;
+  }
+
+  const size_t idx = fRow - fBufferStart;
+  for (auto& col : fColumns) std::memcpy(col.target, col.buffer.data() + idx * col.size, col.size);
+  fRow++;
+  return true;
+}
+
+// vim: tabstop=2 shiftwidth=2 expandtab
@@ -32,6 +32,8 @@
 #include "G4Version.hh"
 
 #include "RMGConfig.hh"
+#include "RMGIpc.hh"
+#include "RMGLogSink.hh"
 #include "RMGVersion.hh"
 
 #if RMG_HAS_ROOT
@@ -42,6 +44,7 @@
 #include <algorithm>
 #include <cstdarg>
 #include <cstdio>
+#include <cstdlib>
 #include <iomanip>
 #include <memory>
 #include <regex>
@@ -119,45 +122,66 @@ std::string RMGLog::GetPrefix(RMGLog::LogLevel loglevel, std::ostream& os) {
   }
 }
 
+void RMGLog::Abort() {
+
+  // the python wrapper needs the messages to clean up, e.g. to remove temporary files.
+  RMGLogSink::Flush();
+  RMGIpc::Flush();
+  std::abort();
+}
+
+// ---------------------------------------------------------
+
 // https://github.com/agauniyal/rang/blob/master/include/rang.hpp
+namespace {
+
+  bool TerminalSupportsColors(FILE* the_stream) {
+
+    // check that we are on a tty
+    if (!::isatty(::fileno(the_stream))) return false;
+
+    // check the value of the TERM variable
+    const std::vector<std::string> terms =
+        {"ansi",
+         "color",
+         "console",
+         "cygwin",
+         "gnome",
+         "konsole",
+         "kterm",
+         "linux",
+         "msys",
+         "putty",
+         "rxvt",
+         "screen",
+         "vt100",
+         "xterm"};
+
+    auto env_p = std::getenv("TERM");
+    if (env_p == nullptr) return false;
+    std::string env_s{env_p};
+
+    return std::any_of(std::begin(terms), std::end(terms), [&](const auto term) {
+      return env_s.find(term) != std::string::npos;
+    });
+  }
+
+} // namespace
+
 bool RMGLog::SupportsColors(const std::ostream& os) {
 
-  // determine whether the stream refers to a file or a screen
+  // determine whether the stream refers to a file or a screen. The buffered log sink writes to
+  // the standard streams directly. The terminal does not change, so only check it once.
   auto osbuf = os.rdbuf();
-  FILE* the_stream = nullptr;
-  if (osbuf == coutbuf) {
-    the_stream = stdout;
-  } else if (osbuf == cerrbuf) {
-    the_stream = stderr;
-  } else return false;
-
-  // check that we are on a tty
-  if (!::isatty(::fileno(the_stream))) return false;
-
-  // check the value of the TERM variable
-  const std::vector<std::string> terms =
-      {"ansi",
-       "color",
-       "console",
-       "cygwin",
-       "gnome",
-       "konsole",
-       "kterm",
-       "linux",
-       "msys",
-       "putty",
-       "rxvt",
-       "screen",
-       "vt100",
-       "xterm"};
-
-  auto env_p = std::getenv("TERM");
-  if (env_p == nullptr) return false;
-  std::string env_s{env_p};
-
-  return std::any_of(std::begin(terms), std::end(terms), [&](const auto term) {
-    return env_s.find(term) != std::string::npos;
-  });
+  if (osbuf == coutbuf || osbuf == std::cout.rdbuf()) {
+    static const bool colors = TerminalSupportsColors(stdout);
+    return colors;
+  }
+  if (osbuf == cerrbuf || osbuf == std::cerr.rdbuf()) {
+    static const bool colors = TerminalSupportsColors(stderr);
+    return colors;
+  }
+  return false;
 }
 
 // vim: tabstop=2 shiftwidth=2 expandtab
@@ -0,0 +1,170 @@
+// Copyright (C) 2026
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "RMGLogSink.hh"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+#include <pthread.h>
+
+#include "G4Threading.hh"
+
+#include "RMGLog.hh"
+
+bool RMGLogSink::Start(const std::string& file_name) {
+
+  Stop();
+  if (!file_name.empty()) {
+    std::lock_guard lock(fDrainMutex);
+    fFile.open(file_name, std::ios::app);
+    if (!fFile) {
+      RMGLog::Out(RMGLog::error, "could not open log file ", file_name);
+      return false;
+    }
+  }
+
+  static std::once_flag registered;
+  std::call_once(registered, [] {
+    // do not lose buffered messages at a regular exit.
+    std::atexit(&RMGLogSink::Stop);
+    pthread_atfork(&RMGLogSink::PrepareFork, &RMGLogSink::AfterFork, &RMGLogSink::AfterFork);
+  });
+
+  StartThread();
+  return true;
+}
+
+void RMGLogSink::Stop() {
+  StopThread();
+  // also write messages that are still buffered without a running thread, e.g. at exit after the
+  // thread has been stopped for a fork.
+  Flush();
+  // late messages might still be flushed by their threads.
+  std::lock_guard lock(fDrainMutex);
+  if (fFile.is_open()) fFile.close();
+}
+
+void RMGLogSink::StartThread() {
+  fStopRequested = false;
+  fThread = std::thread(&RMGLogSink::Run);
+  fRunning.store(true, std::memory_order_release);
+}
+
+void RMGLogSink::StopThread() {
+  if (!fThread.joinable()) return;
+
+  // new messages are printed directly from now on.
+  fRunning.store(false);
+  {
+    std::lock_guard lock(fWakeupMutex);
+    fStopRequested = true;
+  }
+  fWakeup.notify_one();
+  fThread.join();
+  // also write messages pushed while the thread was stopping.
+  Flush();
+}
+
+void RMGLogSink::PrepareFork() {
+  fRestartAfterFork = IsRunning();
+  StopThread();
+}
+
+void RMGLogSink::AfterFork() {
+  if (fRestartAfterFork) StartThread();
+}
+
+void RMGLogSink::Run() {
+  std::unique_lock lock(fWakeupMutex);
+  while (!fStopRequested) {
+    fWakeup.wait_for(lock, kDrainInterval, [] { return fStopRequested; });
+    lock.unlock();
+    Flush();
+    lock.lock();
+  }
+}
+
+void RMGLogSink::Flush() {
+
+  std::lock_guard drain_lock(fDrainMutex);
+  std::vector<Message> messages;
+  {
+    std::lock_guard lock(fRingsMutex);
+    for (auto& ring : fRings) {
+      // see Push for the memory order.
+      const size_t head = ring->head.load();
+      size_t tail = ring->tail.load(std::memory_order_relaxed);
+      for (; tail != head; tail++) messages.push_back(std::move(ring->messages[tail % kRingSize]));
+      ring->tail.store(tail, std::memory_order_release);
+    }
+  }
+  if (messages.empty()) return;
+
+  // restore the order in which the messages of different threads have been logged.
+  std::sort(messages.begin(), messages.end(), [](const auto& a, const auto& b) {
+    return a.sequence < b.sequence;
+  });
+  for (const auto& msg : messages) GetStream(msg.to_cerr) << msg.text;
+
+  if (fFile.is_open()) fFile.flush();
+  else {
+    std::cout.flush();
+    std::cerr.flush();
+  }
+}
+
+void RMGLogSink::Push(std::string message, bool to_cerr) {
+
+  auto& ring = GetThreadRing();
+  const size_t head = ring.head.load(std::memory_order_relaxed);
+  // do not wait for the background thread if the buffer is full.
+  if (head - ring.tail.load(std::memory_order_acquire) >= kRingSize) Flush();
+
+  auto& slot = ring.messages[head % kRingSize];
+  slot.sequence = fSequence.fetch_add(1, std::memory_order_relaxed);
+  slot.to_cerr = to_cerr;
+  slot.text = std::move(message);
+  // the sink might have been stopped while pushing, after its final flush. Then write the message
+  // directly. The sequentially consistent order of publishing the message and checking the state
+  // guarantees that either the final flush or this thread sees the message.
+  ring.head.store(head + 1);
+  if (!fRunning.load()) Flush();
+}
+
+RMGLogSink::Ring& RMGLogSink::GetThreadRing() {
+  // the rings are owned by the sink, and outlive their threads.
+  thread_local Ring* ring = nullptr;
+  if (!ring) {
+    std::lock_guard lock(fRingsMutex);
+    ring = fRings.emplace_back(std::make_unique<Ring>()).get();
+  }
+  return *ring;
+}
+
+std::ostream& RMGLogSink::GetStream(bool to_cerr) {
+  if (fFile.is_open()) return fFile;
+  return to_cerr ? std::cerr : std::cout;
+}
+
+std::string RMGLogSink::GetThreadPrefix() {
+  // the same as the default prefix of G4MTcoutDestination.
+  const int thread_id = G4Threading::G4GetThreadId();
+  if (thread_id < 0) return "";
+  return "G4WT" + std::to_string(thread_id) + " > ";
+}
+
+// vim: tabstop=2 shiftwidth=2 expandtab
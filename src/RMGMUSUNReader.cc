@@ -0,0 +1,204 @@
+// Copyright (C) 2026
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "RMGMUSUNReader.hh"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "RMGGeneratorMUSUNCosmicMuons.hh"
+#include "RMGLog.hh"
+
+namespace {
+
+  bool IsBlank(const char* begin, const char* end) {
+    return std::all_of(begin, end, [](char c) {
+      return std::isspace(static_cast<unsigned char>(c));
+    });
+  }
+
+  // append the offsets of all non-empty lines starting in [begin, end).
+  void IndexRange(
+      const char* data,
+      size_t size,
+      size_t begin,
+      size_t end,
+      std::vector<size_t>& out
+  ) {
+    size_t pos = 0;
+    if (begin > 0) {
+      auto nl = static_cast<const char*>(std::memchr(data + begin - 1, '\n', size - begin + 1));
+      if (!nl) return;
+      pos = nl - data + 1;
+    }
+    while (pos < end) {
+      auto nl = static_cast<const char*>(std::memchr(data + pos, '\n', size - pos));
+      const size_t line_end = nl ? nl - data : size;
+      if (!IsBlank(data + pos, data + line_end)) out.push_back(pos);
+      pos = line_end + 1;
+    }
+  }
+
+} // namespace
+
+std::unique_ptr<RMGMUSUNReader> RMGMUSUNReader::Open(const std::string& file_name) {
+  std::unique_ptr<RMGMUSUNReader> reader(new RMGMUSUNReader());
+  reader->fFileName = file_name;
+
+  const int fd = ::open(file_name.c_str(), O_RDONLY);
+  if (fd < 0) {
+    RMGLog::Out(RMGLog::error, "MUSUN file ", file_name, " not found");
+    return nullptr;
+  }
+  struct stat st{};
+  if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+    RMGLog::Out(RMGLog::error, "MUSUN file ", file_name, " is empty");
+    ::close(fd);
+    return nullptr;
+  }
+  reader->fSize = st.st_size;
+  void* data = ::mmap(nullptr, reader->fSize, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd); // the mapping stays valid.
+  if (data == MAP_FAILED) {
+    RMGLog::Out(RMGLog::error, "could not map MUSUN file ", file_name, ": ", std::strerror(errno));
+    reader->fSize = 0;
+    return nullptr;
+  }
+  reader->fData = static_cast<const char*>(data);
+  // the file is read mostly sequentially, by many threads.
+  ::madvise(data, reader->fSize, MADV_SEQUENTIAL);
+
+  reader->IndexLines();
+  if (reader->fLineOffsets.empty()) {
+    RMGLog::Out(RMGLog::error, "MUSUN file ", file_name, " is empty");
+    return nullptr;
+  }
+
+  // the number of columns determines the format.
+  double fields[10];
+  reader->fNColumns = reader->ParseLine(0, fields, std::size(fields));
+  if (reader->fNColumns != 8 && reader->fNColumns != 9) {
+    RMGLog::Out(
+        RMGLog::error,
+        "MUSUN format not identified! It has ",
+        reader->fNColumns,
+        " columns."
+    );
+    return nullptr;
+  }
+
+  RMGLog::OutFormat(
+      RMGLog::debug,
+      "indexed {} rows of MUSUN file {}",
+      reader->fLineOffsets.size(),
+      file_name
+  );
+  return reader;
+}
+
+RMGMUSUNReader::~RMGMUSUNReader() {
+  if (fData) ::munmap(const_cast<char*>(fData), fSize);
+}
+
+void RMGMUSUNReader::IndexLines() {
+  const size_t n_threads = std::clamp<size_t>(
+      fSize / kParallelIndexChunk,
+      1,
+      std::max(std::thread::hardware_concurrency(), 1u)
+  );
+
+  if (n_threads == 1) {
+    IndexRange(fData, fSize, 0, fSize, fLineOffsets);
+    return;
+  }
+
+  // each thread indexes the lines starting in its chunk, the results are concatenated in order.
+  std::vector<std::vector<size_t>> partial(n_threads);
+  std::vector<std::thread> threads;
+  const size_t chunk = fSize / n_threads + 1;
+  for (size_t i = 0; i < n_threads; i++) {
+    const size_t begin = std::min(i * chunk, fSize);
+    const size_t end = std::min(begin + chunk, fSize);
+    threads.emplace_back(IndexRange, fData, fSize, begin, end, std::ref(partial[i]));
+  }
+  for (auto& t : threads) t.join();
+
+  size_t n_lines = 0;
+  for (const auto& p : partial) n_lines += p.size();
+  fLineOffsets.reserve(n_lines);
+  for (const auto& p : partial) fLineOffsets.insert(fLineOffsets.end(), p.begin(), p.end());
+}
+
+size_t RMGMUSUNReader::ParseLine(size_t row, double* fields, size_t max_fields) const {
+  const size_t begin = fLineOffsets[row];
+  auto nl = static_cast<const char*>(std::memchr(fData + begin, '\n', fSize - begin));
+  const size_t length = (nl ? nl - fData : fSize) - begin;
+  if (length >= kMaxLineLength) return 0;
+
+  // the mapped file is not null-terminated, so copy the line before parsing.
+  char line[kMaxLineLength];
+  std::memcpy(line, fData + begin, length);
+  line[length] = '\0';
+
+  size_t n = 0;
+  char* pos = line;
+  while (n < max_fields) {
+    char* next = nullptr;
+    const double value = std::strtod(pos, &next);
+    if (next == pos) break;
+    fields[n++] = value;
+    pos = next;
+  }
+  return n;
+}
+
+bool RMGMUSUNReader::ReadRow(size_t row, RMGGeneratorMUSUNCosmicMuons_Data& data) const {
+  if (row >= fLineOffsets.size()) return false;
+
+  double fields[9];
+  if (ParseLine(row, fields, fNColumns) != fNColumns) {
+    RMGLog::OutFormat(RMGLog::error, "could not parse row {} of MUSUN file {}", row, fFileName);
+    return false;
+  }
+
+  data.fID = static_cast<int>(fields[0]);
+  data.fType = static_cast<int>(fields[1]);
+  data.fEkin = fields[2];
+  data.fX = fields[3];
+  data.fY = fields[4];
+  data.fZ = fields[5];
+  if (HasCartesianMomentum()) {
+    data.fPx = fields[6];
+    data.fPy = fields[7];
+    data.fPz = fields[8];
+  } else {
+    data.fTheta = fields[6];
+    data.fPhi = fields[7];
+  }
+  return true;
+}
+
+// vim: tabstop=2 shiftwidth=2 expandtab
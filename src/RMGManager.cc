@@ -24,13 +24,20 @@
 #include <string>
 #include <vector>
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 #ifdef G4MULTITHREADED
 #include "G4MTRunManager.hh"
 #endif
+#include "CLHEP/Units/SystemOfUnits.h"
 #include "G4AnalysisManager.hh"
 #include "G4Backtrace.hh"
 #include "G4GenericMessenger.hh"
 #include "G4StateManager.hh"
+#include "G4TaskRunManager.hh"
 #include "G4Threading.hh"
 #include "G4UIExecutive.hh"
 #include "G4UImanager.hh"
@@ -43,8 +50,10 @@
 #include "RMGExceptionHandler.hh"
 #include "RMGHardware.hh"
 #include "RMGIpc.hh"
+#include "RMGLogSink.hh"
 #include "RMGPhysics.hh"
 #include "RMGPrimaryTransformer.hh"
+#include "RMGTelemetry.hh"
 #include "RMGTools.hh"
 #include "RMGUserAction.hh"
 #include "RMGUserInit.hh"
@@ -190,6 +199,8 @@ void RMGManager::Run() {
 
   // if interactive mode is requested, do not quit and start a session
   if (fInteractive) {
+    // the UI session might not show messages written directly to the console.
+    RMGLogSink::Stop();
     if (!session) session = StartInteractiveSession();
     session->SetPrompt(RMGLog::Colorize<RMGLog::Ansi::unspecified>("remage> ", G4cout, true));
     session->SessionStart();
@@ -228,6 +239,61 @@ void RMGManager::SetUpDefaultG4RunManager(G4RunManagerType type) {
   }
 }
 
+void RMGManager::ConfigureTasking(int n_events) {
+
+  auto task_manager = dynamic_cast<G4TaskRunManager*>(fG4RunManager.get());
+  if (!task_manager) {
+    if ((fEventsPerTask > 0 || fNumberOfTasks > 0) && !IsExecSequential()) {
+      RMGLog::Out(
+          RMGLog::warning,
+          "Task settings have no effect, the run manager is not task-based ",
+          "(check the environment variable G4RUN_MANAGER_TYPE)"
+      );
+    }
+    return;
+  }
+
+  // Geant4 splits the events of a run into (approximately) as many tasks as the grain size.
+  int n_tasks = fNumberOfTasks;
+  if (fEventsPerTask > 0) n_tasks = std::max(n_events / fEventsPerTask, 1);
+  task_manager->SetGrainsize(n_tasks);
+  if (n_tasks > 0) {
+    RMGLog::OutFormat(RMGLog::detail, "Splitting {} events into {} tasks", n_events, n_tasks);
+  }
+}
+
+void RMGManager::SetTelemetryInterval(double interval) {
+  RMGTelemetry::SetInterval(std::max(interval, 0.) / CLHEP::s);
+}
+
+void RMGManager::PinWorkerThread() const {
+
+  if (!fPinWorkerThreads) return;
+#ifdef __linux__
+  // new threads inherit the affinity of the master thread, i.e. the set of allowed cores.
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return;
+  std::vector<int> cpus;
+  for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+    if (CPU_ISSET(cpu, &allowed)) cpus.push_back(cpu);
+  }
+  if (cpus.empty()) return;
+
+  const int cpu = cpus[G4Threading::G4GetThreadId() % cpus.size()];
+  cpu_set_t pinned;
+  CPU_ZERO(&pinned);
+  CPU_SET(cpu, &pinned);
+  if (pthread_setaffinity_np(pthread_self(), sizeof(pinned), &pinned) != 0) {
+    RMGLog::Out(RMGLog::warning, "Could not pin worker thread to CPU ", cpu);
+    return;
+  }
+  RMGLog::OutFormat(RMGLog::debug, "Pinned worker thread to CPU {}", cpu);
+#else
+  RMGLog::Out(RMGLog::warning, "Pinning worker threads is only supported on Linux");
+#endif
+}
+
 void RMGManager::SetUpDefaultUserAction() {
   RMGLog::Out(RMGLog::debug, "Initializing default user action class");
   fUserAction = new RMGUserAction();
@@ -277,6 +343,16 @@ void RMGManager::SetLogLevel(std::string level) {
   } catch (const std::bad_cast&) { return; }
 }
 
+void RMGManager::SetBufferedLogOutput(bool flag) {
+  if (flag) RMGLogSink::Start(fLogFile);
+  else RMGLogSink::Stop();
+}
+
+void RMGManager::SetLogFile(std::string filename) {
+  fLogFile = filename;
+  SetBufferedLogOutput(true);
+}
+
 void RMGManager::SetRandEngine(std::string name) {
   fIsRandControlledAtEngineChange = fIsRandControlled;
 
@@ -381,6 +457,12 @@ void RMGManager::DefineCommands() {
       .SetRange("n > 0")
       .SetStates(G4State_PreInit, G4State_Idle);
 
+  fMessenger->DeclareMethodWithUnit("TelemetryInterval", "s", &RMGManager::SetTelemetryInterval)
+      .SetGuidance("Minimum time between two throughput reports of each thread to the wrapper")
+      .SetGuidance("Uses 5 s by default, 0 disables the reports")
+      .SetParameterName("interval", false)
+      .SetStates(G4State_PreInit, G4State_Idle);
+
   fLogMessenger = std::make_unique<G4GenericMessenger>(
       this,
       "/RMG/Manager/Logging/",
@@ -393,6 +475,29 @@ void RMGManager::DefineCommands() {
       .SetCandidates(RMGTools::GetCandidates<RMGLog::LogLevel>())
       .SetStates(G4State_PreInit, G4State_Idle);
 
+  fLogMessenger->DeclareMethod("BufferedOutput", &RMGManager::SetBufferedLogOutput)
+      .SetGuidance(
+          "Buffer the log messages of each thread, and write them to the console (or the log "
+          "file) from a background thread"
+      )
+      .SetGuidance(
+          "note: the output of Geant4 itself is not buffered, so it might appear out of order "
+          "with the log messages. This is not available in interactive sessions."
+      )
+      .SetGuidance("This is disabled by default")
+      .SetParameterName("boolean", true)
+      .SetDefaultValue("true")
+      .SetStates(G4State_PreInit, G4State_Idle);
+
+  fLogMessenger->DeclareMethod("LogFile", &RMGManager::SetLogFile)
+      .SetGuidance("Append the log messages to this file instead of writing them to the console")
+      .SetGuidance(
+          "note: this enables the buffered output. The output of Geant4 itself is not written to "
+          "the file."
+      )
+      .SetParameterName("filename", false)
+      .SetStates(G4State_PreInit, G4State_Idle);
+
   fRandMessenger = std::make_unique<G4GenericMessenger>(
       this,
       "/RMG/Manager/Randomization/",
@@ -420,6 +525,38 @@ void RMGManager::DefineCommands() {
   fRandMessenger->DeclareMethod("UseSystemEntropy", &RMGManager::SetRandSystemEntropySeed)
       .SetGuidance("Select a random initial seed from system entropy")
       .SetStates(G4State_PreInit, G4State_Idle);
+
+  fTaskMessenger = std::make_unique<G4GenericMessenger>(
+      this,
+      "/RMG/Manager/Tasking/",
+      "Commands for controlling the task-based run manager"
+  );
+
+  fTaskMessenger->DeclareMethod("EventsPerTask", &RMGManager::SetEventsPerTask)
+      .SetGuidance("Set the number of events processed in one task")
+      .SetGuidance(
+          "note: smaller tasks balance the load better between threads if the time needed per "
+          "event varies a lot, but add more overhead. This overrides NumberOfTasks."
+      )
+      .SetGuidance("Uses the Geant4 default (0) by default")
+      .SetParameterName("n", false)
+      .SetRange("n >= 0")
+      .SetStates(G4State_PreInit, G4State_Idle);
+
+  fTaskMessenger->DeclareMethod("NumberOfTasks", &RMGManager::SetNumberOfTasks)
+      .SetGuidance("Set the number of tasks the events of each run are split into")
+      .SetGuidance("Uses the Geant4 default (0, i.e. one task per thread) by default")
+      .SetParameterName("n", false)
+      .SetRange("n >= 0")
+      .SetStates(G4State_PreInit, G4State_Idle);
+
+  fTaskMessenger->DeclareMethod("PinWorkerThreads", &RMGManager::SetPinWorkerThreads)
+      .SetGuidance("Pin each worker thread to one of the CPU cores available to remage")
+      .SetGuidance("note: this is only supported on Linux.")
+      .SetGuidance("This is disabled by default")
+      .SetParameterName("boolean", true)
+      .SetDefaultValue("true")
+      .SetStates(G4State_PreInit);
 }
 
 // vim: tabstop=2 shiftwidth=2 expandtab
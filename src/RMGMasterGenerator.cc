@@ -15,7 +15,13 @@
 
 #include "RMGMasterGenerator.hh"
 
+#include <cstdio>
+#include <string>
+
+#include "G4Event.hh"
 #include "G4GenericMessenger.hh"
+#include "G4Run.hh"
+#include "G4RunManager.hh"
 #include "G4ThreeVector.hh"
 
 #include "RMGConfig.hh"
@@ -28,8 +34,10 @@
 #include "RMGGeneratorGPS.hh"
 #include "RMGGeneratorMUSUNCosmicMuons.hh"
 #include "RMGGeomBench.hh"
+#include "RMGIpc.hh"
 #include "RMGLog.hh"
 #include "RMGManager.hh"
+#include "RMGRun.hh"
 #include "RMGTools.hh"
 #include "RMGVGenerator.hh"
 #include "RMGVVertexGenerator.hh"
@@ -46,6 +54,9 @@ void RMGMasterGenerator::GeneratePrimaries(G4Event* event) {
 
   if (!fGeneratorObj) RMGLog::Out(RMGLog::fatal, "No primary generator specified!");
 
+  // the events are claimed in batches from the budget shared by all processes.
+  if (RMGManager::Instance()->IsDynamicEventDistribution() && !ClaimEventFromBatch(event)) return;
+
   // invoke vertex position generator, if specified
   if (fGenerator != Generator::kBxDecay0 and fConfinement != Confinement::kUnConfined) {
     // HACK: The BxDecay0 generator takes the responsibility for shooting the primary vertex
@@ -75,6 +86,55 @@ void RMGMasterGenerator::GeneratePrimaries(G4Event* event) {
   fGeneratorObj->GeneratePrimaries(event);
 }
 
+bool RMGMasterGenerator::ClaimEventFromBatch(G4Event* event) {
+
+  auto run_manager = G4RunManager::GetRunManager();
+  const int run_id = run_manager->GetCurrentRun()->GetRunID();
+  if (run_id == fEventBatchRunID && fEventBatchNext < fEventBatchEnd) {
+    fEventBatchOffset = fEventBatchNext++ - event->GetEventID();
+    return true;
+  }
+
+  // the python wrapper hands out the next batch of events of this run. Each process is not
+  // multithreaded, so the batches are claimed in order and input files only need to seek forward.
+  const auto request = std::to_string(run_id) + "\x1e" +
+                       std::to_string(run_manager->GetNumberOfEventsToBeProcessed());
+  std::string response;
+  if (!RMGIpc::SendIpcBlocking(RMGIpc::CreateMessage("event_batch", request), &response)) {
+    RMGLog::Out(RMGLog::fatal, "could not request a batch of events from the python wrapper");
+  }
+  long first_event = 0, n_events = 0;
+  if (std::sscanf(response.c_str(), "%ld\x1f%ld", &first_event, &n_events) != 2) {
+    RMGLog::Out(RMGLog::fatal, "invalid event batch response '", response, "'");
+  }
+
+  if (n_events <= 0) {
+    // the budget is used up, do not simulate or store this event.
+    RMGLog::Out(RMGLog::detail, "no more events to simulate, ending the run");
+    // G4Run would still count the aborted event.
+    auto run = dynamic_cast<RMGRun*>(run_manager->GetNonConstCurrentRun());
+    if (run) run->SetEventNotSimulated(event->GetEventID());
+    event->SetEventAborted();
+    run_manager->AbortRun(true);
+    return false;
+  }
+
+  RMGLog::OutFormat(
+      RMGLog::debug,
+      "claimed batch of events {} to {}",
+      first_event,
+      first_event + n_events - 1
+  );
+  fEventBatchRunID = run_id;
+  fEventBatchNext = first_event + 1;
+  fEventBatchEnd = first_event + n_events;
+  fEventBatchOffset = first_event - event->GetEventID();
+
+  if (fVertexGeneratorObj) fVertexGeneratorObj->BeginOfEventBatch(first_event, n_events);
+  fGeneratorObj->BeginOfEventBatch(first_event, n_events);
+  return true;
+}
+
 void RMGMasterGenerator::SetConfinement(RMGMasterGenerator::Confinement code) {
 
   fConfinement = code;
@@ -0,0 +1,522 @@
+// Copyright (C) 2026
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "RMGMergeLH5.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fmt/ranges.h>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <unordered_set>
+#include <vector>
+
+#include "RMGConvertLH5.hh"
+#include "RMGLog.hh"
+
+namespace fs = std::filesystem;
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+int RMGMergeLH5::iter_children(hid_t, const char* name, const H5L_info_t*, void* op_data) {
+  auto children = static_cast<std::vector<std::string>*>(op_data);
+  children->push_back(name);
+  return 0;
+}
+
+std::vector<std::string> RMGMergeLH5::GetChildren(H5::Group& group) {
+  std::vector<std::string> children;
+  H5Literate(group.getId(), H5_INDEX_NAME, H5_ITER_NATIVE, nullptr, iter_children, &children);
+  return children;
+}
+
+bool RMGMergeLH5::ExistsByType(H5::H5Location& loc, std::string name, H5O_type_t type) {
+  return loc.nameExists(name) && loc.childObjType(name) == type;
+}
+
+std::optional<std::string> RMGMergeLH5::GetStringAttribute(
+    H5::H5Object& obj,
+    std::string attr_name
+) {
+  if (!obj.attrExists(attr_name)) return std::nullopt;
+  auto att = obj.openAttribute(attr_name);
+  if (att.getDataType().getClass() != H5T_STRING) return std::nullopt;
+  std::string value;
+  att.read(att.getDataType(), value);
+  return value;
+}
+
+void RMGMergeLH5::SetStringAttribute(
+    H5::H5Object& obj,
+    std::string attr_name,
+    std::string attr_value
+) {
+  if (obj.attrExists(attr_name)) obj.removeAttr(attr_name);
+  H5::StrType att_dtype(0, H5T_VARIABLE);
+  H5::DataSpace scalar(H5S_SCALAR);
+  auto att = obj.createAttribute(attr_name, att_dtype, scalar);
+  att.write(att_dtype, attr_value);
+}
+
+void RMGMergeLH5::CopyAttributes(H5::H5Object& src, H5::H5Object& dst) {
+  for (int i = 0; i < src.getNumAttrs(); i++) {
+    auto att = src.openAttribute(static_cast<unsigned int>(i));
+    auto att_name = att.getName();
+    if (dst.attrExists(att_name)) continue;
+
+    auto att_dtype = att.getDataType();
+    auto att_new = dst.createAttribute(att_name, att_dtype, att.getSpace());
+    if (att_dtype.getClass() == H5T_STRING) {
+      std::string value;
+      att.read(att_dtype, value);
+      att_new.write(att_dtype, value);
+    } else {
+      std::vector<char> buf(att.getInMemDataSize());
+      att.read(att_dtype, buf.data());
+      att_new.write(att_dtype, buf.data());
+    }
+  }
+}
+
+void RMGMergeLH5::MergeDatatypeAttribute(H5::H5Object& src, H5::H5Object& dst) {
+  auto src_dtype = GetStringAttribute(src, "datatype");
+  auto dst_dtype = GetStringAttribute(dst, "datatype");
+  if (!src_dtype || !dst_dtype || src_dtype == dst_dtype) return;
+
+  std::smatch src_match, dst_match;
+  if (!std::regex_match(*src_dtype, src_match, lgdo_fields_re) ||
+      !std::regex_match(*dst_dtype, dst_match, lgdo_fields_re) || src_match[1] != dst_match[1]) {
+    LH5Log(RMGLog::warning, "incompatible LGDO datatypes ", *src_dtype, " and ", *dst_dtype);
+    return;
+  }
+
+  // build the union of both field lists.
+  std::set<std::string> fields;
+  for (const auto& m : {src_match[2].str(), dst_match[2].str()}) {
+    std::istringstream is(m);
+    std::string tmp;
+    while (std::getline(is, tmp, ',')) {
+      if (!tmp.empty()) fields.insert(tmp);
+    }
+  }
+  SetStringAttribute(
+      dst,
+      "datatype",
+      src_match[1].str() + "{" + fmt::format("{}", fmt::join(fields, ",")) + "}"
+  );
+}
+
+std::vector<std::string> RMGMergeLH5::ReadStringColumn(H5::DataSet& dset) {
+  std::vector<std::string> vec;
+
+  auto dtype = dset.getStrType();
+  auto space = dset.getSpace();
+  hsize_t n_rows = 0;
+  space.getSimpleExtentDims(&n_rows);
+  if (n_rows == 0) return vec;
+  vec.reserve(n_rows);
+
+  if (dtype.isVariableStr()) {
+    std::vector<char*> buf(n_rows);
+    dset.read(buf.data(), dtype);
+    for (auto* s : buf) vec.emplace_back(s ? s : "");
+    H5::DataSet::vlenReclaim(buf.data(), dtype, space);
+  } else {
+    auto str_size = dtype.getSize();
+    std::vector<char> buf(n_rows * str_size);
+    dset.read(buf.data(), dtype);
+    for (hsize_t i = 0; i < n_rows; i++) {
+      const char* s = buf.data() + i * str_size;
+      vec.emplace_back(s, strnlen(s, str_size));
+    }
+  }
+  return vec;
+}
+
+void RMGMergeLH5::PrefetchFile(const std::string& file_name) {
+  // only a hint to the kernel to start reading in the background; failures do not matter.
+  int fd = open(file_name.c_str(), O_RDONLY);
+  if (fd < 0) return;
+#ifdef POSIX_FADV_WILLNEED
+  posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+#endif
+  close(fd);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+bool RMGMergeLH5::AddScalar(H5::DataSet& src, H5::DataSet& dst) {
+  if (src.getSpace().getSimpleExtentType() != H5S_SCALAR ||
+      dst.getSpace().getSimpleExtentType() != H5S_SCALAR ||
+      src.getDataType().getClass() != H5T_INTEGER || dst.getDataType().getClass() != H5T_INTEGER) {
+    LH5Log(RMGLog::error, "cannot add non-integer or non-scalar datasets");
+    return false;
+  }
+
+  int64_t src_value = 0, dst_value = 0;
+  src.read(&src_value, H5::PredType::NATIVE_INT64);
+  dst.read(&dst_value, H5::PredType::NATIVE_INT64);
+  dst_value += src_value;
+  dst.write(&dst_value, H5::PredType::NATIVE_INT64);
+  return true;
+}
+
+bool RMGMergeLH5::AppendDataset(
+    H5::DataSet& src_dset,
+    H5::Group& dst_group,
+    const std::string& name,
+    const std::vector<bool>* row_mask,
+    int64_t value_offset
+) {
+  auto dtype = src_dset.getDataType();
+  auto src_space = src_dset.getSpace();
+  if (!src_space.isSimple() || src_space.getSimpleExtentNdims() != 1) {
+    LH5Log(RMGLog::error, "column ", name, " is not a one-dimensional dataset");
+    return false;
+  }
+  hsize_t n_src = 0;
+  src_space.getSimpleExtentDims(&n_src);
+  if (row_mask && row_mask->size() != n_src) {
+    LH5Log(RMGLog::error, "column ", name, " has a different length than the other columns");
+    return false;
+  }
+
+  if (!dst_group.nameExists(name)) {
+    // create an empty, extendible dataset that we can append to.
+    hsize_t dims[1] = {0};
+    hsize_t max_dims[1] = {H5S_UNLIMITED};
+    H5::DataSpace dst_space(1, dims, max_dims);
+    hsize_t max_chunk = std::min<hsize_t>(fBufferRows, 1 << 14);
+    hsize_t chunk_dims[1] = {std::clamp<hsize_t>(n_src, 1, max_chunk)};
+    H5::DSetCreatPropList plist;
+    plist.setChunk(1, chunk_dims);
+    auto dst_dset = dst_group.createDataSet(name, dtype, dst_space, plist);
+    CopyAttributes(src_dset, dst_dset);
+  }
+
+  auto dst_dset = dst_group.openDataSet(name);
+  auto dst_dtype = dst_dset.getDataType();
+  if (dst_dtype.getClass() != dtype.getClass() ||
+      (!dtype.isVariableStr() && dst_dtype.getSize() != dtype.getSize())) {
+    LH5Log(RMGLog::error, "column ", name, " has an incompatible data type in the target file");
+    return false;
+  }
+  if (dst_dset.getCreatePlist().getLayout() != H5D_CHUNKED) {
+    LH5Log(RMGLog::error, "column ", name, " in the target file is not extendible");
+    return false;
+  }
+
+  hsize_t n_dst = 0;
+  dst_dset.getSpace().getSimpleExtentDims(&n_dst);
+
+  // integer values that need an offset are converted to 64 bit on reading.
+  if (value_offset != 0 && dtype.getClass() != H5T_INTEGER) {
+    LH5Log(RMGLog::error, "column ", name, " is not an integer column");
+    return false;
+  }
+  H5::DataType mem_dtype = dtype;
+  if (value_offset != 0) mem_dtype = H5::PredType::NATIVE_INT64;
+
+  const bool is_vlen = dtype.isVariableStr();
+  const size_t el_size = mem_dtype.getSize();
+  std::vector<char> buf;
+  std::vector<char> buf_masked;
+
+  for (hsize_t offset = 0; offset < n_src; offset += fBufferRows) {
+    hsize_t count = std::min<hsize_t>(fBufferRows, n_src - offset);
+
+    // read a block of rows from the source.
+    H5::DataSpace mem_space(1, &count);
+    src_space.selectHyperslab(H5S_SELECT_SET, &count, &offset);
+    buf.resize(count * el_size);
+    src_dset.read(buf.data(), mem_dtype, mem_space, src_space);
+    if (value_offset != 0) {
+      auto values = reinterpret_cast<int64_t*>(buf.data());
+      for (hsize_t i = 0; i < count; i++) values[i] += value_offset;
+    }
+
+    // optionally drop rows that are not selected.
+    const char* write_buf = buf.data();
+    hsize_t write_count = count;
+    if (row_mask) {
+      buf_masked.resize(count * el_size);
+      write_count = 0;
+      for (hsize_t i = 0; i < count; i++) {
+        if (!(*row_mask)[offset + i]) continue;
+        std::memcpy(buf_masked.data() + write_count * el_size, buf.data() + i * el_size, el_size);
+        write_count++;
+      }
+      write_buf = buf_masked.data();
+    }
+
+    if (write_count > 0) {
+      // extend the target and write the block to its end.
+      hsize_t new_size = n_dst + write_count;
+      dst_dset.extend(&new_size);
+      auto dst_space = dst_dset.getSpace();
+      dst_space.selectHyperslab(H5S_SELECT_SET, &write_count, &n_dst);
+      H5::DataSpace write_mem_space(1, &write_count);
+      dst_dset.write(write_buf, mem_dtype, write_mem_space, dst_space);
+      n_dst = new_size;
+    }
+
+    if (is_vlen) H5::DataSet::vlenReclaim(buf.data(), dtype, mem_space);
+  }
+
+  return true;
+}
+
+bool RMGMergeLH5::AppendVectorOfVectors(
+    H5::Group& src_vov,
+    H5::Group& dst_table,
+    const std::string& name,
+    const std::string& path
+) {
+  if (!ExistsByType(src_vov, "flattened_data", H5O_TYPE_DATASET) ||
+      !ExistsByType(src_vov, "cumulative_length", H5O_TYPE_DATASET)) {
+    LH5Log(RMGLog::error, "unsupported vector of vectors column ", path);
+    return false;
+  }
+
+  if (!ExistsByType(dst_table, name, H5O_TYPE_GROUP)) {
+    auto dst_vov = dst_table.createGroup(name);
+    CopyAttributes(src_vov, dst_vov);
+  }
+  auto dst_vov = dst_table.openGroup(name);
+
+  // the cumulative lengths have to be shifted by the data already present in the target.
+  int64_t offset = 0;
+  if (ExistsByType(dst_vov, "flattened_data", H5O_TYPE_DATASET)) {
+    hsize_t n_dst = 0;
+    dst_vov.openDataSet("flattened_data").getSpace().getSimpleExtentDims(&n_dst);
+    offset = static_cast<int64_t>(n_dst);
+  }
+
+  auto src_data = src_vov.openDataSet("flattened_data");
+  auto src_cumulative_length = src_vov.openDataSet("cumulative_length");
+  return AppendDataset(src_data, dst_vov, "flattened_data", nullptr) &&
+         AppendDataset(src_cumulative_length, dst_vov, "cumulative_length", nullptr, offset);
+}
+
+bool RMGMergeLH5::AppendTable(H5::Group& src_table, H5::Group& dst_table, const std::string& path) {
+  LH5Log(RMGLog::debug, "appending table ", path);
+
+  // for deduplicated tables, only append rows with a new value in the name column.
+  std::vector<bool> row_mask;
+  bool use_mask = false;
+  if (fDedupTables.find(path) != fDedupTables.end() &&
+      ExistsByType(src_table, "name", H5O_TYPE_DATASET)) {
+    std::unordered_set<std::string> seen;
+    if (ExistsByType(dst_table, "name", H5O_TYPE_DATASET)) {
+      auto dst_names = dst_table.openDataSet("name");
+      for (auto& n : ReadStringColumn(dst_names)) seen.insert(std::move(n));
+    }
+    auto src_names = src_table.openDataSet("name");
+    for (auto& n : ReadStringColumn(src_names)) {
+      row_mask.push_back(seen.insert(std::move(n)).second);
+    }
+    use_mask = true;
+  }
+
+  // for event index tables, the row numbers have to be shifted by the rows already present in
+  // the indexed table of the target, i.e. the end of the last indexed event.
+  int64_t first_row_offset = 0;
+  const bool is_index = path.find(RMGConvertLH5::fIndexGroupName + "/") != std::string::npos;
+  if (is_index && ExistsByType(dst_table, "first_row", H5O_TYPE_DATASET) &&
+      ExistsByType(dst_table, "n_rows", H5O_TYPE_DATASET)) {
+    auto dst_first_row = dst_table.openDataSet("first_row");
+    auto dst_n_rows = dst_table.openDataSet("n_rows");
+    hsize_t n_dst = 0;
+    dst_first_row.getSpace().getSimpleExtentDims(&n_dst);
+    if (n_dst > 0) {
+      hsize_t count = 1;
+      hsize_t last = n_dst - 1;
+      H5::DataSpace mem_space(1, &count);
+      int64_t last_first_row = 0;
+      int64_t last_n_rows = 0;
+      auto file_space = dst_first_row.getSpace();
+      file_space.selectHyperslab(H5S_SELECT_SET, &count, &last);
+      dst_first_row.read(&last_first_row, H5::PredType::NATIVE_INT64, mem_space, file_space);
+      file_space = dst_n_rows.getSpace();
+      file_space.selectHyperslab(H5S_SELECT_SET, &count, &last);
+      dst_n_rows.read(&last_n_rows, H5::PredType::NATIVE_INT64, mem_space, file_space);
+      first_row_offset = last_first_row + last_n_rows;
+    }
+  }
+
+  bool success = true;
+  for (const auto& column : GetChildren(src_table)) {
+    auto col_path = path + "/" + column;
+    if (src_table.childObjType(column) == H5O_TYPE_DATASET) {
+      auto src_dset = src_table.openDataSet(column);
+      int64_t value_offset = (is_index && column == "first_row") ? first_row_offset : 0;
+      success &= AppendDataset(
+          src_dset,
+          dst_table,
+          column,
+          use_mask ? &row_mask : nullptr,
+          value_offset
+      );
+    } else if (src_table.childObjType(column) == H5O_TYPE_GROUP && !use_mask) {
+      auto src_vov = src_table.openGroup(column);
+      auto datatype = GetStringAttribute(src_vov, "datatype").value_or("");
+      if (datatype.rfind("array<1>{array<1>{", 0) == 0) {
+        success &= AppendVectorOfVectors(src_vov, dst_table, column, col_path);
+      } else {
+        LH5Log(RMGLog::error, "unsupported table column type for ", col_path);
+        success = false;
+      }
+    } else {
+      LH5Log(RMGLog::error, "unsupported table column type for ", col_path);
+      success = false;
+    }
+  }
+
+  MergeDatatypeAttribute(src_table, dst_table);
+  return success;
+}
+
+bool RMGMergeLH5::AppendGroup(H5::Group& src_group, H5::Group& dst_group, const std::string& path) {
+  bool success = true;
+
+  for (const auto& name : GetChildren(src_group)) {
+    auto child_path = path.empty() ? name : path + "/" + name;
+
+    // re-create soft links, without following them.
+    H5L_info_t link_info;
+    H5Lget_info(src_group.getId(), name.c_str(), &link_info, H5P_DEFAULT);
+    if (link_info.type == H5L_TYPE_SOFT) {
+      if (dst_group.nameExists(name)) continue;
+      std::vector<char> target(link_info.u.val_size);
+      H5Lget_val(src_group.getId(), name.c_str(), target.data(), target.size(), H5P_DEFAULT);
+      dst_group.link(H5L_TYPE_SOFT, target.data(), name);
+      LH5Log(RMGLog::debug, "created soft link ", child_path, " -> ", target.data());
+      continue;
+    }
+
+    auto obj_type = src_group.childObjType(name);
+    if (obj_type == H5O_TYPE_GROUP) {
+      auto src_child = src_group.openGroup(name);
+      if (!ExistsByType(dst_group, name, H5O_TYPE_GROUP)) {
+        auto dst_child = dst_group.createGroup(name);
+        CopyAttributes(src_child, dst_child);
+      }
+      auto dst_child = dst_group.openGroup(name);
+
+      auto datatype = GetStringAttribute(src_child, "datatype").value_or("");
+      if (datatype.rfind("table{", 0) == 0) {
+        success &= AppendTable(src_child, dst_child, child_path);
+      } else {
+        success &= AppendGroup(src_child, dst_child, child_path);
+        MergeDatatypeAttribute(src_child, dst_child);
+      }
+    } else if (obj_type == H5O_TYPE_DATASET) {
+      auto src_dset = src_group.openDataSet(name);
+      if (!dst_group.nameExists(name)) {
+        // copy the full dataset, with all attributes.
+        H5Ocopy(
+            src_group.getId(),
+            name.c_str(),
+            dst_group.getId(),
+            name.c_str(),
+            H5P_DEFAULT,
+            H5P_DEFAULT
+        );
+      } else if (child_path == RMGConvertLH5::fEventNumberName) {
+        auto dst_dset = dst_group.openDataSet(name);
+        success &= AddScalar(src_dset, dst_dset);
+      } else {
+        LH5Log(RMGLog::warning, "dataset ", child_path, " already exists, skipping");
+      }
+    }
+  }
+
+  return success;
+}
+
+bool RMGMergeLH5::AppendToLH5Internal() {
+  if (!fs::exists(fSrcFileName)) {
+    LH5Log(RMGLog::error, "input file ", fSrcFileName, " does not exist");
+    return false;
+  }
+
+  H5::H5File src_file(fSrcFileName, H5F_ACC_RDONLY);
+  const bool dst_exists = fs::exists(fDstFileName);
+  H5::H5File dst_file(fDstFileName, dst_exists ? H5F_ACC_RDWR : H5F_ACC_EXCL);
+  LH5Log(RMGLog::debug, "appending ", fSrcFileName, " to ", fDstFileName);
+
+  auto src_root = src_file.openGroup("/");
+  auto dst_root = dst_file.openGroup("/");
+  auto success = AppendGroup(src_root, dst_root, "");
+
+  src_file.close();
+  dst_file.close();
+
+  LH5Log(RMGLog::detail, "Done appending LH5 file ", fSrcFileName, " to ", fDstFileName);
+
+  return success;
+}
+
+bool RMGMergeLH5::AppendToLH5(
+    std::string src_file_name,
+    std::string dst_file_name,
+    const std::set<std::string>& dedup_tables,
+    size_t buffer_rows,
+    bool part_of_batch
+) {
+  auto merger = RMGMergeLH5(src_file_name, dst_file_name, dedup_tables, buffer_rows, part_of_batch);
+  try {
+    return merger.AppendToLH5Internal();
+  } catch (const H5::Exception& e) {
+    merger.LH5Log(RMGLog::error, e.getDetailMsg());
+    return false;
+  }
+}
+
+bool RMGMergeLH5::MergeLH5(
+    const std::vector<std::string>& src_file_names,
+    std::string dst_file_name,
+    const std::set<std::string>& dedup_tables,
+    size_t buffer_rows,
+    int prefetch_files
+) {
+  if (fs::exists(dst_file_name)) {
+    auto merger = RMGMergeLH5(dst_file_name, dst_file_name, dedup_tables, buffer_rows, false);
+    merger.LH5Log(RMGLog::error, "output file ", dst_file_name, " already exists");
+    return false;
+  }
+
+  const auto n_files = static_cast<int>(src_file_names.size());
+  const int n_prefetch = std::max(prefetch_files, 0);
+
+  // advise the kernel to start reading the first files in the background.
+  for (int i = 0; i < std::min(n_prefetch, n_files); i++) PrefetchFile(src_file_names[i]);
+
+  bool success = true;
+  for (int i = 0; i < n_files; i++) {
+    if (i + n_prefetch < n_files) PrefetchFile(src_file_names[i + n_prefetch]);
+
+    success &=
+        AppendToLH5(src_file_names[i], dst_file_name, dedup_tables, buffer_rows, n_files > 1);
+  }
+
+  return success;
+}
+
+// vim: tabstop=2 shiftwidth=2 expandtab
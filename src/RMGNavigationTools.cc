@@ -15,17 +15,27 @@
 
 #include "RMGNavigationTools.hh"
 
+#include <algorithm>
+#include <atomic>
 #include <format>
 #include <map>
+#include <mutex>
 #include <queue>
 #include <set>
+#include <thread>
 
+#include "CLHEP/Random/MixMaxRng.h"
+#include "G4BooleanSolid.hh"
 #include "G4LogicalVolume.hh"
 #include "G4LogicalVolumeStore.hh"
 #include "G4Material.hh"
+#include "G4MultiUnion.hh"
 #include "G4PhysicalVolumeStore.hh"
+#include "G4ReflectedSolid.hh"
+#include "G4StateManager.hh"
 #include "G4TransportationManager.hh"
 #include "G4UnitsTable.hh"
+#include "Randomize.hh"
 
 #include "RMGHardware.hh"
 #include "RMGLog.hh"
@@ -203,6 +213,102 @@ void RMGNavigationTools::PrintListOfPhysicalVolumes() {
   RMGLog::Out(RMGLog::summary, "Total: ", volumes.size(), " volumes");
 }
 
+std::vector<const G4VPhysicalVolume*> RMGNavigationTools::CheckOverlapsInTree(
+    const G4VPhysicalVolume* world,
+    int n_points,
+    size_t n_threads
+) {
+
+  // a placement only has to be checked once, even if its mother volume is placed multiple times.
+  std::vector<G4VPhysicalVolume*> volumes;
+  std::vector<const G4LogicalVolume*> mothers;
+  std::set<const G4LogicalVolume*> visited;
+  std::queue<const G4LogicalVolume*> queue;
+  queue.push(world->GetLogicalVolume());
+  while (!queue.empty()) {
+    const auto* logical = queue.front();
+    queue.pop();
+    if (!visited.insert(logical).second) continue;
+    for (size_t i = 0; i < logical->GetNoDaughters(); i++) {
+      auto* daughter = logical->GetDaughter(i);
+      volumes.push_back(daughter);
+      mothers.push_back(logical);
+      queue.push(daughter->GetLogicalVolume());
+    }
+  }
+
+  // the checks sample points on the surface of the (possibly shared) daughter solids. Some solids
+  // set up the sampling lazily on first use, e.g. the surface elements of polycones, so do this
+  // here before the solids are shared between threads.
+  auto* previous_engine = G4Random::getTheEngine();
+  CLHEP::MixMaxRng warmup_engine;
+  G4Random::setTheEngine(&warmup_engine);
+  std::set<const G4VSolid*> solids;
+  for (auto* volume : volumes) {
+    auto* solid = volume->GetLogicalVolume()->GetSolid();
+    if (solids.insert(solid).second) solid->GetPointOnSurface();
+  }
+  G4Random::setTheEngine(previous_engine);
+
+  // Boolean solids and multi-unions also cache the list of their constituents, which is not safe
+  // to use concurrently. A check does not only use the solid of the checked volume, but also
+  // Inside and DistanceToIn of its mother and all its sisters. Serialize all checks that involve
+  // any of these solids.
+  auto is_composite = [](const G4VSolid* solid) {
+    if (auto* reflected = dynamic_cast<const G4ReflectedSolid*>(solid)) {
+      solid = reflected->GetConstituentMovedSolid();
+    }
+    return dynamic_cast<const G4BooleanSolid*>(solid) || dynamic_cast<const G4MultiUnion*>(solid);
+  };
+  std::map<const G4LogicalVolume*, bool> has_composite; // mother -> mother or any daughter.
+  for (const auto* logical : visited) {
+    bool composite = is_composite(logical->GetSolid());
+    for (size_t i = 0; i < logical->GetNoDaughters() && !composite; i++) {
+      composite = is_composite(logical->GetDaughter(i)->GetLogicalVolume()->GetSolid());
+    }
+    has_composite[logical] = composite;
+  }
+  std::vector<char> serialize(volumes.size(), false);
+  for (size_t i = 0; i < volumes.size(); i++) {
+    serialize[i] = has_composite.at(mothers[i]);
+  }
+
+  // the state manager (and with it the exception handler) is thread-local.
+  auto* exception_handler = G4StateManager::GetStateManager()->GetExceptionHandler();
+  std::vector<char> overlaps(volumes.size(), false);
+  std::atomic<size_t> next = 0;
+  std::mutex serialize_mutex;
+  auto check = [&](size_t thread) {
+    if (thread > 0) G4StateManager::GetStateManager()->SetExceptionHandler(exception_handler);
+    auto* previous_engine = G4Random::getTheEngine();
+    CLHEP::MixMaxRng engine(static_cast<long>(thread));
+    G4Random::setTheEngine(&engine);
+    for (size_t i = next++; i < volumes.size(); i = next++) {
+      std::unique_lock lock(serialize_mutex, std::defer_lock);
+      if (serialize[i]) lock.lock();
+      overlaps[i] = volumes[i]->CheckOverlaps(n_points, 0, /* verbose = */ false, 1);
+    }
+    G4Random::setTheEngine(previous_engine);
+  };
+
+#ifdef G4MULTITHREADED
+  // the random engine is only thread-local in multithreaded builds of Geant4.
+  n_threads = std::clamp<size_t>(n_threads, 1, std::max<size_t>(volumes.size(), 1));
+#else
+  n_threads = 1;
+#endif
+  std::vector<std::thread> threads;
+  for (size_t t = 1; t < n_threads; t++) threads.emplace_back(check, t);
+  check(0);
+  for (auto& t : threads) t.join();
+
+  std::vector<const G4VPhysicalVolume*> overlapping;
+  for (size_t i = 0; i < volumes.size(); i++) {
+    if (overlaps[i]) overlapping.push_back(volumes[i]);
+  }
+  return overlapping;
+}
+
 
 std::vector<RMGNavigationTools::VolumeTreeEntry> RMGNavigationTools::FindGlobalPositions(
     const G4VPhysicalVolume* pv
@@ -0,0 +1,113 @@
+// Copyright (C) 2026
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "RMGOpScintillationProcess.hh"
+
+#include "G4Material.hh"
+#include "G4MaterialPropertiesTable.hh"
+#include "G4Scintillation.hh"
+#include "G4Threading.hh"
+
+#include "RMGLog.hh"
+
+RMGOpScintillationProcess::RMGOpScintillationProcess(
+    double thinning_factor,
+    const G4String& aNamePrefix,
+    G4ProcessType aType
+)
+    : G4WrapperProcess(aNamePrefix, aType), fThinningFactor(thinning_factor) {
+
+  if (fThinningFactor < 1) {
+    RMGLog::OutDev(RMGLog::fatal, "scintillation thinning factor must be at least 1");
+  }
+}
+
+void RMGOpScintillationProcess::RegisterProcess(G4VProcess* process) {
+  G4WrapperProcess::RegisterProcess(process);
+  // the creator process of photons has to be recognizable as scintillation.
+  SetProcessSubType(process->GetProcessSubType());
+}
+
+G4VParticleChange* RMGOpScintillationProcess::ApplyWeights(G4VParticleChange* change) const {
+  // the secondaries have already been assigned the weight of the parent track.
+  for (int i = 0; i < change->GetNumberOfSecondaries(); i++) {
+    auto secondary = change->GetSecondary(i);
+    secondary->SetWeight(secondary->GetWeight() * fThinningFactor);
+  }
+  return change;
+}
+
+G4VParticleChange* RMGOpScintillationProcess::PostStepDoIt(
+    const G4Track& aTrack,
+    const G4Step& aStep
+) {
+  return ApplyWeights(pRegProcess->PostStepDoIt(aTrack, aStep));
+}
+
+G4VParticleChange* RMGOpScintillationProcess::AtRestDoIt(
+    const G4Track& aTrack,
+    const G4Step& aStep
+) {
+  return ApplyWeights(pRegProcess->AtRestDoIt(aTrack, aStep));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////
+
+void RMGOpScintillationProcess::BuildPhysicsTable(const G4ParticleDefinition& aParticleType) {
+
+  if (!dynamic_cast<G4Scintillation*>(pRegProcess)) {
+    RMGLog::OutDev(RMGLog::fatal, "RMGOpScintillationProcess can only be used with Scintillation");
+  }
+
+  const auto materialTable = G4Material::GetMaterialTable();
+  for (auto mat : *materialTable) {
+    auto mpt = mat->GetMaterialPropertiesTable();
+    if (!mpt || mpt->ConstPropertyExists("RMG_SCINTILLATIONTHINNING")) continue;
+
+    // just for safety. The master thread builds its tables first, so that the workers should
+    // always find the marker property set above.
+    if (!G4Threading::IsMasterThread()) {
+      RMGLog::OutFormat(
+          RMGLog::fatal,
+          "{}: trying to modify geometry from worker thread",
+          GetProcessName()
+      );
+      continue;
+    }
+
+    // G4Scintillation reads the yields at each step, so they can be scaled here once for all
+    // particles and runs.
+    const double scale = 1. / fThinningFactor;
+    if (mpt->ConstPropertyExists("SCINTILLATIONYIELD")) {
+      const double yield = mpt->GetConstProperty("SCINTILLATIONYIELD");
+      mpt->AddConstProperty("SCINTILLATIONYIELD", yield * scale);
+    }
+    for (const auto& name : kYieldVectorProperties) {
+      auto vec = mpt->GetProperty(name);
+      if (vec) vec->ScaleVector(1., scale);
+    }
+    mpt->AddConstProperty("RMG_SCINTILLATIONTHINNING", fThinningFactor, true);
+
+    RMGLog::OutFormat(
+        RMGLog::debug,
+        "{}: scaled scintillation yields by 1/{} for material {}",
+        GetProcessName(),
+        fThinningFactor,
+        mat->GetName()
+    );
+  }
+
+  pRegProcess->BuildPhysicsTable(aParticleType);
+}
@@ -58,11 +58,18 @@ G4VParticleChange* RMGOpWLSProcess::PostStepDoIt(const G4Track& aTrack, const G4
   auto mpt = mat->GetMaterialPropertiesTable();
   // this case can happen when no original WLSMEANNUMBERPHOTONS had been specified. We still expect
   // to get 1 photon as asserted above, but do not have to sample the efficiency.
-  if (!mpt || !mpt->ConstPropertyExists("RMG_WLSMEANNUMBERPHOTONS")) return particleChange;
+  const bool has_mean_num = mpt && mpt->ConstPropertyExists("RMG_WLSMEANNUMBERPHOTONS");
+  if (!has_mean_num && fThinningFactor == 1) return particleChange;
 
   // actually sample the WLS efficiency, and remove the (single) secondary photon if necessary.
-  double mean_num = mpt->GetConstProperty("RMG_WLSMEANNUMBERPHOTONS");
-  if (G4UniformRand() > mean_num) particleChange->ProposeTrackStatus(fKillTrackAndSecondaries);
+  // With thinning, only 1/k of the photons survive, and these get a k times higher weight.
+  double mean_num = has_mean_num ? mpt->GetConstProperty("RMG_WLSMEANNUMBERPHOTONS") : 1.;
+  if (G4UniformRand() * fThinningFactor > mean_num) {
+    particleChange->ProposeTrackStatus(fKillTrackAndSecondaries);
+  } else if (fThinningFactor > 1) {
+    auto secondary = particleChange->GetSecondary(0);
+    secondary->SetWeight(secondary->GetWeight() * fThinningFactor);
+  }
 
   return particleChange;
 }
@@ -23,6 +23,7 @@
 #include "G4SDManager.hh"
 #include "G4Step.hh"
 #include "G4VVisManager.hh"
+#include "Randomize.hh"
 
 #include "RMGHardware.hh"
 #include "RMGLog.hh"
@@ -109,9 +110,10 @@ bool RMGOpticalDetector::ProcessHits(G4Step* step, G4TouchableHistory* /*history
 
   // check if physical volume is registered as optical detector
   auto det_cons = RMGManager::Instance()->GetDetectorConstruction();
+  int det_uid = -1;
   try {
-    auto d_type = det_cons->GetDetectorMetadata({pv_name, pv_copynr}).type;
-    if (d_type != RMGDetectorType::kOptical) {
+    const auto& det_meta = det_cons->GetDetectorMetadata({pv_name, pv_copynr});
+    if (det_meta.type != RMGDetectorType::kOptical) {
       RMGLog::OutFormatDev(
           RMGLog::debug_event,
           "Volume '{}' (copy nr. {} not registered as optical detector",
@@ -120,6 +122,8 @@ bool RMGOpticalDetector::ProcessHits(G4Step* step, G4TouchableHistory* /*history
       );
       return false;
     }
+    // retrieve unique id for persistency
+    det_uid = det_meta.uid;
   } catch (const std::out_of_range& e) {
     RMGLog::OutFormatDev(
         RMGLog::debug_event,
@@ -130,11 +134,15 @@ bool RMGOpticalDetector::ProcessHits(G4Step* step, G4TouchableHistory* /*history
     return false;
   }
 
-  // retrieve unique id for persistency
-  auto det_uid = det_cons->GetDetectorMetadata({pv_name, pv_copynr}).uid;
-
   RMGLog::OutDev(RMGLog::debug_event, "Hit in optical detector nr. ", det_uid, " detected");
 
+  // apply the detection efficiency, if any, before a hit object is allocated.
+  const auto efficiency = det_cons->GetOpticalDetectorEfficiency(det_uid);
+  if (efficiency && G4UniformRand() >= efficiency->Value(step->GetTotalEnergyDeposit())) {
+    RMGLog::OutDev(RMGLog::debug_event, "Photon rejected by detection efficiency");
+    return false;
+  }
+
   // initialize hit object for uid, if not already there
   auto* hit = new RMGOpticalDetectorHit();
   if (RMGManager::Instance()->GetG4VisManager()->GetCurrentSceneHandler()) {
@@ -143,6 +151,7 @@ bool RMGOpticalDetector::ProcessHits(G4Step* step, G4TouchableHistory* /*history
   hit->detector_uid = det_uid;
   hit->photon_wavelength = CLHEP::c_light * CLHEP::h_Planck / step->GetTotalEnergyDeposit();
   hit->global_time = step->GetPostStepPoint()->GetGlobalTime();
+  hit->weight = step->GetTrack()->GetWeight();
 
   // register the hit in the hit collection for the event
   fHitsCollection->insert(hit);
@@ -0,0 +1,269 @@
+// Copyright (C) 2026
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "RMGOpticalMap.hh"
+
+#include <algorithm>
+#include <cmath>
+
+#include "CLHEP/Units/SystemOfUnits.h"
+
+#include "RMGConfig.hh"
+#include "RMGLog.hh"
+
+#if RMG_HAS_HDF5
+#include "H5Cpp.h"
+#endif
+
+namespace u = CLHEP;
+
+RMGOpticalMap::RMGOpticalMap(
+    const G4ThreeVector& lower,
+    const G4ThreeVector& upper,
+    double bin_width,
+    std::vector<int> det_uids
+)
+    : fLower(lower), fBinWidth(bin_width), fDetUids(std::move(det_uids)) {
+
+  if (bin_width <= 0) RMGLog::Out(RMGLog::fatal, "Optical map bin width must be positive");
+  for (int i = 0; i < 3; i++) {
+    fNBins[i] = std::max<int64_t>(1, std::ceil((upper[i] - lower[i]) / bin_width));
+  }
+  this->Allocate();
+  fNGenerated.assign(fNVoxels, 0);
+  fNDetected.assign(fNVoxels * fDetUids.size(), 0);
+}
+
+void RMGOpticalMap::Allocate() {
+  fNVoxels = fNBins[0] * fNBins[1] * fNBins[2];
+  fDetIndex.clear();
+  for (size_t i = 0; i < fDetUids.size(); i++) fDetIndex.emplace(fDetUids[i], i);
+}
+
+int64_t RMGOpticalMap::GetVoxelIndex(const G4ThreeVector& pos) const {
+  int64_t idx = 0;
+  for (int i = 0; i < 3; i++) {
+    const double bin = std::floor((pos[i] - fLower[i]) / fBinWidth);
+    if (bin < 0 || bin >= fNBins[i]) return -1;
+    idx = idx * fNBins[i] + static_cast<int64_t>(bin);
+  }
+  return idx;
+}
+
+int RMGOpticalMap::SampleDetector(int64_t voxel, double rnd) const {
+  const size_t n_det = fDetUids.size();
+  const auto row = fCumulativeProb.begin() + voxel * n_det;
+  const auto it = std::upper_bound(row, row + n_det, rnd);
+  return it == row + n_det ? -1 : fDetUids[it - row];
+}
+
+void RMGOpticalMap::AddDetected(int64_t voxel, int det_uid, double n) {
+  auto it = fDetIndex.find(det_uid);
+  if (it == fDetIndex.end()) return;
+  fNDetected[voxel * fDetUids.size() + it->second] += n;
+}
+
+void RMGOpticalMap::Merge(const RMGOpticalMap& other) {
+  if (other.fNBins != fNBins || other.fDetUids != fDetUids) {
+    RMGLog::Out(RMGLog::error, "Cannot merge optical maps with different binning or detectors");
+    return;
+  }
+  for (int64_t i = 0; i < fNVoxels; i++) fNGenerated[i] += other.fNGenerated[i];
+  for (size_t i = 0; i < fNDetected.size(); i++) fNDetected[i] += other.fNDetected[i];
+}
+
+void RMGOpticalMap::UpdateCumulativeProbabilities() {
+  const size_t n_det = fDetUids.size();
+  int64_t n_invalid = 0;
+  for (int64_t v = 0; v < fNVoxels; v++) {
+    double sum = 0;
+    for (size_t d = 0; d < n_det; d++) {
+      sum += fCumulativeProb[v * n_det + d];
+      fCumulativeProb[v * n_det + d] = sum;
+    }
+    if (sum > 1 + 1e-6) n_invalid++;
+  }
+  if (n_invalid > 0) {
+    RMGLog::OutFormat(
+        RMGLog::warning,
+        "Detection probabilities of all detectors sum up to more than 1 in {} voxels",
+        n_invalid
+    );
+  }
+}
+
+#if RMG_HAS_HDF5
+
+namespace {
+
+  void SetDatatypeAttribute(H5::H5Object& obj, const std::string& value) {
+    H5::StrType att_dtype(0, H5T_VARIABLE);
+    H5::DataSpace scalar(H5S_SCALAR);
+    auto att = obj.createAttribute("datatype", att_dtype, scalar);
+    att.write(att_dtype, value);
+  }
+
+  template<typename T>
+  void WriteArray(
+      H5::Group& group,
+      const std::string& name,
+      const std::vector<T>& data,
+      const std::vector<hsize_t>& shape,
+      const H5::PredType& type,
+      const std::string& units = ""
+  ) {
+    H5::DataSpace space(shape.size(), shape.data());
+    auto dset = group.createDataSet(name, type, space);
+    dset.write(data.data(), type);
+    SetDatatypeAttribute(dset, "array<" + std::to_string(shape.size()) + ">{real}");
+    if (!units.empty()) {
+      H5::StrType att_dtype(0, H5T_VARIABLE);
+      H5::DataSpace scalar(H5S_SCALAR);
+      dset.createAttribute("units", att_dtype, scalar).write(att_dtype, units);
+    }
+  }
+
+  template<typename T>
+  std::vector<T> ReadArray(H5::Group& group, const std::string& name, const H5::PredType& type) {
+    auto dset = group.openDataSet(name);
+    std::vector<T> data(dset.getSpace().getSimpleExtentNpoints());
+    dset.read(data.data(), type);
+    return data;
+  }
+
+} // namespace
+
+std::unique_ptr<RMGOpticalMap> RMGOpticalMap::ReadFromFile(const std::string& file_name) {
+
+  RMGLog::Out(RMGLog::detail, "Reading optical map from ", file_name);
+
+  std::unique_ptr<RMGOpticalMap> map(new RMGOpticalMap());
+  try {
+    H5::H5File file(file_name, H5F_ACC_RDONLY);
+    auto group = file.openGroup("optmap");
+
+    std::array<std::string, 3> edge_names = {"xedges", "yedges", "zedges"};
+    for (int i = 0; i < 3; i++) {
+      auto edges = ReadArray<double>(group, edge_names[i], H5::PredType::NATIVE_DOUBLE);
+      if (edges.size() < 2) {
+        RMGLog::OutFormat(RMGLog::fatal, "Invalid {} in optical map {}", edge_names[i], file_name);
+      }
+      map->fNBins[i] = edges.size() - 1;
+      map->fLower[i] = edges.front() * u::mm;
+      const double width = (edges.back() - edges.front()) * u::mm / map->fNBins[i];
+      if (i > 0 && std::abs(width - map->fBinWidth) > 1e-6 * width) {
+        RMGLog::OutFormat(RMGLog::fatal, "Optical map {} does not have cubic voxels", file_name);
+      }
+      map->fBinWidth = width;
+    }
+
+    map->fDetUids = ReadArray<int>(group, "det_uid", H5::PredType::NATIVE_INT);
+    map->Allocate();
+
+    // transpose the (det, x, y, z) array into the voxel-major layout used for sampling.
+    const auto prob = ReadArray<double>(group, "prob", H5::PredType::NATIVE_DOUBLE);
+    const size_t n_det = map->fDetUids.size();
+    if (prob.size() != n_det * map->fNVoxels) {
+      RMGLog::OutFormat(RMGLog::fatal, "Invalid shape of prob in optical map {}", file_name);
+    }
+    map->fCumulativeProb.resize(prob.size());
+    for (size_t d = 0; d < n_det; d++) {
+      for (int64_t v = 0; v < map->fNVoxels; v++) {
+        map->fCumulativeProb[v * n_det + d] = prob[d * map->fNVoxels + v];
+      }
+    }
+  } catch (const H5::Exception& e) {
+    RMGLog::OutFormat(
+        RMGLog::fatal,
+        "Could not read optical map {}: {}",
+        file_name,
+        e.getDetailMsg()
+    );
+  }
+  map->UpdateCumulativeProbabilities();
+
+  RMGLog::OutFormat(
+      RMGLog::detail,
+      "Optical map has {}x{}x{} voxels of {} mm and {} detectors",
+      map->fNBins[0],
+      map->fNBins[1],
+      map->fNBins[2],
+      map->fBinWidth / u::mm,
+      map->fDetUids.size()
+  );
+  return map;
+}
+
+void RMGOpticalMap::WriteToFile(const std::string& file_name) const {
+
+  RMGLog::Out(RMGLog::summary, "Writing optical map to ", file_name);
+
+  const size_t n_det = fDetUids.size();
+  std::vector<double> n_detected(fNDetected.size());
+  std::vector<double> prob(fNDetected.size(), 0);
+  for (size_t d = 0; d < n_det; d++) {
+    for (int64_t v = 0; v < fNVoxels; v++) {
+      const auto n = fNDetected[v * n_det + d];
+      n_detected[d * fNVoxels + v] = n;
+      if (fNGenerated[v] > 0) prob[d * fNVoxels + v] = n / fNGenerated[v];
+    }
+  }
+
+  try {
+    H5::H5File file(file_name, H5F_ACC_TRUNC);
+    auto group = file.createGroup("optmap");
+    SetDatatypeAttribute(group, "struct{xedges,yedges,zedges,det_uid,n_generated,n_detected,prob}");
+
+    std::array<std::string, 3> edge_names = {"xedges", "yedges", "zedges"};
+    for (int i = 0; i < 3; i++) {
+      std::vector<double> edges(fNBins[i] + 1);
+      for (int64_t b = 0; b <= fNBins[i]; b++) edges[b] = (fLower[i] + b * fBinWidth) / u::mm;
+      WriteArray(group, edge_names[i], edges, {edges.size()}, H5::PredType::NATIVE_DOUBLE, "mm");
+    }
+
+    const std::vector<hsize_t> shape = {
+        static_cast<hsize_t>(fNBins[0]),
+        static_cast<hsize_t>(fNBins[1]),
+        static_cast<hsize_t>(fNBins[2])
+    };
+    const std::vector<hsize_t> det_shape = {n_det, shape[0], shape[1], shape[2]};
+    WriteArray(group, "det_uid", fDetUids, {n_det}, H5::PredType::NATIVE_INT);
+    WriteArray(group, "n_generated", fNGenerated, shape, H5::PredType::NATIVE_INT64);
+    WriteArray(group, "n_detected", n_detected, det_shape, H5::PredType::NATIVE_DOUBLE);
+    WriteArray(group, "prob", prob, det_shape, H5::PredType::NATIVE_DOUBLE);
+  } catch (const H5::Exception& e) {
+    RMGLog::OutFormat(
+        RMGLog::error,
+        "Could not write optical map {}: {}",
+        file_name,
+        e.getDetailMsg()
+    );
+  }
+}
+
+#else
+
+std::unique_ptr<RMGOpticalMap> RMGOpticalMap::ReadFromFile(const std::string&) {
+  RMGLog::Out(RMGLog::fatal, "Optical maps are only available with HDF5 support");
+  return nullptr;
+}
+
+void RMGOpticalMap::WriteToFile(const std::string&) const {
+  RMGLog::Out(RMGLog::fatal, "Optical maps are only available with HDF5 support");
+}
+
+#endif
+
+// vim: tabstop=2 shiftwidth=2 expandtab
@@ -0,0 +1,233 @@
+// Copyright (C) 2026
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "RMGOpticalMapScheme.hh"
+
+#include <set>
+#include <vector>
+
+#include "G4Event.hh"
+#include "G4EventManager.hh"
+#include "G4HCofThisEvent.hh"
+#include "G4OpProcessSubType.hh"
+#include "G4OpticalPhoton.hh"
+#include "G4PrimaryParticle.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4SDManager.hh"
+#include "G4Threading.hh"
+#include "G4VProcess.hh"
+#include "Randomize.hh"
+
+#include "RMGHardware.hh"
+#include "RMGLog.hh"
+#include "RMGManager.hh"
+
+namespace u = CLHEP;
+
+RMGOpticalMapScheme::RMGOpticalMapScheme() { this->DefineCommands(); }
+
+void RMGOpticalMapScheme::LoadMap(std::string file_name) {
+
+  if (!fCreateMapFileName.empty()) {
+    RMGLog::Out(RMGLog::error, "Cannot load an optical map while creating one, ignoring");
+    return;
+  }
+
+  // all threads share the same map in memory.
+  G4AutoLock lock(&fMutex);
+  auto& loaded = fLoadedMaps[file_name];
+  fMap = loaded.lock();
+  if (!fMap) {
+    fMap = RMGOpticalMap::ReadFromFile(file_name);
+    loaded = fMap;
+  }
+  lock.unlock();
+
+  // all detectors in the map must be known to the optical output scheme.
+  std::set<int> optical_uids;
+  const auto det_cons = RMGManager::Instance()->GetDetectorConstruction();
+  for (const auto& [k, v] : det_cons->GetDetectorMetadataMap()) {
+    if (v.type == RMGDetectorType::kOptical) optical_uids.insert(v.uid);
+  }
+  for (const auto uid : fMap->GetDetectorUids()) {
+    if (!optical_uids.contains(uid)) {
+      RMGLog::OutFormat(
+          RMGLog::fatal,
+          "Optical map {} contains uid {}, which is not registered as optical detector",
+          file_name,
+          uid
+      );
+    }
+  }
+}
+
+RMGOpticalDetectorHitsCollection* RMGOpticalMapScheme::GetHitsCollection() {
+
+  if (fHitsCollectionID < 0) {
+    fHitsCollectionID = G4SDManager::GetSDMpointer()->GetCollectionID("Optical/Hits");
+    if (fHitsCollectionID < 0) {
+      RMGLog::OutDev(RMGLog::fatal, "Could not find hit collection Optical/Hits");
+    }
+  }
+
+  auto event = G4EventManager::GetEventManager()->GetConstCurrentEvent();
+  if (!event || !event->GetHCofThisEvent()) return nullptr;
+  return dynamic_cast<RMGOpticalDetectorHitsCollection*>(
+      event->GetHCofThisEvent()->GetHC(fHitsCollectionID)
+  );
+}
+
+std::optional<G4ClassificationOfNewTrack> RMGOpticalMapScheme::StackingActionClassify(
+    const G4Track* aTrack,
+    int
+) {
+  if (!fMap) return std::nullopt;
+
+  if (aTrack->GetDefinition() != G4OpticalPhoton::OpticalPhotonDefinition()) return std::nullopt;
+  const auto creator = aTrack->GetCreatorProcess();
+  if (!creator || creator->GetProcessSubType() != fScintillation) return std::nullopt;
+
+  // photons emitted outside of the map are never detected.
+  const auto voxel = fMap->GetVoxelIndex(aTrack->GetPosition());
+  const int det_uid = voxel < 0 ? -1 : fMap->SampleDetector(voxel, G4UniformRand());
+  if (det_uid < 0) return fKill;
+
+  auto hit_coll = this->GetHitsCollection();
+  if (!hit_coll) {
+    RMGLog::OutDev(RMGLog::error, "Could not find hit collection associated with event");
+    return fKill;
+  }
+
+  auto* hit = new RMGOpticalDetectorHit();
+  hit->detector_uid = det_uid;
+  hit->photon_wavelength = u::c_light * u::h_Planck / aTrack->GetTotalEnergy();
+  hit->global_time = aTrack->GetGlobalTime();
+  hit->weight = aTrack->GetWeight();
+  hit_coll->insert(hit);
+
+  return fKill;
+}
+
+void RMGOpticalMapScheme::StoreEvent(const G4Event* event) {
+
+  if (fCreateMapFileName.empty()) return;
+
+  if (!fCreatedMap) {
+    std::set<int> uids;
+    const auto det_cons = RMGManager::Instance()->GetDetectorConstruction();
+    for (const auto& [k, v] : det_cons->GetDetectorMetadataMap()) {
+      if (v.type == RMGDetectorType::kOptical) uids.insert(v.uid);
+    }
+    fCreatedMap = std::make_unique<RMGOpticalMap>(
+        fCreateMapLower,
+        fCreateMapUpper,
+        fCreateMapBinWidth,
+        std::vector<int>(uids.begin(), uids.end())
+    );
+  }
+
+  // the hits cannot be associated to a specific vertex, so only one vertex is supported.
+  if (event->GetNumberOfPrimaryVertex() != 1) {
+    if (!fWarnedNumberOfVertices) {
+      RMGLog::Out(
+          RMGLog::warning,
+          "Optical map creation needs exactly one primary vertex per event, skipping events"
+      );
+      fWarnedNumberOfVertices = true;
+    }
+    return;
+  }
+
+  const auto vertex = event->GetPrimaryVertex(0);
+  const auto voxel = fCreatedMap->GetVoxelIndex(vertex->GetPosition());
+  if (voxel < 0) return;
+
+  int n_photons = 0;
+  for (int i = 0; i < vertex->GetNumberOfParticle(); i++) {
+    const auto particle = vertex->GetPrimary(i)->GetParticleDefinition();
+    if (particle == G4OpticalPhoton::OpticalPhotonDefinition()) n_photons++;
+  }
+  fCreatedMap->AddGenerated(voxel, n_photons);
+
+  auto hit_coll_id = G4SDManager::GetSDMpointer()->GetCollectionID("Optical/Hits");
+  if (hit_coll_id < 0 || !event->GetHCofThisEvent()) return;
+  auto hit_coll = dynamic_cast<RMGOpticalDetectorHitsCollection*>(
+      event->GetHCofThisEvent()->GetHC(hit_coll_id)
+  );
+  if (!hit_coll) return;
+  for (auto hit : *hit_coll->GetVector()) {
+    if (hit) fCreatedMap->AddDetected(voxel, hit->detector_uid, hit->weight);
+  }
+}
+
+void RMGOpticalMapScheme::EndOfRunAction(const G4Run*) {
+
+  if (fCreateMapFileName.empty()) return;
+
+  // worker threads finish their run before the master thread.
+  G4AutoLock lock(&fMutex);
+  if (fCreatedMap) {
+    if (!fMergedMap) fMergedMap = std::move(fCreatedMap);
+    else fMergedMap->Merge(*fCreatedMap);
+    fCreatedMap.reset();
+  }
+
+  if (G4Threading::IsMasterThread() && fMergedMap) {
+    fMergedMap->WriteToFile(fCreateMapFileName);
+    fMergedMap.reset();
+  }
+}
+
+void RMGOpticalMapScheme::DefineCommands() {
+
+  fMessenger = std::make_unique<G4GenericMessenger>(
+      this,
+      "/RMG/OpticalMap/",
+      "Commands for optical map based simulation of scintillation light."
+  );
+
+  fMessenger->DeclareMethod("LoadMap", &RMGOpticalMapScheme::LoadMap)
+      .SetGuidance("Load an optical map and replace tracking of scintillation photons by it.")
+      .SetGuidance(
+          "note: the detection probabilities of the voxel of the emission point of each "
+          "scintillation photon are used to sample the detecting optical detector."
+      )
+      .SetParameterName("file_name", false)
+      .SetStates(G4State_Idle);
+
+  fMessenger->DeclareProperty("CreateMap", fCreateMapFileName)
+      .SetGuidance("Create an optical map from this run and write it to the given file.")
+      .SetGuidance(
+          "note: optical photons have to be generated as primaries, with one vertex per event."
+      )
+      .SetParameterName("file_name", false)
+      .SetStates(G4State_Idle);
+
+  fMessenger->DeclarePropertyWithUnit("CreateMapLowerEdge", "mm", fCreateMapLower)
+      .SetGuidance("Set the lower corner of the box covered by a created optical map.")
+      .SetStates(G4State_Idle);
+
+  fMessenger->DeclarePropertyWithUnit("CreateMapUpperEdge", "mm", fCreateMapUpper)
+      .SetGuidance("Set the upper corner of the box covered by a created optical map.")
+      .SetStates(G4State_Idle);
+
+  fMessenger->DeclarePropertyWithUnit("CreateMapBinWidth", "mm", fCreateMapBinWidth)
+      .SetGuidance("Set the edge length of the (cubic) voxels of a created optical map.")
+      .SetParameterName("width", false)
+      .SetRange("width > 0")
+      .SetStates(G4State_Idle);
+}
+
+// vim: tabstop=2 shiftwidth=2 expandtab
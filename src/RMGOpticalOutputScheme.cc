@@ -15,18 +15,23 @@
 
 #include "RMGOpticalOutputScheme.hh"
 
+#include <algorithm>
+#include <map>
 #include <set>
+#include <vector>
 
 #include "G4AnalysisManager.hh"
 #include "G4Event.hh"
 #include "G4HCtable.hh"
 #include "G4SDManager.hh"
+#include "G4UnitsTable.hh"
 
 #include "RMGHardware.hh"
 #include "RMGLog.hh"
 #include "RMGManager.hh"
 #include "RMGOpticalDetector.hh"
 #include "RMGOutputManager.hh"
+#include "RMGPhysics.hh"
 
 namespace u = CLHEP;
 
@@ -39,6 +44,10 @@ void RMGOpticalOutputScheme::AssignOutputNames(G4AnalysisManager* ana_man) {
   const auto det_cons = RMGManager::Instance()->GetDetectorConstruction();
   const auto detectors = det_cons->GetDetectorMetadataMap();
 
+  // photon weights are only different from 1 with thinning of optical photons.
+  const auto physics = dynamic_cast<RMGPhysics*>(RMGManager::Instance()->GetProcessesList());
+  fStoreWeights = physics && physics->HasOpticalThinning();
+
   std::set<int> registered_uids;
   std::map<std::string, int> registered_ntuples;
   for (auto&& det : detectors) {
@@ -66,8 +75,15 @@ void RMGOpticalOutputScheme::AssignOutputNames(G4AnalysisManager* ana_man) {
 
     ana_man->CreateNtupleIColumn(id, "evtid");
     if (!fNtuplePerDetector) { ana_man->CreateNtupleIColumn(id, "det_uid"); }
-    CreateNtupleFOrDColumn(ana_man, id, "wavelength_in_nm", fStoreSinglePrecisionEnergy);
-    ana_man->CreateNtupleDColumn(id, "time_in_ns");
+    if (fPhotonCounting) {
+      ana_man->CreateNtupleDColumn(id, "time_in_ns");
+      ana_man->CreateNtupleDColumn(id, "n_photons");
+    } else {
+      CreateNtupleFOrDColumn(ana_man, id, "wavelength_in_nm", fStoreSinglePrecisionEnergy);
+      ana_man->CreateNtupleDColumn(id, "time_in_ns");
+      if (fStoreWeights) ana_man->CreateNtupleDColumn(id, "weight");
+    }
+    if (fReshapeHits) ana_man->CreateNtupleIColumn(id, fHitStartColumnName);
 
     ana_man->FinishNtuple(id);
   }
@@ -100,15 +116,20 @@ void RMGOpticalOutputScheme::StoreEvent(const G4Event* event) {
   }
 
   auto rmg_man = RMGOutputManager::Instance();
-  if (rmg_man->IsPersistencyEnabled()) {
+  if (rmg_man->IsPersistencyEnabled() && fPhotonCounting) {
+    StorePhotonCounts(event, *hit_coll->GetVector());
+  } else if (rmg_man->IsPersistencyEnabled()) {
     RMGLog::OutDev(RMGLog::debug_event, "Filling persistent data vectors");
     const auto ana_man = G4AnalysisManager::Instance();
 
+    std::vector<OrderedStep<RMGOpticalDetectorHit>> steps;
     for (auto hit : *hit_coll->GetVector()) {
       if (!hit) continue;
-      hit->Print();
+      steps.push_back({hit, rmg_man->GetNtupleID(hit->detector_uid), false});
+    }
 
-      auto ntupleid = rmg_man->GetNtupleID(hit->detector_uid);
+    for (const auto& [hit, ntupleid, hit_start] : OrderStepsIntoHits(std::move(steps))) {
+      hit->Print();
 
       int col_id = 0;
       ana_man->FillNtupleIColumn(ntupleid, col_id++, GetEventIDForStorage(event));
@@ -123,6 +144,8 @@ void RMGOpticalOutputScheme::StoreEvent(const G4Event* event) {
           fStoreSinglePrecisionEnergy
       );
       ana_man->FillNtupleDColumn(ntupleid, col_id++, hit->global_time / u::ns);
+      if (fStoreWeights) ana_man->FillNtupleDColumn(ntupleid, col_id++, hit->weight);
+      if (fReshapeHits) ana_man->FillNtupleIColumn(ntupleid, col_id++, hit_start);
 
       // NOTE: must be called here for hit-oriented output
       ana_man->AddNtupleRow(ntupleid);
@@ -130,6 +153,55 @@ void RMGOpticalOutputScheme::StoreEvent(const G4Event* event) {
   }
 }
 
+void RMGOpticalOutputScheme::StorePhotonCounts(
+    const G4Event* event,
+    const std::vector<RMGOpticalDetectorHit*>& hits
+) {
+  auto rmg_man = RMGOutputManager::Instance();
+  const auto ana_man = G4AnalysisManager::Instance();
+
+  // aggregate the photons per detector and time bin. Without time bins, the time of the first
+  // photon is stored. Thinned photons are counted with their statistical weight.
+  const bool use_bins = fPhotonCountingTimeBinWidth > 0;
+  std::map<std::pair<int, int>, RMGPhotonCount> counts;
+  for (auto hit : hits) {
+    if (!hit) continue;
+    int bin = 0;
+    if (use_bins) {
+      // the last bin also holds the overflow. Clamp before converting, as the time of late photons
+      // in units of the bin width might not fit into an int.
+      const double t_bin = std::max(hit->global_time, 0.) / fPhotonCountingTimeBinWidth;
+      const int last_bin = fPhotonCountingTimeBins - 1;
+      bin = t_bin < last_bin ? static_cast<int>(t_bin) : last_bin;
+    }
+    const double time = use_bins ? bin * fPhotonCountingTimeBinWidth : hit->global_time;
+    const std::pair<int, int> key{hit->detector_uid, bin};
+    auto it = counts.try_emplace(key, RMGPhotonCount{hit->detector_uid, time, 0}).first;
+    if (!use_bins) it->second.global_time = std::min(it->second.global_time, hit->global_time);
+    it->second.n_photons += hit->weight;
+  }
+
+  std::vector<OrderedStep<RMGPhotonCount>> rows;
+  rows.reserve(counts.size());
+  for (auto& [key, count] : counts) {
+    rows.push_back({&count, rmg_man->GetNtupleID(count.detector_uid), false});
+  }
+
+  RMGLog::OutDev(RMGLog::debug_event, "Filling ", rows.size(), " photon counts");
+  for (const auto& [count, ntupleid, hit_start] : OrderStepsIntoHits(std::move(rows))) {
+    int col_id = 0;
+    ana_man->FillNtupleIColumn(ntupleid, col_id++, GetEventIDForStorage(event));
+    if (!fNtuplePerDetector) {
+      ana_man->FillNtupleIColumn(ntupleid, col_id++, count->detector_uid);
+    }
+    ana_man->FillNtupleDColumn(ntupleid, col_id++, count->global_time / u::ns);
+    ana_man->FillNtupleDColumn(ntupleid, col_id++, count->n_photons);
+    if (fReshapeHits) ana_man->FillNtupleIColumn(ntupleid, col_id++, hit_start);
+
+    ana_man->AddNtupleRow(ntupleid);
+  }
+}
+
 void RMGOpticalOutputScheme::DefineCommands() {
 
   fMessenger = std::make_unique<G4GenericMessenger>(
@@ -146,6 +218,42 @@ void RMGOpticalOutputScheme::DefineCommands() {
       .SetParameterName("boolean", true)
       .SetDefaultValue("true")
       .SetStates(G4State_Idle);
+
+  fMessenger->DeclareProperty("PhotonCounting", fPhotonCounting)
+      .SetGuidance(
+          "Only store the number of detected photons per event and detector (and time bin, see "
+          "PhotonCountingTimeBinWidth), instead of one row per detected photon."
+      )
+      .SetGuidance(
+          std::string("This is ") + (fPhotonCounting ? "enabled" : "disabled") + " by default"
+      )
+      .SetParameterName("boolean", true)
+      .SetDefaultValue("true")
+      .SetStates(G4State_Idle);
+
+  fMessenger
+      ->DeclarePropertyWithUnit("PhotonCountingTimeBinWidth", "ns", fPhotonCountingTimeBinWidth)
+      .SetGuidance(
+          "Split the photon counts into bins of the arrival time with this width. If zero, only "
+          "the total count and the time of the first photon are stored."
+      )
+      .SetGuidance(
+          std::string("Uses ") + std::string(G4BestUnit(fPhotonCountingTimeBinWidth, "Time")) +
+          " by default"
+      )
+      .SetParameterName("width", false)
+      .SetRange("width >= 0")
+      .SetStates(G4State_Idle);
+
+  fMessenger->DeclareProperty("PhotonCountingTimeBins", fPhotonCountingTimeBins)
+      .SetGuidance(
+          "Set the number of time bins for the photon counts. Later photons are counted in the "
+          "last bin."
+      )
+      .SetGuidance("Uses " + std::to_string(fPhotonCountingTimeBins) + " by default")
+      .SetParameterName("n", false)
+      .SetRange("n > 0")
+      .SetStates(G4State_Idle);
 }
 
 // vim: tabstop=2 shiftwidth=2 expandtab
@@ -24,6 +24,7 @@
 #include <vector>
 
 #include "G4AnalysisManager.hh"
+#include "G4UnitsTable.hh"
 #include "Randomize.hh"
 
 #include "RMGConfig.hh"
@@ -82,6 +83,14 @@ int RMGOutputManager::CreateAndRegisterAuxNtuple(
   return this->GetAuxNtupleID(table_name);
 }
 
+void RMGOutputManager::RegisterNtupleDeduplication(std::string table_name) {
+  G4AutoLock l(&fNtupleDeduplicateMutex);
+  fNtupleDeduplicate.insert(table_name);
+  l.unlock();
+
+  RMGIpc::SendIpcNonBlocking(RMGIpc::CreateMessage("output_ntuple_deduplicate", table_name));
+}
+
 void RMGOutputManager::ActivateOptionalOutputScheme(std::string name) {
   RMGManager::Instance()->ActivateOptionalOutputScheme(name);
 }
@@ -124,6 +133,81 @@ void RMGOutputManager::DefineCommands() {
       .SetGuidance("note: This setting is not respected by all output formats.")
       .SetParameterName("nt_directory", false)
       .SetStates(G4State_PreInit, G4State_Idle);
+
+  fOutputMessenger->DeclareMethod("MergeThreadFiles", &RMGOutputManager::SetOutputMergeThreadFiles)
+      .SetGuidance(
+          "Append the output of all worker threads to a single output file at the end of each "
+          "worker's run, instead of writing one file per thread."
+      )
+      .SetGuidance("note: This setting is only respected for LH5 output files.")
+      .SetGuidance(
+          std::string("This is ") + (fOutputMergeThreadFiles ? "enabled" : "disabled") +
+          " by default"
+      )
+      .SetParameterName("boolean", true)
+      .SetDefaultValue("true")
+      .SetStates(G4State_PreInit, G4State_Idle);
+
+  fOutputMessenger->DeclareMethod("ReshapeHits", &RMGOutputManager::SetOutputReshapeHits)
+      .SetGuidance(
+          "Group the steps in detectors into time-windowed hits while writing the output, instead "
+          "of reshaping the output files in the post-processing."
+      )
+      .SetGuidance("note: This setting is only respected for LH5 output files.")
+      .SetGuidance(
+          std::string("This is ") + (fOutputReshapeHits ? "enabled" : "disabled") + " by default"
+      )
+      .SetParameterName("boolean", true)
+      .SetDefaultValue("true")
+      .SetStates(G4State_PreInit, G4State_Idle);
+
+  fOutputMessenger
+      ->DeclareMethodWithUnit(
+          "ReshapeTimeWindow",
+          "us",
+          &RMGOutputManager::SetOutputReshapeTimeWindow
+      )
+      .SetGuidance("Set the time window used to group steps into hits with ReshapeHits.")
+      .SetGuidance(
+          std::string("Uses ") + std::string(G4BestUnit(fOutputReshapeTimeWindow, "Time")) +
+          " by default"
+      )
+      .SetParameterName("time_window", false)
+      .SetStates(G4State_PreInit, G4State_Idle);
+
+  fOutputMessenger->DeclareMethod("EventIndex", &RMGOutputManager::SetOutputEventIndex)
+      .SetGuidance(
+          "Write an index table with the first row and number of rows of each event for each "
+          "detector table, to allow random access to single events."
+      )
+      .SetGuidance("note: This setting is only respected for LH5 output files.")
+      .SetGuidance(
+          std::string("This is ") + (fOutputEventIndex ? "enabled" : "disabled") + " by default"
+      )
+      .SetParameterName("boolean", true)
+      .SetDefaultValue("true")
+      .SetStates(G4State_PreInit, G4State_Idle);
+
+  fOutputMessenger
+      ->DeclareMethod("MaxEventsPerFile", &RMGOutputManager::SetOutputMaxEventsPerFile)
+      .SetGuidance(
+          "Close and convert the output file after this number of events, and continue the run "
+          "with a new output file (with a _f$n suffix). 0 disables the limit."
+      )
+      .SetGuidance("note: This setting is only respected for LH5 output files.")
+      .SetParameterName("max_events", false)
+      .SetRange("max_events >= 0")
+      .SetStates(G4State_PreInit, G4State_Idle);
+
+  fOutputMessenger->DeclareMethod("MaxBytesPerFile", &RMGOutputManager::SetOutputMaxBytesPerFile)
+      .SetGuidance(
+          "Close and convert the output file after it reached approximately this size in bytes, "
+          "and continue the run with a new output file (with a _f$n suffix). 0 disables the limit."
+      )
+      .SetGuidance("note: This setting is only respected for LH5 output files.")
+      .SetParameterName("max_bytes", false)
+      .SetRange("max_bytes >= 0")
+      .SetStates(G4State_PreInit, G4State_Idle);
 }
 
 // vim: tabstop=2 shiftwidth=2 expandtab
@@ -15,8 +15,13 @@
 
 #include "RMGPhysics.hh"
 
+#include <cstdlib>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <sstream>
+
+#include <unistd.h>
 
 #include "G4BaryonConstructor.hh"
 #include "G4BosonConstructor.hh"
@@ -26,6 +31,7 @@
 #include "G4EmExtraPhysics.hh"
 #include "G4EmLivermorePhysics.hh"
 #include "G4EmLivermorePolarizedPhysics.hh"
+#include "G4EmParameters.hh"
 #include "G4EmPenelopePhysics.hh"
 #include "G4EmStandardPhysics.hh"
 #include "G4EmStandardPhysics_option1.hh"
@@ -45,6 +51,7 @@
 #include "G4IonPhysics.hh"
 #include "G4IonTable.hh"
 #include "G4LeptonConstructor.hh"
+#include "G4Material.hh"
 #include "G4MesonConstructor.hh"
 #include "G4NeutronCaptureProcess.hh"
 #include "G4NuclearLevelData.hh"
@@ -66,6 +73,7 @@
 #include "G4RunManagerKernel.hh"
 #include "G4Scintillation.hh"
 #include "G4ShortLivedConstructor.hh"
+#include "G4StateManager.hh"
 #include "G4StepLimiter.hh"
 #include "G4StepLimiterPhysics.hh"
 #include "G4StoppingPhysics.hh"
@@ -77,11 +85,13 @@
 #include "RMGInnerBremsstrahlungProcess.hh"
 #include "RMGLog.hh"
 #include "RMGNeutronCaptureProcess.hh"
+#include "RMGOpScintillationProcess.hh"
 #include "RMGOpWLSProcess.hh"
 #include "RMGSelectiveEkinMinCutProcess.hh"
 #include "RMGTools.hh"
 
 namespace u = CLHEP;
+namespace fs = std::filesystem;
 
 RMGPhysics::RMGPhysics() {
 
@@ -390,9 +400,21 @@ void RMGPhysics::ConstructOptical() {
   op_par->SetWLSTimeProfile("exponential");    // not default
 
   // scintillation process
-  auto scint_proc = new G4Scintillation("Scintillation");
-  scint_proc->SetTrackSecondariesFirst(true);
-  scint_proc->SetVerboseLevel(G4VModularPhysicsList::verboseLevel);
+  auto g4_scint_proc = new G4Scintillation("Scintillation");
+  g4_scint_proc->SetTrackSecondariesFirst(true);
+  g4_scint_proc->SetVerboseLevel(G4VModularPhysicsList::verboseLevel);
+  G4VProcess* scint_proc = g4_scint_proc;
+
+  if (fOpticalScintillationThinning > 1) {
+    RMGLog::OutFormat(
+        RMGLog::detail,
+        "Thinning scintillation photons by a factor {}",
+        fOpticalScintillationThinning
+    );
+    auto scint_proc_wrapped = new RMGOpScintillationProcess(fOpticalScintillationThinning);
+    scint_proc_wrapped->RegisterProcess(scint_proc);
+    scint_proc = scint_proc_wrapped;
+  }
 
   // optical processes
   auto absorption_proc = new G4OpAbsorption();
@@ -408,8 +430,14 @@ void RMGPhysics::ConstructOptical() {
 
   if (fUseOpticalCustomWLS) {
     auto wls_proc_wrapped = new RMGOpWLSProcess();
+    wls_proc_wrapped->SetThinningFactor(fOpticalWLSThinning);
     wls_proc_wrapped->RegisterProcess(wls_proc);
     wls_proc = wls_proc_wrapped;
+  } else if (fOpticalWLSThinning > 1) {
+    RMGLog::Out(
+        RMGLog::warning,
+        "WLS photon thinning is only supported with OpticalPhysicsMaxOneWLSPhoton, ignoring"
+    );
   }
 
   GetParticleIterator()->reset();
@@ -477,6 +505,115 @@ void RMGPhysics::SetCuts() {
         "No special production cuts applied"
     );
   }
+
+  // the geometry (and thus all materials and regions) is only known when initializing the run.
+  if (G4StateManager::GetStateManager()->GetCurrentState() == G4State_Init) {
+    this->ConfigurePhysicsTableCache();
+  }
+}
+
+std::string RMGPhysics::GetPhysicsTableCacheKey() const {
+
+  std::ostringstream key;
+  key.precision(17);
+
+  key << "geant4 " << G4VERSION_NUMBER << " " << G4Version << "\n";
+  key << "remage " << RMG_PROJECT_VERSION_FULL << "\n";
+  // the data set versions are part of the default paths.
+  for (const auto* var : {"G4LEDATA", "G4LEVELGAMMADATA", "G4NEUTRONHPDATA", "G4PARTICLEXSDATA"}) {
+    const char* value = std::getenv(var);
+    key << var << " " << (value ? value : "") << "\n";
+  }
+
+  key << "em " << RMGTools::GetCandidate(fLowEnergyEMOption) << "\n";
+  key << "hadronic " << RMGTools::GetCandidate(fHadronicPhysicsListOption) << "\n";
+  key << "optical " << fConstructOptical << " " << fUseOpticalCustomWLS << " "
+      << fOpticalScintillationThinning << " " << fOpticalWLSThinning << "\n";
+  key << "neutron " << fUseNeutronThermalScattering << " " << fUseGrabmayrGammaCascades << "\n";
+  key << "ib " << fUseInnerBremsstrahlung << "\n";
+  key << "range " << fLowEnergyRange << " " << fHighEnergyRange << "\n";
+  // all settings from /process/em/ and /process/optical/ commands.
+  G4EmParameters::Instance()->StreamInfo(key);
+  if (fConstructOptical) G4OpticalParameters::Instance()->StreamInfo(key);
+
+  for (const auto* mat : *G4Material::GetMaterialTable()) {
+    key << "material " << mat->GetName() << " " << mat->GetDensity() << " " << mat->GetState()
+        << " " << mat->GetTemperature() << " " << mat->GetPressure() << " "
+        << mat->GetIonisation()->GetMeanExcitationEnergy() << "\n";
+    for (size_t i = 0; i < mat->GetNumberOfElements(); i++) {
+      const auto* el = mat->GetElement(i);
+      key << "  " << el->GetName() << " " << el->GetZ() << " " << el->GetN() << " " << el->GetA()
+          << " " << mat->GetFractionVector()[i] << "\n";
+    }
+  }
+
+  key << "cut default " << G4VUserPhysicsList::defaultCutValue << "\n";
+  for (const auto* region : *G4RegionStore::GetInstance()) {
+    key << "region " << region->GetName();
+    const auto* cuts = region->GetProductionCuts();
+    if (cuts) {
+      for (const auto* particle : {"gamma", "e-", "e+", "proton"}) {
+        key << " " << cuts->GetProductionCut(particle);
+      }
+    }
+    key << "\n";
+  }
+
+  return key.str();
+}
+
+void RMGPhysics::ConfigurePhysicsTableCache() {
+
+  fStorePhysicsTableCache = false;
+  if (fPhysicsTableCacheDir.empty()) return;
+
+  const auto key = GetPhysicsTableCacheKey();
+  const auto path = fs::path(fPhysicsTableCacheDir) / RMGTools::HashString(key);
+  fPhysicsTableCachePath = path.string();
+
+  // the marker file is only written after all tables have been stored.
+  if (fs::exists(path / "complete")) {
+    RMGLog::Out(RMGLog::detail, "Retrieving physics tables from cache ", path.string());
+    this->SetPhysicsTableRetrieved(path.string());
+  } else {
+    RMGLog::Out(RMGLog::detail, "Physics tables not cached yet, storing them in ", path.string());
+    this->ResetPhysicsTableRetrieved();
+    fStorePhysicsTableCache = true;
+  }
+}
+
+void RMGPhysics::StorePhysicsTableCache() {
+
+  if (!fStorePhysicsTableCache) return;
+  fStorePhysicsTableCache = false;
+
+  const fs::path path(fPhysicsTableCachePath);
+  // another job might have stored the same tables in the meantime.
+  if (fs::exists(path / "complete")) return;
+
+  std::error_code ec;
+  const auto tmp_path = path.parent_path() /
+                        (path.filename().string() + ".tmp" + std::to_string(::getpid()));
+  fs::create_directories(tmp_path, ec);
+  if (ec) {
+    RMGLog::Out(RMGLog::warning, "Could not create physics table cache directory: ", ec.message());
+    return;
+  }
+
+  RMGLog::Out(RMGLog::detail, "Storing physics tables in cache ", path.string());
+  if (!this->StorePhysicsTable(tmp_path.string())) {
+    RMGLog::Out(RMGLog::warning, "Could not store the physics tables in the cache");
+    fs::remove_all(tmp_path, ec);
+    return;
+  }
+
+  // store the key next to the tables, to be able to debug hash collisions.
+  std::ofstream(tmp_path / "key.txt") << GetPhysicsTableCacheKey();
+  std::ofstream(tmp_path / "complete").flush();
+
+  // this fails if another job has moved its tables there first, which is fine.
+  fs::rename(tmp_path, path, ec);
+  if (ec) fs::remove_all(tmp_path, ec);
 }
 
 void RMGPhysics::SetSensitiveProductionCut(double cut) {
@@ -618,6 +755,25 @@ void RMGPhysics::DefineCommands() {
       .SetDefaultValue("true")
       .SetStates(G4State_PreInit);
 
+  fMessenger->DeclareProperty("OpticalPhysicsScintillationThinning", fOpticalScintillationThinning)
+      .SetGuidance("Only emit one out of k scintillation photons, with a statistical weight of k.")
+      .SetGuidance(
+          "note: the photon weights are stored in the optical detector output. The mean number "
+          "of detected photons is unbiased, but their fluctuations are increased."
+      )
+      .SetParameterName("k", false)
+      .SetRange("k >= 1")
+      .SetStates(G4State_PreInit);
+
+  fMessenger->DeclareProperty("OpticalPhysicsWLSThinning", fOpticalWLSThinning)
+      .SetGuidance(
+          "Only emit one out of k wavelength-shifted photons, with a statistical weight of k."
+      )
+      .SetGuidance("note: this requires OpticalPhysicsMaxOneWLSPhoton to be enabled.")
+      .SetParameterName("k", false)
+      .SetRange("k >= 1")
+      .SetStates(G4State_PreInit);
+
   fMessenger->DeclareMethod("LowEnergyEMPhysics", &RMGPhysics::SetLowEnergyEMOptionString)
       .SetGuidance("Add low energy electromagnetic processes to the physics list")
       .SetGuidance(std::string("Uses ") + RMGTools::GetCandidate(fLowEnergyEMOption) + " by default")
@@ -688,6 +844,22 @@ void RMGPhysics::DefineCommands() {
       .SetDefaultValue("true")
       .SetStates(G4State_PreInit);
 
+  fMessenger->DeclareMethod("PhysicsTableCache", &RMGPhysics::SetPhysicsTableCache)
+      .SetGuidance("Directory to cache the built physics tables in, and to retrieve them from.")
+      .SetGuidance(
+          "Tables are cached per physics configuration, i.e. physics list options, electromagnetic "
+          "and optical parameters, materials, production cuts, and Geant4 and remage versions. The "
+          "first job with a configuration stores the tables, later jobs load them instead of "
+          "building them again."
+      )
+      .SetGuidance(
+          "note: Geant4 can only store and retrieve the tables of some processes (mostly "
+          "electromagnetic processes). Other tables are still built in each job."
+      )
+      .SetGuidance("The cache is disabled by default.")
+      .SetParameterName("dir", false)
+      .SetStates(G4State_PreInit);
+
   fMessenger->DeclareMethod("DumpProcessesForParticles", &RMGPhysics::DumpProcessesForParticles)
       .SetGuidance("Dump registered processes for important particles")
       .SetStates(G4State_Idle);
@@ -22,6 +22,7 @@
 #include <random>
 #include <unistd.h>
 
+#include "CLHEP/Units/SystemOfUnits.h"
 #include "G4AnalysisManager.hh"
 #include "G4AnalysisUtilities.hh"
 #include "G4AutoLock.hh"
@@ -31,6 +32,7 @@
 #include "RMGConfig.hh"
 #if RMG_HAS_HDF5
 #include "RMGConvertLH5.hh"
+#include "RMGMergeLH5.hh"
 #endif
 #include "RMGEventAction.hh"
 #include "RMGGermaniumOutputScheme.hh"
@@ -40,7 +42,9 @@
 #include "RMGMasterGenerator.hh"
 #include "RMGOpticalOutputScheme.hh"
 #include "RMGOutputManager.hh"
+#include "RMGPhysics.hh"
 #include "RMGRun.hh"
+#include "RMGTelemetry.hh"
 #include "RMGVGenerator.hh"
 
 G4Run* RMGRunAction::GenerateRun() {
@@ -82,12 +86,31 @@ void RMGRunAction::SetupAnalysisManager() {
   if (RMGLog::GetLogLevel() <= RMGLog::debug) ana_man->SetVerboseLevel(10);
   else ana_man->SetVerboseLevel(0);
 
+  // reshaping steps into hits is implemented as part of the LH5 conversion.
+  auto output_ext = fs::path(rmg_man->GetOutputFileName()).extension();
+  const bool reshape_hits = rmg_man->GetOutputReshapeHits() &&
+                            (output_ext == ".lh5" || output_ext == ".LH5");
+  if (this->IsMaster() && rmg_man->GetOutputReshapeHits()) {
+    // inform downstream consumers about the time window used for reshaping (in us).
+    if (reshape_hits) {
+      RMGIpc::SendIpcNonBlocking(
+          RMGIpc::CreateMessage(
+              "output_reshaped",
+              std::to_string(rmg_man->GetOutputReshapeTimeWindow() / CLHEP::us)
+          )
+      );
+    } else {
+      RMGLog::Out(RMGLog::warning, "Reshaping hits is only supported for LH5 output, ignoring.");
+    }
+  }
+
   // do it only for activated detectors
   for (const auto& oscheme : det_cons->GetAllActiveOutputSchemes()) {
     fOutputDataFields.emplace_back(oscheme);
 
     oscheme->SetNtuplePerDetector(rmg_man->GetOutputNtuplePerDetector());
     oscheme->SetNtupleUseVolumeName(rmg_man->GetOutputNtupleUseVolumeName());
+    oscheme->SetReshapeHits(reshape_hits, rmg_man->GetOutputReshapeTimeWindow());
     oscheme->AssignOutputNames(ana_man);
   }
 }
@@ -121,7 +144,6 @@ void RMGRunAction::BeginOfRunAction(const G4Run*) {
     }
 
     auto ana_man = G4AnalysisManager::Instance();
-    auto fn = fCurrentOutputFile.tmp.string();
 
     // ntuple merging is only supported for some file types. Unfortunately, the function to
     // check for this capability is private, so we have to replicate this here. Also it can only be
@@ -132,30 +154,39 @@ void RMGRunAction::BeginOfRunAction(const G4Run*) {
       ana_man->SetNtupleMerging(!RMGManager::Instance()->IsExecSequential());
     }
 
-    if (this->IsMaster()) {
-      std::string orig_fn;
-      if (fCurrentOutputFile.tmp != fCurrentOutputFile.original)
-        orig_fn = " (for " + fCurrentOutputFile.original.string() + ")";
-      RMGLog::Out(RMGLog::summary, "Opening output file: ", fn, orig_fn);
+    if (this->IsMaster() && rmg_man->GetOutputMergeThreadFiles() && !IsMergingThreadFiles() &&
+        !RMGManager::Instance()->IsExecSequential()) {
+      RMGLog::Out(
+          RMGLog::warning,
+          "Merging of thread output files is only supported for LH5 output, ignoring."
+      );
     }
-    if (fCurrentOutputFile.tmp != fCurrentOutputFile.original && std::filesystem::exists(fn)) {
-      RMGLog::Out(RMGLog::fatal, "Temporary file ", fn, " already exists?");
+    if (this->IsMaster() && IsMergingThreadFiles()) {
+      // the worker threads will append to this file, so it must not contain any stale data.
+      if (fs::exists(fCurrentOutputFile.original)) fs::remove(fCurrentOutputFile.original);
+      RMGLog::Out(
+          RMGLog::detail,
+          "Worker threads will append their output to ",
+          fCurrentOutputFile.original.string()
+      );
     }
 
-    // notify wrapper about temp files created on master or worker threads.
+    // rotating output files relies on the per-thread files being converted to LH5.
     auto orig_file_type = fCurrentOutputFile.original.extension();
-    if (fCurrentOutputFile.tmp != fCurrentOutputFile.original &&
-        (orig_file_type == ".lh5" || orig_file_type == ".LH5")) {
-      auto worker_tmp = GetWorkerTmpPath(fCurrentOutputFile.tmp, "hdf5");
-      RMGIpc::SendIpcNonBlocking(RMGIpc::CreateMessage("tmpfile", worker_tmp));
+    fIsRotatingOutputFiles = rmg_man->HasOutputFileLimits() &&
+                             (orig_file_type == ".lh5" || orig_file_type == ".LH5");
+    if (this->IsMaster() && rmg_man->HasOutputFileLimits() && !fIsRotatingOutputFiles) {
+      RMGLog::Out(
+          RMGLog::warning,
+          "Output file limits are only supported for LH5 output, ignoring."
+      );
     }
+    fRotateOutputFile = false;
+    fOutputFileIndex = 0;
+    fEventsInCurrentFile = 0;
+    fEventsInClosedFiles = 0;
 
-    auto success = ana_man->OpenFile(fn);
-
-    // If opening failed, disable persistency.
-    if (!success) {
-      if (this->IsMaster()) RMGLog::Out(RMGLog::fatal, "Failed opening output file ", fn);
-    }
+    this->OpenOutputFile();
   }
 
   if (!fIsPersistencyEnabled && this->IsMaster()) {
@@ -168,6 +199,18 @@ void RMGRunAction::BeginOfRunAction(const G4Run*) {
     RMGLog::Out(level, "Object persistency disabled");
   }
 
+  // the events are only split into tasks after this action on the master thread.
+  if (this->IsMaster()) {
+    RMGManager::Instance()->ConfigureTasking(fRMGRun->GetNumberOfEventToBeProcessed());
+  }
+
+  // the physics tables have been built on the master before the run starts. Only one process
+  // needs to store them.
+  if (this->IsMaster() && RMGManager::Instance()->GetProcessNumberOffset() == 0) {
+    auto physics = dynamic_cast<RMGPhysics*>(RMGManager::Instance()->GetProcessesList());
+    if (physics) physics->StorePhysicsTableCache();
+  }
+
   if (fRMGMasterGenerator) {
     if (fRMGMasterGenerator->GetVertexGenerator()) {
       fRMGMasterGenerator->GetVertexGenerator()->BeginOfRunAction(fRMGRun);
@@ -179,6 +222,9 @@ void RMGRunAction::BeginOfRunAction(const G4Run*) {
 
   // save start time for future
   fRMGRun->SetStartTime(std::chrono::system_clock::now());
+  if (IsEventProcessingThread()) {
+    RMGTelemetry::BeginOfRun(fRMGRun->GetRunID(), fRMGRun->GetNumberOfEventToBeProcessed());
+  }
 
   if (this->IsMaster()) {
     const time_t start_time = std::chrono::system_clock::to_time_t(fRMGRun->GetStartTime());
@@ -205,8 +251,10 @@ void RMGRunAction::BeginOfRunAction(const G4Run*) {
   if (fCurrentPrintModulo <= 0 and tot_events >= 100) fCurrentPrintModulo = tot_events / 10;
   else if (tot_events < 100) fCurrentPrintModulo = 100;
 
+  // with dynamic event distribution, the offset is set for each batch of events.
   int proc_num = RMGManager::Instance()->GetProcessNumberOffset();
-  for (auto& oscheme : fOutputDataFields) { oscheme->SetEventIDOffset(proc_num * tot_events); }
+  if (RMGManager::Instance()->IsDynamicEventDistribution()) proc_num = 0;
+  SetEventIDOffset(proc_num * tot_events);
 }
 
 void RMGRunAction::EndOfRunAction(const G4Run*) {
@@ -230,7 +278,8 @@ void RMGRunAction::EndOfRunAction(const G4Run*) {
         n_ev,
         *::localtime_r(&end_time, &local_end_time)
     );
-    if (n_ev != n_ev_requested) {
+    // with dynamically distributed events, each process only simulates a part of the events.
+    if (n_ev != n_ev_requested && !RMGManager::Instance()->IsDynamicEventDistribution()) {
       RMGLog::OutFormat(
           RMGLog::warning,
           "Run nr. {:d} only simulated {:d} events, out of {:d} events requested!",
@@ -287,18 +336,121 @@ void RMGRunAction::EndOfRunAction(const G4Run*) {
   for (const auto& oscheme : oschemes) { oscheme->EndOfRunAction(fRMGRun); }
 
   if (fIsPersistencyEnabled) {
-    G4AnalysisManager::Instance()->Write();
-    G4AnalysisManager::Instance()->CloseFile();
+    this->CloseOutputFile();
+
+    // previous output files of this run already contain their share of the events.
+    PostprocessOutputFile(n_ev - fEventsInClosedFiles);
+  }
+
+  // the final report includes the bytes written when closing the output file.
+  if (IsEventProcessingThread()) RMGTelemetry::EndOfRun();
+  // do not hold back the messages of this run until the next one.
+  RMGIpc::Flush();
+}
+
+bool RMGRunAction::IsEventProcessingThread() const {
+  return !this->IsMaster() || RMGManager::Instance()->IsExecSequential();
+}
+
+void RMGRunAction::OpenOutputFile() {
+  auto ana_man = G4AnalysisManager::Instance();
+  auto fn = fCurrentOutputFile.tmp.string();
+
+  if (this->IsMaster()) {
+    std::string orig_fn;
+    if (fCurrentOutputFile.tmp != fCurrentOutputFile.original)
+      orig_fn = " (for " + fCurrentOutputFile.original.string() + ")";
+    RMGLog::Out(RMGLog::summary, "Opening output file: ", fn, orig_fn);
+  }
+  if (fCurrentOutputFile.tmp != fCurrentOutputFile.original && std::filesystem::exists(fn)) {
+    RMGLog::Out(RMGLog::fatal, "Temporary file ", fn, " already exists?");
+  }
+
+  // notify wrapper about temp files created on master or worker threads.
+  auto orig_file_type = fCurrentOutputFile.original.extension();
+  if (fCurrentOutputFile.tmp != fCurrentOutputFile.original &&
+      (orig_file_type == ".lh5" || orig_file_type == ".LH5")) {
+    auto worker_tmp = GetWorkerTmpPath(fCurrentOutputFile.tmp, "hdf5");
+    RMGIpc::SendIpcNonBlocking(RMGIpc::CreateMessage("tmpfile", worker_tmp));
+  }
+
+  auto success = ana_man->OpenFile(fn);
+
+  // If opening failed, disable persistency.
+  if (!success) {
+    if (this->IsMaster()) RMGLog::Out(RMGLog::fatal, "Failed opening output file ", fn);
+  }
+  if (IsEventProcessingThread()) {
+    RMGTelemetry::SetOutputFile(
+        GetWorkerTmpPath(fCurrentOutputFile.tmp, fCurrentOutputFile.tmp.extension().string())
+    );
+  }
+
+  for (const auto& oscheme : GetAllOutputDataFields()) oscheme->BeginOfOutputFile();
+}
+
+void RMGRunAction::CloseOutputFile() {
+  for (const auto& oscheme : GetAllOutputDataFields()) oscheme->EndOfOutputFile();
+
+  auto ana_man = G4AnalysisManager::Instance();
+  ana_man->Write();
+  ana_man->CloseFile();
+  if (IsEventProcessingThread()) RMGTelemetry::CloseOutputFile();
+}
+
+void RMGRunAction::CheckOutputFileLimits() {
+  if (!fIsPersistencyEnabled || !fIsRotatingOutputFiles) return;
+
+  fEventsInCurrentFile++;
+
+  auto rmg_man = RMGOutputManager::Instance();
+  auto max_events = rmg_man->GetOutputMaxEventsPerFile();
+  if (max_events > 0 && fEventsInCurrentFile >= max_events) {
+    fRotateOutputFile = true;
+    return;
+  }
 
-    PostprocessOutputFile(n_ev);
+  // note: this is only the size on disk, the analysis manager might still buffer some rows.
+  auto max_bytes = rmg_man->GetOutputMaxBytesPerFile();
+  if (max_bytes > 0) {
+    std::error_code ec;
+    auto size = fs::file_size(GetWorkerTmpPath(fCurrentOutputFile.tmp, "hdf5"), ec);
+    if (!ec && static_cast<double>(size) >= max_bytes) fRotateOutputFile = true;
   }
 }
 
+void RMGRunAction::RotateOutputFileIfRequested() {
+  // rotate only at the start of the next event, so that no empty file is left at the end of the
+  // run.
+  if (!fRotateOutputFile) return;
+  fRotateOutputFile = false;
+
+  RMGLog::Out(
+      RMGLog::detail,
+      "Output file limit reached after ",
+      fEventsInCurrentFile,
+      " events, rotating output file ",
+      fCurrentOutputFile.original.string()
+  );
+
+  // the auxiliary tables (i.e. process or detector origin maps) are written into each file, they
+  // are deduplicated when merging the files.
+  this->CloseOutputFile();
+
+  // this converts the file and announces it to the wrapper, so that it can already be processed.
+  PostprocessOutputFile(fEventsInCurrentFile);
+  fEventsInClosedFiles += fEventsInCurrentFile;
+  fEventsInCurrentFile = 0;
+
+  fCurrentOutputFile = BuildOutputFile(++fOutputFileIndex);
+  this->OpenOutputFile();
+}
+
 // Geant4 cannot handle LH5 files by default, and there is also no way to teach it another file
 // extension. So if the user specifies a LH5 file as output, we have to create a temporary file
 // with a hdf5 extensions. Later, we will rename it.
 
-RMGRunAction::OutputFilePaths RMGRunAction::BuildOutputFile() const {
+RMGRunAction::OutputFilePaths RMGRunAction::BuildOutputFile(int file_index) const {
   auto rmg_man = RMGOutputManager::Instance();
 
   if (!rmg_man->HasOutputFileName()) { RMGLog::OutDev(RMGLog::fatal, "tried to open file 'none'"); }
@@ -312,6 +464,13 @@ RMGRunAction::OutputFilePaths RMGRunAction::BuildOutputFile() const {
         std::to_string(RMGManager::Instance()->GetProcessNumberOffset()) + path.extension().string()
     );
   }
+  // rotated output files get a running suffix. When merging the thread files, all output files
+  // are appended to the same output file instead.
+  if (file_index > 0 && !IsMergingThreadFiles()) {
+    path = path.replace_filename(
+        path.stem().string() + "_f" + std::to_string(file_index) + path.extension().string()
+    );
+  }
   auto path_for_overwrite = fs::path(GetWorkerTmpPath(path, path.extension().string()));
   if (fs::exists(path_for_overwrite) && !rmg_man->GetOutputOverwriteFiles()) {
     RMGLog::Out(RMGLog::fatal, "Output file ", path_for_overwrite.string(), " does already exists.");
@@ -353,13 +512,22 @@ void RMGRunAction::PostprocessOutputFile([[maybe_unused]] int number_of_primarie
     );
   }
 
+  // the worker threads already appended their output to the single output file.
+  const bool merge_thread_files = IsMergingThreadFiles();
+  if (this->IsMaster() && merge_thread_files) {
+    if (fs::exists(fCurrentOutputFile.original)) {
+      RMGIpc::SendIpcNonBlocking(RMGIpc::CreateMessage("output", fCurrentOutputFile.original));
+    }
+    return;
+  }
+
   // HDF5 C++ might not be thread-safe?
   G4AutoLock l(&RMGConvertLH5Mutex);
 
   auto worker_tmp = GetWorkerTmpPath(fCurrentOutputFile.tmp, "hdf5");
   auto worker_lh5 = GetWorkerTmpPath(fCurrentOutputFile.original, "lh5");
 
-  if (fs::exists(worker_tmp)) {
+  if (fs::exists(worker_tmp) && !merge_thread_files) {
     RMGIpc::SendIpcNonBlocking(RMGIpc::CreateMessage("output", worker_lh5));
   }
 
@@ -385,7 +553,8 @@ void RMGRunAction::PostprocessOutputFile([[maybe_unused]] int number_of_primarie
       rmg_man->GetNtupleIDs(),
       false,
       false,
-      number_of_primaries
+      number_of_primaries,
+      rmg_man->GetOutputEventIndex()
   );
   if (!result) {
     RMGLog::Out(
@@ -396,6 +565,38 @@ void RMGRunAction::PostprocessOutputFile([[maybe_unused]] int number_of_primarie
     );
     return;
   }
+
+  if (merge_thread_files) {
+    // append to the single output file. This is still protected by the mutex above, so that
+    // the rows of the different worker threads do not interleave.
+    auto merge_result = RMGMergeLH5::AppendToLH5(
+        worker_tmp.string(),
+        fCurrentOutputFile.original.string(),
+        rmg_man->GetDeduplicatedNtupleNames()
+    );
+    if (merge_result) {
+      fs::remove(worker_tmp);
+      RMGLog::Out(
+          RMGLog::detail,
+          "Appended output file ",
+          worker_tmp.string(),
+          " to ",
+          fCurrentOutputFile.original.string()
+      );
+      return;
+    }
+    // keep the per-thread file, so that no data is lost.
+    RMGLog::Out(
+        RMGLog::error,
+        "Appending output file ",
+        worker_tmp.string(),
+        " to ",
+        fCurrentOutputFile.original.string(),
+        " failed. Keeping the thread-specific output file ",
+        worker_lh5.string()
+    );
+    RMGIpc::SendIpcNonBlocking(RMGIpc::CreateMessage("output", worker_lh5));
+  }
 #else
   RMGLog::OutDev(RMGLog::fatal, "HDF5 and LH5 support is not available!");
 #endif
@@ -416,6 +617,12 @@ void RMGRunAction::PostprocessOutputFile([[maybe_unused]] int number_of_primarie
   }
 }
 
+bool RMGRunAction::IsMergingThreadFiles() const {
+  auto ext = fCurrentOutputFile.original.extension();
+  return RMGOutputManager::Instance()->GetOutputMergeThreadFiles() &&
+         !RMGManager::Instance()->IsExecSequential() && (ext == ".lh5" || ext == ".LH5");
+}
+
 fs::path RMGRunAction::GetWorkerTmpPath(fs::path path, std::string extension) const {
   return {G4Analysis::GetTnFileName(path.string(), extension)};
 }
@@ -17,6 +17,7 @@
 
 #include <memory>
 #include <set>
+#include <vector>
 
 #include "G4AnalysisManager.hh"
 #include "G4Event.hh"
@@ -110,6 +111,7 @@ void RMGScintillatorOutputScheme::AssignOutputNames(G4AnalysisManager* ana_man)
       CreateNtupleFOrDColumn(ana_man, id, "v_pre_in_m\\ns", fStoreSinglePrecisionPosition);
       CreateNtupleFOrDColumn(ana_man, id, "v_post_in_m\\ns", fStoreSinglePrecisionPosition);
     }
+    if (fReshapeHits) ana_man->CreateNtupleIColumn(id, fHitStartColumnName);
     ana_man->FinishNtuple(id);
   }
 }
@@ -191,11 +193,14 @@ void RMGScintillatorOutputScheme::StoreEvent(const G4Event* event) {
     RMGLog::OutDev(RMGLog::debug_event, "Filling persistent data vectors");
     const auto ana_man = G4AnalysisManager::Instance();
 
+    std::vector<OrderedStep<RMGDetectorHit>> steps;
     for (auto hit : *hit_coll->GetVector()) {
       if (!hit or (hit->energy_deposition == 0 and this->fDiscardZeroEnergyHits)) continue;
-      hit->Print();
+      steps.push_back({hit, rmg_man->GetNtupleID(hit->detector_uid), false});
+    }
 
-      auto ntupleid = rmg_man->GetNtupleID(hit->detector_uid);
+    for (const auto& [hit, ntupleid, hit_start] : OrderStepsIntoHits(std::move(steps))) {
+      hit->Print();
 
       int col_id = 0;
       ana_man->FillNtupleIColumn(ntupleid, col_id++, GetEventIDForStorage(event));
@@ -313,6 +318,7 @@ void RMGScintillatorOutputScheme::StoreEvent(const G4Event* event) {
             fStoreSinglePrecisionPosition
         );
       }
+      if (fReshapeHits) ana_man->FillNtupleIColumn(ntupleid, col_id++, hit_start);
       // NOTE: must be called here for hit-oriented output
       ana_man->AddNtupleRow(ntupleid);
     }
@@ -25,6 +25,7 @@
 #include "RMGLog.hh"
 #include "RMGManager.hh"
 #include "RMGRunAction.hh"
+#include "RMGTelemetry.hh"
 
 RMGSteppingAction::RMGSteppingAction(RMGRunAction* run_action) : fRunAction(run_action) {
   this->DefineCommands();
@@ -32,6 +33,8 @@ RMGSteppingAction::RMGSteppingAction(RMGRunAction* run_action) : fRunAction(run_
 
 void RMGSteppingAction::UserSteppingAction(const G4Step* step) {
 
+  RMGTelemetry::CountStep();
+
   if (fSkipTracking || (fKillSecondaries && step->GetTrack()->GetParentID() > 0)) {
     step->GetTrack()->SetTrackStatus(fKillTrackAndSecondaries);
     return;
@@ -0,0 +1,106 @@
+// Copyright (C) 2026
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "RMGTelemetry.hh"
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <system_error>
+
+#include <unistd.h>
+
+#include "fmt/format.h"
+
+#include "RMGIpc.hh"
+
+namespace {
+
+  // the resident memory is shared by all threads of the process.
+  uint64_t ProcessResidentBytes() {
+    std::ifstream statm("/proc/self/statm");
+    uint64_t size = 0, resident = 0;
+    if (!(statm >> size >> resident)) return 0;
+    return resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+  }
+
+} // namespace
+
+void RMGTelemetry::SetOutputFile(const fs::path& file) { fOutputFile = file; }
+
+void RMGTelemetry::CloseOutputFile() {
+  fClosedOutputBytes += OutputFileBytes();
+  fOutputFile.clear();
+}
+
+uint64_t RMGTelemetry::OutputFileBytes() {
+  if (fOutputFile.empty()) return 0;
+  // note: this is only the size on disk, the analysis manager might still buffer some rows.
+  std::error_code ec;
+  const auto size = fs::file_size(fOutputFile, ec);
+  return ec ? 0 : size;
+}
+
+void RMGTelemetry::BeginOfRun(int run_id, int n_events) {
+  fActive = fIntervalSeconds > 0 && RMGIpc::IsEnabled();
+  fRunID = run_id;
+  fRunEvents = n_events;
+  fEvents = 0;
+  fSteps = 0;
+  fClosedOutputBytes = 0;
+  fStartTime = fLastSent = std::chrono::steady_clock::now();
+}
+
+void RMGTelemetry::EndOfEvent() {
+  if (!fActive) return;
+  fEvents++;
+
+  const auto now = std::chrono::steady_clock::now();
+  if (std::chrono::duration<double>(now - fLastSent).count() < fIntervalSeconds) return;
+  fLastSent = now;
+  Send(false);
+}
+
+void RMGTelemetry::EndOfRun() {
+  if (!fActive) return;
+  Send(true);
+  fActive = false;
+}
+
+void RMGTelemetry::Send(bool final) {
+  const double elapsed =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - fStartTime).count();
+
+  // thread, run, events to process in this process, events, steps, seconds, bytes, rss, final.
+  RMGIpc::SendIpcNonBlocking(RMGIpc::CreateMessage(
+      "telemetry",
+      fmt::format(
+          "{}\x1f{}\x1f{}\x1f{}\x1f{}\x1f{:.3f}\x1f{}\x1f{}\x1f{:d}",
+          std::max(G4Threading::G4GetThreadId(), 0),
+          fRunID,
+          fRunEvents,
+          fEvents,
+          fSteps,
+          elapsed,
+          fClosedOutputBytes + OutputFileBytes(),
+          ProcessResidentBytes(),
+          final
+      )
+  ));
+  // the reports are rate-limited, and should reach the wrapper without delay.
+  RMGIpc::Flush();
+}
+
+// vim: tabstop=2 shiftwidth=2 expandtab
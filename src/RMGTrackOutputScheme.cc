@@ -15,13 +15,18 @@
 
 #include "RMGTrackOutputScheme.hh"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 #include "G4AnalysisManager.hh"
 #include "G4Event.hh"
 #include "G4EventManager.hh"
 #include "G4OpticalPhoton.hh"
 #include "G4RunManager.hh"
+#include "G4UnitsTable.hh"
+#include "G4VProcess.hh"
 
-#include "RMGIpc.hh"
 #include "RMGLog.hh"
 #include "RMGOutputManager.hh"
 #include "RMGStackingAction.hh"
@@ -36,18 +41,31 @@ void RMGTrackOutputScheme::AssignOutputNames(G4AnalysisManager* ana_man) {
                  ->CreateAndRegisterAuxNtuple("tracks", "RMGTrackOutputScheme", ana_man);
 
   ana_man->CreateNtupleIColumn(vid, "evtid");
-  ana_man->CreateNtupleIColumn(vid, "trackid");
-  ana_man->CreateNtupleIColumn(vid, "parent_trackid");
+  if (fCompactEncoding) {
+    ana_man->CreateNtupleIColumn(vid, "trackid_delta");
+    ana_man->CreateNtupleIColumn(vid, "parent_trackid_delta");
+  } else {
+    ana_man->CreateNtupleIColumn(vid, "trackid");
+    ana_man->CreateNtupleIColumn(vid, "parent_trackid");
+  }
   ana_man->CreateNtupleIColumn(vid, "procid");
   ana_man->CreateNtupleIColumn(vid, "particle");
   ana_man->CreateNtupleDColumn(vid, "time_in_ns");
-  CreateNtupleFOrDColumn(ana_man, vid, "xloc_in_m", fStoreSinglePrecisionPosition);
-  CreateNtupleFOrDColumn(ana_man, vid, "yloc_in_m", fStoreSinglePrecisionPosition);
-  CreateNtupleFOrDColumn(ana_man, vid, "zloc_in_m", fStoreSinglePrecisionPosition);
-  CreateNtupleFOrDColumn(ana_man, vid, "px_in_MeV", fStoreSinglePrecisionEnergy);
-  CreateNtupleFOrDColumn(ana_man, vid, "py_in_MeV", fStoreSinglePrecisionEnergy);
-  CreateNtupleFOrDColumn(ana_man, vid, "pz_in_MeV", fStoreSinglePrecisionEnergy);
-  CreateNtupleFOrDColumn(ana_man, vid, "ekin_in_MeV", fStoreSinglePrecisionEnergy);
+  if (fCompactEncoding) {
+    // the values are stored as integer multiples of the precision, i.e. the unit.
+    for (const auto& col : {"xloc", "yloc", "zloc"})
+      ana_man->CreateNtupleIColumn(vid, std::string(col) + "_in_" + fPositionPrecisionUnit);
+    for (const auto& col : {"px", "py", "pz", "ekin"})
+      ana_man->CreateNtupleIColumn(vid, std::string(col) + "_in_" + fEnergyPrecisionUnit);
+  } else {
+    CreateNtupleFOrDColumn(ana_man, vid, "xloc_in_m", fStoreSinglePrecisionPosition);
+    CreateNtupleFOrDColumn(ana_man, vid, "yloc_in_m", fStoreSinglePrecisionPosition);
+    CreateNtupleFOrDColumn(ana_man, vid, "zloc_in_m", fStoreSinglePrecisionPosition);
+    CreateNtupleFOrDColumn(ana_man, vid, "px_in_MeV", fStoreSinglePrecisionEnergy);
+    CreateNtupleFOrDColumn(ana_man, vid, "py_in_MeV", fStoreSinglePrecisionEnergy);
+    CreateNtupleFOrDColumn(ana_man, vid, "pz_in_MeV", fStoreSinglePrecisionEnergy);
+    CreateNtupleFOrDColumn(ana_man, vid, "ekin_in_MeV", fStoreSinglePrecisionEnergy);
+  }
   if (fStoreStageID) { ana_man->CreateNtupleIColumn(vid, "stageid"); }
 
   ana_man->FinishNtuple(vid);
@@ -57,36 +75,25 @@ void RMGTrackOutputScheme::AssignOutputNames(G4AnalysisManager* ana_man) {
   ana_man->CreateNtupleIColumn(pid, "procid");
   ana_man->CreateNtupleSColumn(pid, "name");
   ana_man->FinishNtuple(pid);
-  RMGIpc::SendIpcNonBlocking(RMGIpc::CreateMessage("output_ntuple_deduplicate", "processes"));
+  RMGOutputManager::Instance()->RegisterNtupleDeduplication("processes");
 }
 
-void RMGTrackOutputScheme::TrackingActionPre(const G4Track* track) {
-  auto rmg_man = RMGOutputManager::Instance();
-  if (!rmg_man->IsPersistencyEnabled()) return;
-
-  // do not write tracks of optical photons if not specifically instructed (there will be many).
-  if (track->GetDefinition() == G4OpticalPhoton::OpticalPhotonDefinition() && !fStoreOpticalPhotons) {
-    return;
-  }
-
-  auto pos = track->GetPosition();
-  auto primary = track->GetDynamicParticle();
-  auto proc = track->GetCreatorProcess();
+// the process objects live for the whole application lifetime, so their information can be cached
+// by pointer. The process name and hash only need to be computed for the first track of each
+// process.
+const RMGTrackOutputScheme::RMGProcessInfo& RMGTrackOutputScheme::GetProcessInfo(
+    const G4VProcess* proc
+) {
+  auto it = fProcessInfoCache.find(proc);
+  if (it != fProcessInfoCache.end()) return it->second;
 
   std::string proc_name;
   if (proc) proc_name = proc->GetProcessName();
 
-  auto write = true;
-  write &= (fFilterProcess.empty() || fFilterProcess.find(proc_name) != fFilterProcess.end());
-  write &=
-      (fFilterParticle.empty() ||
-       fFilterParticle.find(primary->GetPDGcode()) != fFilterParticle.end());
-  write &= (fFilterEnergy == -1 || track->GetKineticEnergy() >= fFilterEnergy);
-  if (!write) return;
-
   int proc_id = -1;
   if (proc) {
-    if (fProcessMap.find(proc_name) == fProcessMap.end()) {
+    auto map_it = fProcessMap.find(proc_name);
+    if (map_it == fProcessMap.end()) {
       // The following lines are a FNV-1a hash function (based on the CC0 licensed algorithm)
       // see https://en.wikipedia.org/wiki/Fowler%E2%80%93Noll%E2%80%93Vo_hash_function
       // and http://www.isthe.com/chongo/tech/comp/fnv/index.html for details.
@@ -97,25 +104,68 @@ void RMGTrackOutputScheme::TrackingActionPre(const G4Track* track) {
       }
       // xor-fold down to 16 bit.
       proc_name_hash = (proc_name_hash >> 16) ^ (proc_name_hash & (uint32_t)0xffff);
-      fProcessMap.emplace(proc_name, proc_name_hash);
+      map_it = fProcessMap.emplace(proc_name, proc_name_hash).first;
     }
-    proc_id = static_cast<int>(fProcessMap[proc_name]);
+    proc_id = static_cast<int>(map_it->second);
   }
 
+  bool pass_filter = fFilterProcess.empty() ||
+                     fFilterProcess.find(proc_name) != fFilterProcess.end();
+  return fProcessInfoCache.emplace(proc, RMGProcessInfo{proc_id, pass_filter}).first->second;
+}
+
+void RMGTrackOutputScheme::TrackingActionPre(const G4Track* track) {
+  auto rmg_man = RMGOutputManager::Instance();
+  if (!rmg_man->IsPersistencyEnabled()) return;
+
+  // do not write tracks of optical photons if not specifically instructed (there will be many).
+  if (track->GetDefinition() == G4OpticalPhoton::OpticalPhotonDefinition() && !fStoreOpticalPhotons) {
+    return;
+  }
+
+  // the depth has to be recorded for all tracks, also for those that are not stored. The parent
+  // track is always tracked before its secondaries. The track IDs are consecutive within the
+  // event, so the depths can be indexed by the track ID.
+  if (fMaxTreeDepth >= 0) {
+    const auto track_id = static_cast<size_t>(track->GetTrackID());
+    const auto parent_id = static_cast<size_t>(track->GetParentID());
+    int depth = 0;
+    if (parent_id < fTrackDepths.size() && fTrackDepths[parent_id] >= 0) {
+      depth = fTrackDepths[parent_id] + 1;
+    }
+    if (track_id >= fTrackDepths.size()) fTrackDepths.resize(track_id + 1, -1);
+    fTrackDepths[track_id] = depth;
+    if (depth > fMaxTreeDepth) return;
+  }
+
+  auto pos = track->GetPosition();
+  auto primary = track->GetDynamicParticle();
+  const auto& proc_info = GetProcessInfo(track->GetCreatorProcess());
+
+  auto write = proc_info.pass_filter;
+  write &=
+      (fFilterParticle.empty() ||
+       fFilterParticle.find(primary->GetPDGcode()) != fFilterParticle.end());
+  write &= (fFilterEnergy == -1 || track->GetKineticEnergy() >= fFilterEnergy);
+  if (!write) return;
+
   int stage_id = 0;
   if (fStoreStageID) {
-    if (const auto stackAction = dynamic_cast<const RMGStackingAction*>(
-            G4RunManager::GetRunManager()->GetUserStackingAction()
-        )) {
-      stage_id = stackAction->GetCurrentStage();
+    // the user actions do not change during the run, so the stacking action can be looked up once.
+    if (!fStackingActionResolved) {
+      fStackingAction = dynamic_cast<const RMGStackingAction*>(
+          G4RunManager::GetRunManager()->GetUserStackingAction()
+      );
+      fStackingActionResolved = true;
     }
+    if (fStackingAction) stage_id = fStackingAction->GetCurrentStage();
   }
 
   fTrackEntries.emplace_back(
       GetEventIDForStorage(G4EventManager::GetEventManager()->GetConstCurrentEvent()),
       track->GetTrackID(),
       track->GetParentID(),
-      proc_id,
+      proc_info.proc_id,
       primary->GetPDGcode(),
       track->GetGlobalTime(),
       pos.getX(),
@@ -137,27 +187,48 @@ void RMGTrackOutputScheme::StoreEvent(const G4Event*) {
 
   auto ntupleid = rmg_man->GetAuxNtupleID("tracks");
 
+  int prev_track_id = 0;
   for (const auto& entry : fTrackEntries) {
     int col_id = 0;
     ana_man->FillNtupleIColumn(ntupleid, col_id++, entry.event_id);
-    ana_man->FillNtupleIColumn(ntupleid, col_id++, entry.track_id);
-    ana_man->FillNtupleIColumn(ntupleid, col_id++, entry.parent_id);
+    if (fCompactEncoding) {
+      // the delta to the previous stored track, and the (mostly small) distance to the parent.
+      ana_man->FillNtupleIColumn(ntupleid, col_id++, entry.track_id - prev_track_id);
+      ana_man->FillNtupleIColumn(ntupleid, col_id++, entry.track_id - entry.parent_id);
+      prev_track_id = entry.track_id;
+    } else {
+      ana_man->FillNtupleIColumn(ntupleid, col_id++, entry.track_id);
+      ana_man->FillNtupleIColumn(ntupleid, col_id++, entry.parent_id);
+    }
     ana_man->FillNtupleIColumn(ntupleid, col_id++, entry.proc_id);
     ana_man->FillNtupleIColumn(ntupleid, col_id++, entry.particle_pdg);
     ana_man->FillNtupleDColumn(ntupleid, col_id++, entry.global_time / u::ns);
-    FillNtupleFOrDColumn(ana_man, ntupleid, col_id++, entry.x_position / u::m, fStoreSinglePrecisionPosition);
-    FillNtupleFOrDColumn(ana_man, ntupleid, col_id++, entry.y_position / u::m, fStoreSinglePrecisionPosition);
-    FillNtupleFOrDColumn(ana_man, ntupleid, col_id++, entry.z_position / u::m, fStoreSinglePrecisionPosition);
-    FillNtupleFOrDColumn(ana_man, ntupleid, col_id++, entry.x_momentum / u::MeV, fStoreSinglePrecisionEnergy);
-    FillNtupleFOrDColumn(ana_man, ntupleid, col_id++, entry.y_momentum / u::MeV, fStoreSinglePrecisionEnergy);
-    FillNtupleFOrDColumn(ana_man, ntupleid, col_id++, entry.z_momentum / u::MeV, fStoreSinglePrecisionEnergy);
-    FillNtupleFOrDColumn(
-        ana_man,
-        ntupleid,
-        col_id++,
-        entry.kinetic_energy / u::MeV,
-        fStoreSinglePrecisionEnergy
-    );
+
+    if (fCompactEncoding) {
+      for (double pos : {entry.x_position, entry.y_position, entry.z_position}) {
+        const int value = Quantize(pos, fPositionPrecision, fPositionPrecisionUnit);
+        ana_man->FillNtupleIColumn(ntupleid, col_id++, value);
+      }
+      for (double e :
+           {entry.x_momentum, entry.y_momentum, entry.z_momentum, entry.kinetic_energy}) {
+        const int value = Quantize(e, fEnergyPrecision, fEnergyPrecisionUnit);
+        ana_man->FillNtupleIColumn(ntupleid, col_id++, value);
+      }
+    } else {
+      for (double pos : {entry.x_position, entry.y_position, entry.z_position}) {
+        FillNtupleFOrDColumn(
+            ana_man,
+            ntupleid,
+            col_id++,
+            pos / u::m,
+            fStoreSinglePrecisionPosition
+        );
+      }
+      for (double e :
+           {entry.x_momentum, entry.y_momentum, entry.z_momentum, entry.kinetic_energy}) {
+        FillNtupleFOrDColumn(ana_man, ntupleid, col_id++, e / u::MeV, fStoreSinglePrecisionEnergy);
+      }
+    }
 
     if (fStoreStageID) { ana_man->FillNtupleIColumn(ntupleid, col_id++, entry.stage_id); }
 
@@ -166,10 +237,47 @@ void RMGTrackOutputScheme::StoreEvent(const G4Event*) {
   }
 }
 
-// free the memory of the track entries.
-void RMGTrackOutputScheme::ClearBeforeEvent() { std::vector<RMGTrackEntry>().swap(fTrackEntries); }
+// keep the memory of the track entries for the next event, unless this event was exceptionally
+// large.
+void RMGTrackOutputScheme::ClearBeforeEvent() {
+  if (fTrackEntries.capacity() > fMaxRetainedTrackEntries) {
+    std::vector<RMGTrackEntry>().swap(fTrackEntries);
+  } else {
+    fTrackEntries.clear();
+  }
+  fTrackDepths.clear();
+}
+
+int RMGTrackOutputScheme::Quantize(double value, double precision, const std::string& unit) {
+  const double quantized = std::round(value / precision);
+  constexpr auto min = static_cast<double>(std::numeric_limits<int>::min());
+  constexpr auto max = static_cast<double>(std::numeric_limits<int>::max());
+  if (quantized >= min && quantized <= max) return static_cast<int>(quantized);
+
+  if (!fWarnedQuantizeClamp) {
+    RMGLog::OutFormat(
+        RMGLog::warning,
+        "Value of {} {} is out of range for the compact track encoding and is clamped, choose a "
+        "coarser precision (this warning is only shown once)",
+        quantized,
+        unit
+    );
+    fWarnedQuantizeClamp = true;
+  }
+  return static_cast<int>(std::clamp(quantized, min, max));
+}
+
+void RMGTrackOutputScheme::SetPositionPrecision(std::string unit) {
+  fPositionPrecisionUnit = unit;
+  fPositionPrecision = G4UnitDefinition::GetValueOf(unit);
+}
 
-void RMGTrackOutputScheme::EndOfRunAction(const G4Run*) {
+void RMGTrackOutputScheme::SetEnergyPrecision(std::string unit) {
+  fEnergyPrecisionUnit = unit;
+  fEnergyPrecision = G4UnitDefinition::GetValueOf(unit);
+}
+
+void RMGTrackOutputScheme::EndOfOutputFile() {
   auto rmg_man = RMGOutputManager::Instance();
   if (!rmg_man->IsPersistencyEnabled()) return;
 
@@ -257,6 +365,44 @@ void RMGTrackOutputScheme::DefineCommands() {
       .SetParameterName("boolean", true)
       .SetDefaultValue("true")
       .SetStates(G4State_Idle);
+
+  fMessenger->DeclareProperty("CompactEncoding", fCompactEncoding)
+      .SetGuidance(
+          "Store delta-coded track IDs, and positions, momenta and energies as integer multiples "
+          "of the precision set with PositionPrecision and EnergyPrecision."
+      )
+      .SetGuidance(
+          "note: the values are limited to about 2 billion times the precision (i.e. 2 km or "
+          "2 TeV with the defaults). Larger values are clamped, with a warning."
+      )
+      .SetGuidance(
+          std::string("This is ") + (fCompactEncoding ? "enabled" : "disabled") + " by default"
+      )
+      .SetParameterName("boolean", true)
+      .SetDefaultValue("true")
+      .SetStates(G4State_Idle);
+
+  fMessenger->DeclareMethod("PositionPrecision", &RMGTrackOutputScheme::SetPositionPrecision)
+      .SetGuidance("Set the unit used to store positions with CompactEncoding.")
+      .SetGuidance("Uses " + fPositionPrecisionUnit + " by default")
+      .SetParameterName("unit", false)
+      .SetCandidates("nm um mm cm m")
+      .SetStates(G4State_Idle);
+
+  fMessenger->DeclareMethod("EnergyPrecision", &RMGTrackOutputScheme::SetEnergyPrecision)
+      .SetGuidance("Set the unit used to store momenta and energies with CompactEncoding.")
+      .SetGuidance("Uses " + fEnergyPrecisionUnit + " by default")
+      .SetParameterName("unit", false)
+      .SetCandidates("eV keV MeV GeV")
+      .SetStates(G4State_Idle);
+
+  fMessenger->DeclareProperty("MaxTreeDepth", fMaxTreeDepth)
+      .SetGuidance(
+          "Only store tracks up to this depth in the track tree (primaries have depth 0). A "
+          "negative value disables the limit."
+      )
+      .SetParameterName("depth", false)
+      .SetStates(G4State_Idle);
 }
 
 // vim: tabstop=2 shiftwidth=2 expandtab
@@ -18,6 +18,7 @@
 #include "RMGGeomBenchOutputScheme.hh"
 #include "RMGGeometryCheckOutputScheme.hh"
 #include "RMGIsotopeFilterScheme.hh"
+#include "RMGOpticalMapScheme.hh"
 #include "RMGParticleFilterScheme.hh"
 #include "RMGStagingScheme.hh"
 #include "RMGTrackOutputScheme.hh"
@@ -31,6 +32,7 @@ void RMGUserInit::RegisterDefaultOptionalOutputSchemes() {
   AddOptionalOutputScheme<RMGGeometryCheckOutputScheme>("GeometryCheck");
   AddOptionalOutputScheme<RMGGeomBenchOutputScheme>("GeomBench");
   AddOptionalOutputScheme<RMGStagingScheme>("Staging");
+  AddOptionalOutputScheme<RMGOpticalMapScheme>("OpticalMap");
 }
 
 void RMGUserInit::ActivateOptionalOutputScheme(std::string name) {
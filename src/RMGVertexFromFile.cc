@@ -16,6 +16,10 @@
 
 #include "RMGVertexFromFile.hh"
 
+#include <atomic>
+#include <cmath>
+#include <map>
+
 #include "CLHEP/Units/SystemOfUnits.h"
 #include "G4RunManager.hh"
 #include "G4Threading.hh"
@@ -24,6 +28,10 @@
 #include "RMGManager.hh"
 
 RMGAnalysisReader* RMGVertexFromFile::fReader = new RMGAnalysisReader();
+RMGAnalysisReader::Prefetcher<G4ThreeVector> RMGVertexFromFile::fPrefetcher(
+    fReader,
+    &RMGVertexFromFile::ReadVertices
+);
 
 RMGVertexFromFile::RMGVertexFromFile() : RMGVVertexGenerator("FromFile") { this->DefineCommands(); }
 
@@ -52,41 +60,58 @@ void RMGVertexFromFile::OpenFile(std::string& name) {
         zunit
     );
   }
+
+  // resolve the unit only once, and not for every read row.
+  const std::map<std::string, double> units =
+      {{"", CLHEP::m},
+       {"nm", CLHEP::nm},
+       {"um", CLHEP::um},
+       {"mm", CLHEP::mm},
+       {"cm", CLHEP::cm},
+       {"m", CLHEP::m}};
+  fPosUnit = units.at(xunit);
 }
 
-bool RMGVertexFromFile::GenerateVertex(G4ThreeVector& vertex) {
+void RMGVertexFromFile::ReadVertices(
+    RMGAnalysisReader::Access& reader,
+    std::vector<G4ThreeVector>& vertices,
+    size_t n
+) {
+  for (size_t i = 0; i < n; i++) {
+    fXpos = fYpos = fZpos = NAN; // initialize sentinel values.
+    if (!reader.GetNtupleRow()) break;
+    vertices.emplace_back(fXpos * fPosUnit, fYpos * fPosUnit, fZpos * fPosUnit);
+    fRowsRead++;
+  }
+}
 
-  auto reader = fReader->GetLockedReader();
+bool RMGVertexFromFile::GenerateVertex(G4ThreeVector& vertex) {
 
-  if (reader) {
-    fXpos = fYpos = fZpos = NAN; // initialize sentinel values.
+  const G4ThreeVector* pos = nullptr;
+  if (RMGManager::Instance()->IsDynamicEventDistribution()) {
+    if (fEventBatchIndex < fEventBatch.size()) pos = &fEventBatch[fEventBatchIndex++];
+  } else if (fUseMemoryPool) {
+    // the vertices have been loaded completely at the start of the run.
+    const auto i = fMemoryPoolIndex.fetch_add(1, std::memory_order_relaxed);
+    if (i < fMemoryPool.size()) pos = &fMemoryPool[i];
+  } else {
+    // rows are read in blocks from the file, this only needs a lock when a new block is read.
+    pos = fPrefetcher.Next(fPrefetched);
+  }
 
-    if (reader.GetNtupleRow()) {
-      // check for NaN sentinel values - i.e. non-existing columns (there is no error message).
-      if (std::isnan(fXpos) || std::isnan(fYpos) || std::isnan(fZpos)) {
-        RMGLog::Out(RMGLog::error, "At least one of the columns does not exist");
-        vertex = RMGVVertexGenerator::kDummyPrimaryPosition;
-        return false;
-      }
-
-      const auto unit_name = reader.GetUnit("xloc");
-      const std::map<std::string, double> units =
-          {{"", CLHEP::m},
-           {"nm", CLHEP::nm},
-           {"um", CLHEP::um},
-           {"mm", CLHEP::mm},
-           {"cm", CLHEP::cm},
-           {"m", CLHEP::m}};
-
-      vertex = G4ThreeVector{fXpos, fYpos, fZpos} * units.at(unit_name);
-      return true;
+  if (pos) {
+    // check for NaN sentinel values - i.e. non-existing columns (there is no error message).
+    if (std::isnan(pos->x()) || std::isnan(pos->y()) || std::isnan(pos->z())) {
+      RMGLog::Out(RMGLog::error, "At least one of the columns does not exist");
+      vertex = RMGVVertexGenerator::kDummyPrimaryPosition;
+      return false;
     }
 
-    RMGLog::Out(RMGLog::error, "No more vertices available in input file!");
-  } else {
-    RMGLog::Out(RMGLog::error, "Ntuple named 'pos' could not be found in input file!");
+    vertex = *pos;
+    return true;
   }
 
+  RMGLog::Out(RMGLog::error, "No more vertices available in input file!");
   vertex = RMGVVertexGenerator::kDummyPrimaryPosition;
   return false;
 }
@@ -95,15 +120,44 @@ void RMGVertexFromFile::BeginOfRunAction(const G4Run*) {
 
   if (!G4Threading::IsMasterThread()) return;
 
+  fPrefetcher.Reset();
+
   auto reader = fReader->GetLockedReader();
   if (!reader) {
     RMGLog::Out(RMGLog::fatal, "vertex file '", fReader->GetFileName(), "' not found or in wrong format");
   }
 
-  // in the mzultiprocessing-mode we get here with an offset on the main thread.
-  size_t start_event = RMGManager::Instance()->GetProcessNumberOffset() *
-                       G4RunManager::GetRunManager()->GetNumberOfEventsToBeProcessed();
+  // with dynamic event distribution, the rows are read for each batch of events.
+  fRowsRead = 0;
+  if (RMGManager::Instance()->IsDynamicEventDistribution()) {
+    // the vertices of each batch are held in memory anyway, but the vertices of the whole process
+    // are not known in advance.
+    if (fLoadIntoMemory) {
+      RMGLog::Out(
+          RMGLog::fatal,
+          "LoadIntoMemory cannot be used with dynamic event distribution (--event-batch-size)"
+      );
+    }
+    return;
+  }
+
+  // in the multiprocessing-mode we get here with an offset on the main thread.
+  const size_t n_events = G4RunManager::GetRunManager()->GetNumberOfEventsToBeProcessed();
+  size_t start_event = RMGManager::Instance()->GetProcessNumberOffset() * n_events;
+  // for LH5 input, this does not need to read the skipped rows.
   reader.Seek(start_event);
+  fRowsRead = start_event;
+
+  // the workers only start after this action on the master thread, so they will see the pool.
+  fUseMemoryPool = fLoadIntoMemory;
+  fMemoryPool.clear();
+  fMemoryPoolIndex = 0;
+  if (fLoadIntoMemory) {
+    // only the vertices used by this process are needed.
+    fMemoryPool.reserve(n_events);
+    ReadVertices(reader, fMemoryPool, n_events);
+    RMGLog::OutFormat(RMGLog::detail, "Loaded {} vertices into memory", fMemoryPool.size());
+  }
 }
 
 void RMGVertexFromFile::EndOfRunAction(const G4Run*) {
@@ -111,6 +165,31 @@ void RMGVertexFromFile::EndOfRunAction(const G4Run*) {
   if (!G4Threading::IsMasterThread()) return;
 
   fReader->CloseFile();
+  fMemoryPool = {};
+}
+
+void RMGVertexFromFile::BeginOfEventBatch(size_t first_event, size_t n_events) {
+
+  fEventBatch.clear();
+  fEventBatchIndex = 0;
+
+  auto reader = fReader->GetLockedReader();
+  if (!reader) return;
+
+  // the batches are claimed in order, so the reader never has to go back.
+  if (first_event < fRowsRead) {
+    RMGLog::OutFormat(
+        RMGLog::fatal,
+        "vertex rows of event {} have already been read (at row {})",
+        first_event,
+        fRowsRead
+    );
+  }
+  reader.Seek(first_event - fRowsRead);
+  fRowsRead = first_event;
+
+  fEventBatch.reserve(n_events);
+  ReadVertices(reader, fEventBatch, n_events);
 }
 
 void RMGVertexFromFile::DefineCommands() {
@@ -136,4 +215,20 @@ void RMGVertexFromFile::DefineCommands() {
       .SetParameterName("nt_directory", false)
       .SetDefaultValue(fNtupleDirectoryName)
       .SetStates(G4State_PreInit, G4State_Idle);
+
+  fMessenger->DeclareProperty("LoadIntoMemory", fLoadIntoMemory)
+      .SetGuidance(
+          "Load all vertices needed for the run into memory at its start, instead of reading "
+          "them from the file during the run."
+      )
+      .SetGuidance(
+          "note: this avoids any locking between threads, but needs 24 bytes per event. It cannot "
+          "be used with dynamic event distribution."
+      )
+      .SetGuidance(
+          std::string("This is ") + (fLoadIntoMemory ? "enabled" : "disabled") + " by default"
+      )
+      .SetParameterName("boolean", true)
+      .SetDefaultValue("true")
+      .SetStates(G4State_PreInit, G4State_Idle);
 }
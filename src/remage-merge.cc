@@ -0,0 +1,91 @@
+// Copyright (C) 2026
+//
+// This program is free software: you can redistribute it and/or modify it under
+// the terms of the GNU Lesser General Public License as published by the Free
+// Software Foundation, either version 3 of the License, or (at your option) any
+// later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more
+// details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <filesystem>
+#include <set>
+#include <string>
+#include <sys/resource.h>
+#include <vector>
+namespace fs = std::filesystem;
+
+#include "RMGLog.hh"
+#include "RMGMergeLH5.hh"
+
+#include "CLI/CLI.hpp"
+
+int main(int argc, char** argv) {
+  bool verbosity = false;
+  bool overwrite = false;
+  std::vector<std::string> file_names;
+  std::string output_file_name;
+  std::set<std::string> dedup_tables = {"processes", "detector_origins"};
+  size_t buffer_rows = RMGMergeLH5::fDefaultBufferRows;
+  int prefetch_files = 1;
+
+  CLI::App app{"remage-merge: merge multiple remage LH5 output files into a single file"};
+  app.add_flag("-v", verbosity, "Increase verbosity");
+  app.add_flag("-w,--overwrite", overwrite, "Overwrite an existing output file");
+  app.add_option("-o,--output", output_file_name, "Output LH5 file")->type_name("FILE")->required();
+  app.add_option("--deduplicate", dedup_tables, "Tables to deduplicate on their name column")
+      ->type_name("TABLE")
+      ->capture_default_str();
+  app.add_option("-b,--buffer-rows", buffer_rows, "Number of rows per column to copy at once")
+      ->check(CLI::PositiveNumber)
+      ->capture_default_str();
+  app.add_option(
+         "-j,--prefetch",
+         prefetch_files,
+         "Number of input files the operating system is advised to read ahead"
+  )
+      ->check(CLI::NonNegativeNumber)
+      ->capture_default_str();
+  app.add_option("input_files", file_names, "Input LH5 files")->type_name("FILE")->required();
+  CLI11_PARSE(app, argc, argv);
+
+  RMGLog::SetInihibitStartupInfo(true);
+  if (verbosity) RMGLog::SetLogLevel(RMGLog::detail);
+
+  RMGMergeLH5::fIsStandalone = true;
+
+  for (auto& file_name : file_names) {
+    if (!fs::exists(file_name)) {
+      RMGLog::OutFormat(RMGLog::error, "{} does not exist", file_name);
+      return 1;
+    }
+  }
+
+  if (fs::exists(output_file_name)) {
+    if (!overwrite) {
+      RMGLog::OutFormat(RMGLog::error, "{} does already exist", output_file_name);
+      return 1;
+    }
+    fs::remove(output_file_name);
+  }
+
+  RMGMergeLH5::MergeLH5(file_names, output_file_name, dedup_tables, buffer_rows, prefetch_files);
+
+  struct rusage usage{};
+  if (!getrusage(RUSAGE_SELF, &usage)) {
+    RMGLog::OutFormat(
+        RMGLog::debug,
+        "peak memory usage: {} MiB",
+        usage.ru_maxrss / 1024
+    ); // maxrss is in kilobytes.
+  }
+
+  return RMGLog::HadError() ? 1 : 0;
+}
+
+// vim: tabstop=2 shiftwidth=2 expandtab
@@ -0,0 +1,37 @@
+#!/bin/bash
+
+REMAGE_PYEXE="$1"
+
+# start a long run, and terminate the python wrapper when the processes have been forked.
+log=fork-signal.log
+${REMAGE_PYEXE} -g gdml/geometry.gdml -o none -P 2 --fork-after-init \
+    --macro-substitutions ENERGY=1000 GENERATOR=GPS EVENTS=100000000 -- macros/run-events.mac > "$log" 2>&1 &
+pid=$!
+
+until grep -q "Forked process 1 (pid" "$log"; do
+    if ! kill -0 "$pid" 2> /dev/null; then
+        cat "$log"
+        echo "remage exited before forking"
+        exit 1
+    fi
+    sleep 0.5
+done
+child_pid=$(sed -n 's/.*Forked process 1 (pid \([0-9]*\)).*/\1/p' "$log" | head -n 1)
+
+kill -TERM "$pid"
+wait "$pid"
+ec=$?
+cat "$log"
+
+# the signal has to be forwarded to the forked process, that must not outlive the first process.
+sleep 1
+if kill -0 "$child_pid" 2> /dev/null; then
+    echo "forked process $child_pid is still running"
+    kill -KILL "$child_pid"
+    exit 1
+fi
+
+if [[ "$ec" == 0 ]]; then
+    echo "remage exited with code 0 after SIGTERM"
+    exit 1
+fi
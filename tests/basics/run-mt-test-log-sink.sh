@@ -0,0 +1,39 @@
+#!/bin/bash
+
+REMAGE_PYEXE="$1"
+
+function fail() {
+    echo "$1"
+    exit 1
+}
+
+# the messages of all threads are written to the log file by the buffered sink.
+rm -f log-sink.log
+${REMAGE_PYEXE} -g gdml/geometry.gdml -o none -t 2 \
+    --macro-substitutions LOG=log-sink.log ENERGY=100 GENERATOR=GPS EVENTS=5000 \
+    -- macros/_log-file.mac macros/run-events.mac || fail "remage failed"
+
+# the progress messages of each thread are in order.
+for t in 0 1; do
+    grep "G4WT$t > .*Processing event nr\." log-sink.log \
+        | sed -E 's/.*event nr\. ([0-9]+).*/\1/' \
+        | sort -n -c || fail "messages of thread $t are out of order"
+done
+
+# the end of the run is logged by the master thread after all workers finished, and has to be
+# written by the final flush at exit.
+last_event=$(grep -n "Processing event nr\." log-sink.log | tail -n 1 | cut -d: -f1)
+completed=$(grep -n "Run nr\. 0 completed" log-sink.log | cut -d: -f1)
+[[ -n "$last_event" && -n "$completed" ]] || fail "messages are missing in the log file"
+[[ "$last_event" -lt "$completed" ]] || fail "messages of different threads are out of order"
+
+# a fatal error has to flush the buffered messages before aborting. We intentionally do not
+# set the override file flag (-w), so that the run fails because the output file exists.
+rm -f log-sink-fatal.log
+touch log-sink-fatal.lh5
+${REMAGE_PYEXE} -g gdml/geometry.gdml -o log-sink-fatal.lh5 -t 2 \
+    --macro-substitutions LOG=log-sink-fatal.log ENERGY=100 GENERATOR=GPS EVENTS=10 \
+    -- macros/_log-file.mac macros/run-events.mac && fail "remage did not fail"
+grep -q "Fatal.*already exists" log-sink-fatal.log || fail "fatal message is missing in the log file"
+
+echo "log sink test passed"
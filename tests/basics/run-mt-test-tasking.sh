@@ -0,0 +1,30 @@
+#!/bin/bash
+
+REMAGE_PYEXE="$1"
+
+function fail() {
+    echo "$1"
+    exit 1
+}
+
+args=(-g gdml/geometry.gdml -o none -t 2 --macro-substitutions ENERGY=100 GENERATOR=GPS EVENTS=100)
+
+# the events of the run are split into tasks of the requested size, on pinned worker threads.
+log=$(G4RUN_MANAGER_TYPE=Tasking ${REMAGE_PYEXE} "${args[@]}" -l debug \
+    --events-per-task 10 --pin-threads -- macros/run-events.mac 2>&1) || fail "remage failed"
+grep -q "Splitting 100 events into 10 tasks" <<< "$log" || fail "events per task are not applied"
+grep -q "Pinned worker thread to CPU" <<< "$log" || fail "worker threads are not pinned"
+grep -q "Run nr. 0 completed" <<< "$log" || fail "run did not complete"
+
+# the command line options are also available as macro commands.
+log=$(G4RUN_MANAGER_TYPE=Tasking ${REMAGE_PYEXE} "${args[@]}" -l detail \
+    -- macros/_tasks.mac macros/run-events.mac 2>&1) || fail "remage failed"
+grep -q "Splitting 100 events into 4 tasks" <<< "$log" || fail "number of tasks is not applied"
+
+# the task settings have no effect without a task-based run manager, which is a warning (exit
+# code 2).
+log=$(G4RUN_MANAGER_TYPE=MT ${REMAGE_PYEXE} "${args[@]}" --tasks 4 -- macros/run-events.mac 2>&1)
+[[ $? -eq 2 ]] || fail "remage did not warn"
+grep -q "Task settings have no effect" <<< "$log" || fail "warning is missing"
+
+echo "tasking test passed"
@@ -0,0 +1,61 @@
+#!/bin/env python3
+
+from __future__ import annotations
+
+import os
+import shutil
+from pathlib import Path
+
+import lh5
+import numpy as np
+from remage import remage_run
+
+# work on copies of the cascade files, so that the cache files are always created by this test.
+shutil.rmtree("cache", ignore_errors=True)
+Path("cache").mkdir()
+sources = [Path("cache/156Gd-100Entries.txt"), Path("cache/158Gd-100Entries.txt")]
+for source in sources:
+    shutil.copy(f"data/{source.name}", source)
+caches = [Path(f"{source}.rmgcache") for source in sources]
+
+
+def run(output, cache):
+    remage_run(
+        "macros/_cascade-cache.mac",
+        gdml_files="gdml/nist_gd_world.gdml",
+        output=output,
+        flat_output=True,
+        overwrite_output=True,
+        macro_substitutions={"CACHE": str(cache).lower()},
+    )
+    return lh5.read_as("tracks", output, "pd")
+
+
+reference = run("cascade-cache-off.lh5", False)
+assert len(reference) > 0
+assert not any(cache.exists() for cache in caches)
+
+# the first run with the cache enabled writes the cache files, the second one reads them.
+written = run("cascade-cache-write.lh5", True)
+assert all(cache.exists() for cache in caches)
+mtimes = [cache.stat().st_mtime_ns for cache in caches]
+read = run("cascade-cache-read.lh5", True)
+assert [cache.stat().st_mtime_ns for cache in caches] == mtimes
+
+# the same cascades are sampled from the parsed files and from the cache.
+for tracks in (written, read):
+    assert len(tracks) == len(reference)
+    for col in ("evtid", "particle", "ekin_in_MeV"):
+        assert np.array_equal(tracks[col], reference[col]), col
+
+# a modified source file invalidates its cache, which is then re-written.
+stat = sources[0].stat()
+os.utime(sources[0], ns=(stat.st_atime_ns, stat.st_mtime_ns + 10**9))
+rewritten = run("cascade-cache-rewrite.lh5", True)
+assert caches[0].stat().st_mtime_ns != mtimes[0]
+assert np.array_equal(rewritten.ekin_in_MeV, reference.ekin_in_MeV)
+
+# a corrupted cache is ignored, too.
+caches[1].write_bytes(b"not a cache")
+corrupted = run("cascade-cache-corrupted.lh5", True)
+assert np.array_equal(corrupted.ekin_in_MeV, reference.ekin_in_MeV)
@@ -0,0 +1,67 @@
+from __future__ import annotations
+
+from pathlib import Path
+
+import lh5
+import pytest
+from remage import remage_run
+from test_detection import geometry_detection
+
+n_events = 3000
+macro_init = """
+/RMG/Processes/OpticalPhysics
+
+/RMG/Geometry/RegisterDetector Optical detector 001
+"""
+macro_run = """
+/run/initialize
+
+/RMG/Generator/Confine UnConfined
+
+/RMG/Generator/Select GPS
+/gps/position     0 0 18 cm
+/gps/particle     opticalphoton
+/gps/energy       6 eV
+/gps/direction    0 0 -1
+
+/run/beamOn {events}
+"""
+
+
+def simulate(efficiency_file: str | None):
+    output = "output-detection-efficiency.lh5"
+    macro = macro_init.split("\n")
+    if efficiency_file is not None:
+        macro.append(
+            f"/RMG/Geometry/SetOpticalDetectorEfficiency {efficiency_file} det.*"
+        )
+
+    remage_run(
+        macro + macro_run.split("\n"),
+        macro_substitutions={
+            "events": n_events,
+        },
+        gdml_files=geometry_detection(0, 1),
+        output=output,
+        overwrite_output=True,
+        log_level="summary",
+    )
+
+    return len(lh5.read("stp/det001", output))
+
+
+def test_detection_efficiency():
+    # the photons (6 eV, i.e. 207 nm) are inside of the tabulated range.
+    efficiency_file = "detection-efficiency.dat"
+    Path(efficiency_file).write_text("# wavelength efficiency\n100 0.3\n800 0.3\n")
+
+    n_all = simulate(None)
+    n_detected = simulate(efficiency_file)
+
+    assert n_all > 0.9 * n_events
+    assert n_detected == pytest.approx(0.3 * n_all, rel=0.1)
+
+
+def test_detection_efficiency_missing_file():
+    with pytest.raises(RuntimeError):
+        simulate("does-not-exist.dat")
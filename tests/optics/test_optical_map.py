@@ -0,0 +1,76 @@
+from __future__ import annotations
+
+import h5py
+import lh5
+import numpy as np
+import pytest
+from remage import remage_run
+from test_wls import geometry_attenuation
+
+n_events = 2000
+macro = """
+/RMG/Processes/OpticalPhysics
+/RMG/Processes/OpticalPhysicsMaxOneWLSPhoton true
+/RMG/Processes/OpticalPhysicsWLSThinning {thinning}
+
+/RMG/Geometry/RegisterDetector Optical detector 001
+
+/RMG/Output/ActivateOutputScheme OpticalMap
+
+/run/initialize
+
+/RMG/OpticalMap/CreateMap {map_file}
+/RMG/OpticalMap/CreateMapLowerEdge -100 -100 -200 mm
+/RMG/OpticalMap/CreateMapUpperEdge 100 100 200 mm
+/RMG/OpticalMap/CreateMapBinWidth 400 mm
+
+/RMG/Generator/Confine UnConfined
+
+/RMG/Generator/Select GPS
+/gps/position     0 0 0 mm
+/gps/particle     opticalphoton
+/gps/energy       9.68 eV
+/gps/direction    0 0 1
+
+/run/beamOn {events}
+"""
+
+
+def test_create_optical_map():
+    # the wavelength-shifted photons are thinned by a non-integer factor (which the thinning
+    # commands accept as a floating-point value), i.e. the detected photons have fractional
+    # weights.
+    thinning = 2.5
+    output = "output-optical-map.lh5"
+    map_file = "optical-map.hdf5"
+
+    remage_run(
+        macro.split("\n"),
+        macro_substitutions={
+            "events": n_events,
+            "thinning": thinning,
+            "map_file": map_file,
+        },
+        gdml_files=geometry_attenuation(10),
+        output=output,
+        flat_output=True,
+        overwrite_output=True,
+        log_level="summary",
+    )
+
+    weights = lh5.read_as("stp/det001/weight", output, "np")
+    assert len(weights) > 0
+    assert np.allclose(weights, thinning)
+
+    with h5py.File(map_file) as f:
+        n_generated = f["optmap/n_generated"][...]
+        n_detected = f["optmap/n_detected"][...]
+        prob = f["optmap/prob"][...]
+
+    # all photons are generated in the single voxel of the map.
+    assert n_generated.shape == (1, 1, 1)
+    assert n_generated.sum() == n_events
+    # the detected photons are counted with their weights.
+    assert n_detected.shape == (1, 1, 1, 1)
+    assert n_detected.sum() == pytest.approx(weights.sum())
+    assert np.allclose(prob, n_detected / n_generated)
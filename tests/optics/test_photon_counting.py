@@ -0,0 +1,73 @@
+from __future__ import annotations
+
+import lh5
+import numpy as np
+from remage import remage_run
+from test_detection import geometry_detection
+
+n_events = 500
+macro = """
+/RMG/Processes/OpticalPhysics
+
+/RMG/Geometry/RegisterDetector Optical detector 001
+
+/run/initialize
+
+/RMG/Output/Optical/PhotonCounting {counting}
+/RMG/Output/Optical/PhotonCountingTimeBinWidth {bin_width} ns
+/RMG/Output/Optical/PhotonCountingTimeBins 10
+
+/RMG/Generator/Confine UnConfined
+
+/RMG/Generator/Select GPS
+/gps/position     0 0 18 cm
+/gps/particle     opticalphoton
+/gps/energy       6 eV
+/gps/direction    0 0 -1
+
+/run/beamOn {events}
+"""
+
+
+def simulate(counting: bool, bin_width: float):
+    output = f"output-photon-counting-{int(counting)}-{bin_width}.lh5"
+
+    # every photon is detected.
+    remage_run(
+        macro.split("\n"),
+        macro_substitutions={
+            "events": n_events,
+            "counting": str(counting).lower(),
+            "bin_width": bin_width,
+        },
+        gdml_files=geometry_detection(0, 1),
+        output=output,
+        flat_output=True,
+        overwrite_output=True,
+        log_level="summary",
+    )
+
+    return lh5.read_as("stp/det001", output, "pd")
+
+
+def test_photon_counting():
+    photons = simulate(False, 0)
+    counts = simulate(True, 0)
+
+    assert len(photons) == n_events
+    assert counts["n_photons"].sum() == len(photons)
+    # without time bins, the time of the first photon is stored.
+    assert np.allclose(np.sort(counts["time"]), np.sort(photons["time"]))
+
+
+def test_photon_counting_time_bins():
+    counts = simulate(True, 1)
+    assert counts["n_photons"].sum() == n_events
+    # the photons arrive within the first nanosecond.
+    assert np.all(counts["time"] == 0)
+
+    # the arrival time in units of this bin width does not fit into an integer, all photons are
+    # counted in the overflow bin.
+    counts = simulate(True, 1e-12)
+    assert counts["n_photons"].sum() == n_events
+    assert np.allclose(counts["time"], 9e-12)
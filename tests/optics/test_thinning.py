@@ -0,0 +1,96 @@
+from __future__ import annotations
+
+import lh5
+import numpy as np
+import pyg4ometry as pg4
+import pygeomoptics
+import pytest
+from _geometry import _add_dummy_sipm_surface
+from pygeomtools.materials import LegendMaterialRegistry
+from remage import remage_run
+
+n_events = 50
+thinning = 2.5
+macro = """
+/RMG/Processes/OpticalPhysics
+/RMG/Processes/OpticalPhysicsScintillationThinning {thinning}
+
+/RMG/Geometry/RegisterDetector Optical detector 001
+
+/run/initialize
+
+/RMG/Output/Optical/PhotonCounting {counting}
+
+/RMG/Generator/Confine UnConfined
+
+/RMG/Generator/Select GPS
+/gps/position     0 0 17.5 cm
+/gps/particle     e-
+/gps/energy       100 keV
+/gps/ang/type     iso
+
+/run/beamOn {events}
+"""
+
+
+def geometry_scintillation():
+    reg = pg4.geant4.Registry()
+    matreg = LegendMaterialRegistry(reg, enable_optical=False)
+
+    mat = matreg.liquidargon
+    pygeomoptics.lar.pyg4_lar_attach_rindex(mat, reg)
+    pygeomoptics.lar.pyg4_lar_attach_scintillation(mat, reg)
+
+    world_s = pg4.geant4.solid.Orb("world", 20, registry=reg, lunit="cm")
+    world_l = pg4.geant4.LogicalVolume(world_s, mat, "world", registry=reg)
+    reg.setWorld(world_l)
+
+    det_s = pg4.geant4.solid.Orb("detector", 15, registry=reg, lunit="cm")
+    det_l = pg4.geant4.LogicalVolume(
+        det_s, matreg.metal_silicon, "detector", registry=reg
+    )
+    pg4.geant4.PhysicalVolume(
+        [0, 0, 0], [0, 0, 0], det_l, "detector", world_l, registry=reg
+    )
+
+    _add_dummy_sipm_surface(0, 1, reg, det_l)
+
+    return reg
+
+
+def simulate(k: float, counting: bool):
+    output = f"output-thinning-{k}-{int(counting)}.lh5"
+
+    remage_run(
+        macro.split("\n"),
+        macro_substitutions={
+            "events": n_events,
+            "thinning": k,
+            "counting": str(counting).lower(),
+        },
+        gdml_files=geometry_scintillation(),
+        output=output,
+        flat_output=True,
+        overwrite_output=True,
+        log_level="summary",
+    )
+
+    return lh5.read_as("stp/det001", output, "pd")
+
+
+def test_thinning_weights():
+    photons = simulate(thinning, False)
+    assert len(photons) > 0
+    # the (non-integer) weights are stored without rounding.
+    assert np.allclose(photons["weight"], thinning)
+
+
+def test_thinning_photon_yield():
+    counts = simulate(1, True)
+    thinned = simulate(thinning, True)
+
+    # the thinned photons are counted with their weights, i.e. the yield is unbiased.
+    assert thinned["n_photons"].sum() == pytest.approx(
+        counts["n_photons"].sum(), rel=0.05
+    )
+    assert not np.allclose(thinned["n_photons"] % 1, 0)
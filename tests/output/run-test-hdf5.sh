@@ -13,12 +13,24 @@ macro="macros/$3"
 
 is_mt="${4-}"
 extra_args=""
+pre_macros=""
+pproc_macros=""
 expected_count=1000
 if [[ "$is_mt" == "mt" ]]; then
     extra_args="-m -t 2"
+elif [[ "$is_mt" == "mt-single" ]]; then
+    # let the worker threads append to a single file, without merging in python.
+    extra_args="-t 2"
+    pre_macros="macros/_merge-thread-files.mac"
+elif [[ "$is_mt" == "reshape" ]]; then
+    # group the steps into hits in remage-cpp, instead of the python post-processing.
+    pproc_macros="macros/_reshape-hits.mac"
 elif [[ "$is_mt" == "mp" ]]; then
     extra_args="-m -P 2"
     expected_count=2000
+elif [[ "$is_mt" == "dynamic" ]]; then
+    # the processes share the events of the run, and simulate them together exactly once.
+    extra_args="-m -P 2 --event-batch-size 50"
 fi
 
 output_h5="${3/.mac/.hdf5}"
@@ -70,7 +82,7 @@ fi
 
 # run remage, produce lh5 output.
 # shellcheck disable=SC2086
-"$rmg" -g gdml/geometry.gdml -o "$output_lh5" --flat-output -w $extra_args -- "$macro"
+"$rmg" -g gdml/geometry.gdml -o "$output_lh5" --flat-output -w $extra_args -- $pre_macros "$macro"
 
 # extract written lh5 structure & compare with expectation.
 "$lh5ls" -a "$output_lh5" | sed -r 's/\x1B\[[0-9;]*[mK]//g' > "$output_dump_lh5"
@@ -84,7 +96,7 @@ diff -u "$output_dump_lh5" "$output_exp_lh5"
 
 # run remage, produce *jagged* lh5 output.
 # shellcheck disable=SC2086
-"$rmg" -g gdml/geometry.gdml -o "$output_lh5_jag" -w $extra_args -- "$macro"
+"$rmg" -g gdml/geometry.gdml -o "$output_lh5_jag" -w $extra_args -- $pre_macros $pproc_macros "$macro"
 
 # extract written lh5 structure & compare with expectation.
 "$lh5ls" -a "$output_lh5_jag" | sed -r 's/\x1B\[[0-9;]*[mK]//g' > "$output_dump_lh5_jag"
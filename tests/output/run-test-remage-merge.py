@@ -0,0 +1,46 @@
+#!/bin/env python3
+
+from __future__ import annotations
+
+import subprocess
+import sys
+from pathlib import Path
+
+import lh5
+from remage import remage_run
+
+remage_merge = sys.argv[1]
+inputs = ["merge-input-1.lh5", "merge-input-2.lh5"]
+output_lh5 = "merge-output.lh5"
+
+# produce two (flat) output files to merge.
+for output in inputs:
+    remage_run(
+        "macros/ntuple-per-det.mac",
+        gdml_files="gdml/geometry.gdml",
+        output=output,
+        flat_output=True,
+        overwrite_output=True,
+    )
+
+Path(output_lh5).unlink(missing_ok=True)
+subprocess.run([remage_merge, "-j", "1", "-o", output_lh5, *inputs], check=True)
+
+# an existing output file is not overwritten without --overwrite.
+existing = subprocess.run([remage_merge, "-o", output_lh5, *inputs], check=False)
+assert existing.returncode == 1
+subprocess.run([remage_merge, "-w", "-b", "7", "-o", output_lh5, *inputs], check=True)
+
+# the steps tables are concatenated.
+for table in lh5.ls(output_lh5, "stp/"):
+    n_rows = [len(lh5.read(table, f)) for f in inputs]
+    assert len(lh5.read(table, output_lh5)) == sum(n_rows), table
+
+# the event counts are added up.
+n_events = [lh5.read("number_of_simulated_events", f).value for f in inputs]
+assert lh5.read("number_of_simulated_events", output_lh5).value == sum(n_events)
+
+# the processes of both files are only stored once.
+processes = lh5.read_as("processes", output_lh5, "pd")
+assert processes.name.is_unique
+assert set(processes.name) == set(lh5.read_as("processes", inputs[0], "pd").name)
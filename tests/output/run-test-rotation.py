@@ -0,0 +1,41 @@
+#!/bin/env python3
+
+from __future__ import annotations
+
+import lh5
+from remage import remage_run
+
+macro = "macros/ntuple-per-det.mac"
+
+
+def run(output_lh5, pre_macros=()):
+    remage_run(
+        [*pre_macros, macro],
+        gdml_files="gdml/geometry.gdml",
+        output=output_lh5,
+        flat_output=True,
+        overwrite_output=True,
+    )
+
+
+def table_rows(file):
+    return {t: len(lh5.read(t, file)) for t in lh5.ls(file, "stp/") if "__" not in t}
+
+
+# the same (seeded) simulation, once into a single file and once into rotated files.
+run("rotation-single.lh5")
+run("rotation.lh5", ["macros/_rotate-output.mac"])
+
+# 1000 events with at most 300 events per file.
+files = ["rotation.lh5", "rotation_f1.lh5", "rotation_f2.lh5", "rotation_f3.lh5"]
+n_events = [lh5.read("number_of_simulated_events", f).value for f in files]
+assert n_events == [300, 300, 300, 100], n_events
+
+expected = table_rows("rotation-single.lh5")
+totals = dict.fromkeys(expected, 0)
+for f in files:
+    # the auxiliary tables are written into each file.
+    assert "detector_origins" in lh5.ls(f)
+    for t, n in table_rows(f).items():
+        totals[t] += n
+assert totals == expected, (totals, expected)
@@ -3,7 +3,8 @@ from __future__ import annotations
 import re
 from pathlib import Path
 
-from remage import remage_run
+import lh5
+from remage import post_proc, remage_run
 
 
 def get_hidden_lh5(directory=".") -> list[Path]:
@@ -67,3 +68,31 @@ def test_file_merging():
 
     for t in [0, 1]:
         assert not check_exists_and_remove(f"{output.stem}_t{t}.lh5")
+
+
+def test_merge_thread_files(monkeypatch):
+    output = Path("output-merged-threads.lh5")
+    check_exists_and_remove(output)
+
+    # the worker threads already appended their output to the main output file.
+    def fail(*_args, **_kwargs):
+        msg = "the thread files must not be merged again"
+        raise AssertionError(msg)
+
+    monkeypatch.setattr(post_proc, "lh5concat", fail)
+    monkeypatch.setattr(post_proc, "merge_native", fail)
+
+    remage_run(
+        ["macros/_merge-thread-files.mac", "macros/run.mac"],
+        gdml_files="gdml/geometry.gdml",
+        output=output,
+        threads=2,
+        flat_output=True,
+        merge_output_files=True,
+    )
+
+    assert get_hidden_lh5() == []
+    for t in [0, 1]:
+        assert not check_exists_and_remove(f"{output.stem}_t{t}.lh5")
+    assert lh5.read("number_of_simulated_events", output).value == 1000
+    assert check_exists_and_remove(output)
@@ -0,0 +1,39 @@
+from __future__ import annotations
+
+import lh5
+import numpy as np
+from remage import remage_run
+
+
+def _run_forked(output, **kwargs):
+    return remage_run(
+        "macros/run.mac",
+        gdml_files="gdml/geometry.gdml",
+        output=output,
+        procs=2,
+        fork_after_init=True,
+        flat_output=True,
+        **kwargs,
+    )[0]
+
+
+def test_fork_output(tmptestdir):
+    output = tmptestdir / "fork.lh5"
+    assert _run_forked(output, overwrite_output=True) == 0
+
+    # each process writes its own output file, with its own random seed.
+    edep = []
+    for proc_num in (0, 1):
+        file = str(tmptestdir / f"fork_p{proc_num}.lh5")
+        assert lh5.read("number_of_simulated_events", file).value == 1000
+        edep.append(lh5.read_as("stp/det001/edep", file, "np"))
+    assert not np.array_equal(edep[0], edep[1])
+
+
+def test_fork_child_exit_code(tmptestdir):
+    output = tmptestdir / "fork-fail.lh5"
+    # the forked process exits with a fatal error, because its output file already exists.
+    (tmptestdir / "fork-fail_p1.lh5").touch()
+
+    ec = _run_forked(output, raise_on_error=False)
+    assert ec != 0
@@ -0,0 +1,117 @@
+from __future__ import annotations
+
+import io
+
+from remage.ipc import (
+    FLAG_BLOCKING,
+    FLAG_CONTINUED,
+    FRAME_HEADER,
+    EventBatches,
+    FrameReader,
+    Telemetry,
+    handle_ipc_message,
+)
+
+
+def _report(thread, run, run_events, events, steps, seconds, final=False):
+    values = (thread, run, run_events, events, steps, seconds, 1000, 2000, int(final))
+    return tuple(str(v) for v in values)
+
+
+def test_event_batches():
+    batches = EventBatches(4)
+    assert batches.claim(0, 10) == (0, 4)
+    assert batches.claim(0, 10) == (4, 4)
+    assert batches.claim(0, 10) == (8, 2)
+    assert batches.claim(0, 10) == (10, 0)
+    # runs are independent.
+    assert batches.claim(1, 3) == (0, 3)
+
+
+def test_event_batch_message():
+    batches = EventBatches(4)
+    claimed = []
+    while True:
+        # the blocking request of remage-cpp: run ID and number of events of the run.
+        msg, is_fatal, response = handle_ipc_message(
+            "event_batch\x1e0\x1e10", 0, True, [], event_batches=batches
+        )
+        assert msg is None
+        assert not is_fatal
+        first, n_events = (int(v) for v in response.split("\x1f"))
+        if n_events == 0:
+            break
+        claimed.append((first, n_events))
+
+    assert claimed == [(0, 4), (4, 4), (8, 2)]
+    # all events are handed out exactly once.
+    assert sum(n for _, n in claimed) == 10
+
+
+def test_event_batch_message_without_batches():
+    _, is_fatal, _ = handle_ipc_message("event_batch\x1e0\x1e10", 0, True, [])
+    assert is_fatal
+
+
+def test_telemetry_summary():
+    telemetry = Telemetry()
+    telemetry.update(0, _report(0, 0, 100, 10, 1000, 2.0))
+    telemetry.update(0, _report(1, 0, 100, 30, 3000, 2.0))
+    telemetry.update(1, _report(0, 0, 100, 20, 2000, 4.0))
+    # only the latest report of a thread is used.
+    telemetry.update(1, _report(0, 0, 100, 40, 4000, 4.0, final=True))
+
+    assert telemetry.runs() == [0]
+    s = telemetry.summary(0)
+    assert s["events"] == 80
+    assert s["events_total"] == 200
+    assert s["steps"] == 8000
+    assert s["seconds"] == 4.0
+    assert s["events_per_second"] == 5 + 15 + 10
+    assert s["min_thread_events_per_second"] == 5
+    assert s["output_bytes"] == 3000
+    # the memory is reported per process.
+    assert s["rss_bytes"] == 4000
+    assert not s["complete"]
+    assert len(s["threads"]) == 3
+
+
+def test_telemetry_dynamic_events():
+    telemetry = Telemetry(dynamic_events=True)
+    telemetry.update(0, _report(0, 0, 100, 10, 0, 1.0))
+    telemetry.update(1, _report(0, 0, 100, 10, 0, 1.0))
+    assert telemetry.summary(0)["events_total"] == 100
+
+
+def test_telemetry_progress_line():
+    stream = io.StringIO()
+    telemetry = Telemetry(stream=stream, interval=0)
+    telemetry.update(0, _report(0, 3, 100, 25, 100, 1.0))
+    assert stream.getvalue().startswith("\rrun 3: 25/100 events (25%)")
+
+    telemetry.finish()
+    assert stream.getvalue().endswith("\n")
+    assert [r["run_id"] for r in telemetry.report()["runs"]] == [3]
+
+
+def _frame(proc_num, payload, flags=0):
+    return FRAME_HEADER.pack(len(payload), proc_num, flags) + payload
+
+
+def test_frame_reader():
+    reader = FrameReader()
+    data = (
+        _frame(0, b"key\x1evalue")
+        # the frames of a long message can interleave with other processes.
+        + _frame(1, b"long\x1ea", FLAG_CONTINUED)
+        + _frame(0, b"event_batch\x1e0\x1e10", FLAG_BLOCKING)
+        + _frame(1, b"bc")
+    )
+    # the data can arrive in arbitrary chunks.
+    assert reader.feed(data[:5]) == []
+    assert reader.feed(data[5:30]) == [(0, False, "key\x1evalue")]
+    assert reader.feed(data[30:]) == [
+        (0, True, "event_batch\x1e0\x1e10"),
+        (1, False, "long\x1eabc"),
+    ]
+    assert not reader.buf
@@ -0,0 +1,51 @@
+from __future__ import annotations
+
+import lh5
+import pytest
+from remage import remage_run
+
+
+@pytest.fixture(scope="module")
+def musun_file(tmptestdir):
+    # one muon per row, starting in the center of the world. The energy identifies the row.
+    path = tmptestdir / "musun.dat"
+    with path.open("w") as f:
+        for i in range(4):
+            f.write(f"{i + 1:>10d}  10  {i + 1:.1f}  0.0  0.0  0.0  0.0  0.0\n")
+    return path
+
+
+def _run_twice(musun_file, output, procs):
+    remage_run(
+        [
+            "/RMG/Geometry/RegisterDetector Germanium germanium 001",
+            "/run/initialize",
+            "/RMG/Output/Vertex/StorePrimaryParticleInformation true",
+            "/RMG/Generator/Confine UnConfined",
+            "/RMG/Generator/Select MUSUNCosmicMuons",
+            f"/RMG/Generator/MUSUNCosmicMuons/MUSUNFile {musun_file}",
+            "/run/beamOn 2",
+            "/run/beamOn 2",
+        ],
+        gdml_files="gdml/geometry.gdml",
+        output=output,
+        procs=procs,
+        merge_output_files=True,
+        flat_output=True,
+        overwrite_output=True,
+    )
+    # the output file only contains the last run.
+    ekin = lh5.read_as("particles", str(output), "pd")["ekin"]
+    return sorted(round(e / 1000) for e in ekin)
+
+
+def test_musun_runs_restart(musun_file, tmptestdir):
+    # each run starts at the beginning of the file.
+    output = tmptestdir / "musun-seq.lh5"
+    assert _run_twice(musun_file, output, 1) == [1, 2]
+
+
+def test_musun_runs_process_offset(musun_file, tmptestdir):
+    # the second process reads the rows after the first process, also in the second run.
+    output = tmptestdir / "musun-mp.lh5"
+    assert _run_twice(musun_file, output, 2) == [1, 2, 3, 4]
@@ -98,3 +98,43 @@ def test_iter_event_aligned_chunks_buffer_smaller_than_event(tmptestdir):
     chunks = list(_iter_event_aligned_chunks(str(f), "stp/det1", 10))
     assert len(chunks) == 1
     assert len(chunks[0]) == 500
+
+
+def test_iter_event_aligned_chunks_contiguous_unordered(tmptestdir):
+    # evtids from multiple threads: not increasing, but each event is contiguous
+    f = tmptestdir / "unordered.lh5"
+    evtids = np.array([3, 3, 0, 0, 0, 7, 1, 1], dtype=np.int64)
+    lh5.write(Table(ak.Array({"evtid": evtids})), "stp/det1", f, wo_mode="of")
+
+    chunks = list(_iter_event_aligned_chunks(str(f), "stp/det1", 4))
+    assert [c.view_as("ak").evtid.to_list() for c in chunks] == [
+        [3, 3],
+        [0, 0, 0, 7],
+        [1, 1],
+    ]
+
+
+def test_iter_event_aligned_chunks_with_index(stp_files, tmptestdir):
+    stp_file = stp_files["gaps"]
+    evtids = lh5.read_as("stp/det1/evtid", stp_file, "np")
+    first_row = np.flatnonzero(np.diff(evtids, prepend=-1))
+    n_rows = np.diff(np.append(first_row, len(evtids)))
+
+    f = tmptestdir / "indexed.lh5"
+    lh5.write(Table(ak.Array({"evtid": evtids})), "stp/det1", f, wo_mode="of")
+    lh5.write(
+        Table(
+            ak.Array(
+                {"evtid": evtids[first_row], "first_row": first_row, "n_rows": n_rows}
+            )
+        ),
+        "stp/__index__/det1",
+        f,
+        wo_mode="append",
+    )
+
+    chunks = list(_iter_event_aligned_chunks(str(f), "stp/det1", 500))
+    chunks_index = list(
+        _iter_event_aligned_chunks(str(f), "stp/det1", 500, "stp/__index__/det1")
+    )
+    assert [len(c) for c in chunks_index] == [len(c) for c in chunks]
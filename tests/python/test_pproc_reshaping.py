@@ -451,3 +451,24 @@ def test_chunked_flat_hit_table_conserves_data(big_calo_stp_file, tmptestdir, bu
     assert "time" not in out_ak.fields
     assert out["edep"].attrs["units"] == "keV"
     assert out["t0"].attrs["units"] == "ns"
+
+
+def test_in_field(stp_file, tmptestdir):
+    """The detector tables are read from the configured ntuple directory."""
+    in_file = f"{tmptestdir}/basic_custom_dir.lh5"
+    outfile = f"{tmptestdir}/basic_hit_custom_dir.lh5"
+    lh5.write(lh5.read("stp/det1", stp_file), "hit/det1", in_file, wo_mode="of")
+
+    reshape_output(
+        stp_files=[in_file],
+        hit_files=outfile,
+        reshape_tables=["det1"],
+        forward_tables=[],
+        in_field="hit",
+        out_field="hit",
+        time_window_in_us=10,
+        overwrite=True,
+    )
+
+    assert lh5.ls(outfile) == ["hit"]
+    assert len(lh5.read("hit/det1", outfile).view_as("ak")) == 2
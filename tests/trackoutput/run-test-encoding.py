@@ -0,0 +1,99 @@
+#!/bin/env python3
+
+from __future__ import annotations
+
+from pathlib import Path
+
+import lh5
+import numpy as np
+from remage import remage_run
+
+
+def run(output_lh5, option_macros=()):
+    remage_run(
+        ["macros/_encoding-init.mac", *option_macros, "macros/_encoding-run.mac"],
+        gdml_files="gdml/geometry.gdml",
+        output=output_lh5,
+        overwrite_output=True,
+    )
+    return lh5.read_as("tracks", output_lh5, "pd")
+
+
+def depths(tracks):
+    # the parent track is always stored before its secondaries.
+    result = []
+    for _, event in tracks.groupby("evtid", sort=False):
+        depth = {0: -1}
+        for tid, parent in zip(event.trackid, event.parent_trackid, strict=True):
+            depth[tid] = depth.get(parent, -1) + 1
+            result.append(depth[tid])
+    return np.array(result)
+
+
+# the same (seeded) simulation is run with different track output options.
+tracks = run("track-encoding-plain.lh5")
+assert len(tracks) > 0
+assert (
+    tracks.groupby("evtid").trackid.nunique() == tracks.groupby("evtid").size()
+).all()
+
+# all stored process IDs are listed exactly once in the process table.
+processes = lh5.read_as("processes", "track-encoding-plain.lh5", "pd")
+assert processes.procid.is_unique
+assert processes.name.is_unique
+assert set(tracks.procid) <= set(processes.procid)
+
+# the compact encoding stores the same tracks, with delta-coded IDs and quantized values.
+compact = run("track-encoding-compact.lh5", ["macros/_compact.mac"])
+assert len(compact) == len(tracks)
+trackid = compact.groupby("evtid", sort=False).trackid_delta.cumsum()
+assert np.array_equal(trackid, tracks.trackid)
+assert np.array_equal(trackid - compact.parent_trackid_delta, tracks.parent_trackid)
+for col in ("xloc", "yloc", "zloc"):
+    diff = compact[f"{col}_in_um"] * 1e-6 - tracks[f"{col}_in_m"]
+    assert np.all(np.abs(diff) <= 0.5e-6 + 1e-12), col
+for col in ("px", "py", "pz", "ekin"):
+    diff = compact[f"{col}_in_keV"] * 1e-3 - tracks[f"{col}_in_MeV"]
+    assert np.all(np.abs(diff) <= 0.5e-3 + 1e-12), col
+
+# only the primaries and their direct secondaries are stored with a maximum depth of 1.
+limited = run("track-encoding-depth.lh5", ["macros/_max-depth.mac"])
+expected = tracks[depths(tracks) <= 1]
+assert len(expected) < len(tracks)
+assert np.array_equal(limited.evtid, expected.evtid)
+assert np.array_equal(limited.trackid, expected.trackid)
+
+# the process filter only keeps the tracks created by the given process.
+procid = tracks.procid[tracks.procid != -1].mode()[0]
+name = processes.name[processes.procid == procid].iloc[0].decode()
+Path("macros/_process-filter.mac").write_text(
+    f"/RMG/Output/Track/AddProcessFilter {name}\n"
+)
+filtered = run("track-encoding-filter.lh5", ["macros/_process-filter.mac"])
+assert (filtered.procid == procid).all()
+assert len(filtered) == (tracks.procid == procid).sum()
+
+# values outside of the range of the compact encoding are clamped, with a warning.
+Path("macros/_high-energy-run.mac").write_text(
+    """
+/RMG/Generator/Select GPS
+/gps/particle mu-
+/gps/energy 3 TeV
+/RMG/Generator/Confine Volume
+/RMG/Generator/Confinement/Physical/AddVolume Source
+/run/beamOn 1
+"""
+)
+ec, _ = remage_run(
+    [
+        "macros/_encoding-init.mac",
+        "macros/_compact.mac",
+        "macros/_high-energy-run.mac",
+    ],
+    gdml_files="gdml/geometry.gdml",
+    output="track-encoding-clamped.lh5",
+    overwrite_output=True,
+)
+assert ec == 2
+clamped = lh5.read_as("tracks", "track-encoding-clamped.lh5", "pd")
+assert clamped.ekin_in_keV[clamped.trackid_delta.cumsum() == 1].iloc[0] == 2**31 - 1
@@ -99,6 +99,23 @@ if "pos" in macro:
         assert _compare_input_output(output_pos[0::2], input_pos)
         assert _compare_input_output(output_pos[1::2], input_pos)
 
+if "memory" in macro:
+    # the vertices loaded into memory are the same as the ones read during the run.
+    streamed_lh5 = f"{output_stem}-streamed.lh5"
+    streamed_files = remage_run(
+        f"macros/{macro.replace('-memory', '')}.mac",
+        macro_substitutions={"events": n_events},
+        gdml_files="gdml/geometry.gdml",
+        output=streamed_lh5,
+        flat_output=True,
+        log_level="summary",
+        **extra_args,
+    )[1].get("output")
+    cols = ["xloc", "yloc", "zloc"]
+    streamed_pos = lh5.read_as("vtx", streamed_files, "pd")[cols].sort_values("xloc")
+    memory_pos = lh5.read_as("vtx", files, "pd")[cols].sort_values("xloc")
+    assert np.array_equal(streamed_pos.to_numpy(), memory_pos.to_numpy())
+
 if "kin" in macro:
     kin_input_file = kin_input_file.replace(".hdf5", ".lh5")
     input_kin = lh5.read_as("vtx/kin", kin_input_file, "ak")